@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <arblang/resolver/resolved_expressions.hpp>
@@ -8,9 +9,12 @@
 namespace al {
 namespace resolved_ir {
 
+// The values of the let-bindings visited so far.
+struct cse_map;
+
 std::pair<resolved_mechanism, bool> cse(const resolved_mechanism&);
 std::pair<r_expr, bool> cse(const r_expr&,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites);
 std::pair<r_expr, bool> cse(const r_expr&);
 
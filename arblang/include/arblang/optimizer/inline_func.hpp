@@ -8,7 +8,9 @@
 namespace al {
 namespace resolved_ir {
 
-resolved_mechanism inline_func(const resolved_mechanism&);
+// Calls to the `tabulated` functions are not inlined: they are the only
+// calls that remain in the mechanism, which later passes rely on.
+resolved_mechanism inline_func(const resolved_mechanism&, const std::unordered_set<std::string>& tabulated = {});
 r_expr inline_func(const r_expr&,
                    std::unordered_set<std::string>& temps,
                    std::unordered_map<std::string, r_expr>& rewrites,
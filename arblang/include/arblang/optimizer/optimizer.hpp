@@ -2,12 +2,14 @@
 
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include <unordered_set>
 
 #include <arblang/optimizer/constant_fold.hpp>
 #include <arblang/optimizer/copy_propagate.hpp>
 #include <arblang/optimizer/cse.hpp>
 #include <arblang/optimizer/eliminate_dead_code.hpp>
+#include <arblang/optimizer/ssa_block.hpp>
 
 namespace al {
 namespace resolved_ir {
@@ -24,7 +26,8 @@ public:
     Expr optimize() {
         while (keep_optimizing_) {
             keep_optimizing_ = false;
-            auto result = cse(expression_);
+            // cse, copy propagation and dead code elimination of the let-chains.
+            auto result = optimize_let_chains(expression_);
             expression_ = result.first;
             keep_optimizing_ |= result.second;
 
@@ -38,18 +41,14 @@ public:
 //            std::cout << "--------------1------------" << std::endl;
 //            std::cout << to_string(expression_) << std::endl << std::endl;
 
-            result = copy_propagate(expression_);
-            expression_ = result.first;
-            keep_optimizing_ |= result.second;
+            if constexpr (std::is_same_v<Expr, resolved_mechanism>) {
+                // Removes the unused parameters, constants, states and bindings.
+                result = eliminate_dead_code(expression_);
+                expression_ = result.first;
+                keep_optimizing_ |= result.second;
+            }
 
 //            std::cout << "--------------2------------" << std::endl;
-//            std::cout << to_string(expression_) << std::endl << std::endl;
-
-            result = eliminate_dead_code(expression_);
-            expression_ = result.first;
-            keep_optimizing_ |= result.second;
-
-//            std::cout << "--------------3------------" << std::endl;
 //            std::cout << to_string(expression_) << std::endl << std::endl;
         }
         return expression_;
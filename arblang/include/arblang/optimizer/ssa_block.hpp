@@ -0,0 +1,88 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Flat form of a single-assigned let-chain, used by the optimizer.
+// Every node of the let-bound values and of the body of the chain is an
+// instruction; the instructions are stored as a struct of arrays, in an order
+// in which operands precede their users. Operands are instruction indices, so
+// the definition of a variable is found without a lookup and its uses can be
+// counted in one linear scan.
+// Instructions bound by the let-chain are named. Unnamed instructions are
+// sub-expressions of a single user, except for leaves and objects which may
+// be shared after copy propagation.
+enum class ssa_op {
+    leaf,           // argument, number or variable not bound by the chain
+    copy,           // a variable bound by the chain: `let a = b;`
+    unary,
+    binary,
+    call,
+    conditional,
+    field_access,
+    object,
+};
+
+struct ssa_block {
+    static constexpr unsigned npos = -1;
+
+    // One entry per instruction.
+    std::vector<ssa_op> op;
+    std::vector<int> op_kind;                 // unary_op or binary_op
+    std::vector<unsigned> first_operand;      // index in `operands`
+    std::vector<unsigned> num_operands;
+    std::vector<unsigned> payload;            // index in `leaves`, `strings` or `field_names`
+    std::vector<unsigned> type_id;            // index in `types`
+    std::vector<unsigned> name;               // index in `names`, or npos for unnamed instructions
+    std::vector<unsigned> forward;            // the instruction replacing this one
+    std::vector<src_location> loc;
+
+    std::vector<unsigned> operands;
+    std::vector<r_expr> leaves;
+    std::vector<std::string> strings;         // function identifiers and field names, interned
+    std::vector<unsigned> field_names;        // the fields of objects, indices in `strings`
+    std::vector<r_type> types;                // interned
+
+    // The let-bindings of the chain, in order.
+    std::vector<std::string> names;
+    std::vector<unsigned> bindings;           // named instructions
+    std::vector<unsigned> let_type_id;        // type of the let-expressions
+
+    unsigned result = npos;                   // the body of the chain
+
+    std::size_t size() const { return op.size(); }
+
+    // Follow the replacements of instruction i.
+    unsigned find(unsigned i) const;
+
+    // The operands of instruction i, after replacement.
+    std::vector<unsigned> operands_of(unsigned i) const;
+};
+
+// Lower a let-chain to the flat form. Returns nothing if any value contains
+// a nested let-expression or an expression that isn't expected in a let-chain.
+std::optional<ssa_block> lower_to_ssa(const r_expr&);
+
+// Rebuild the let-chain from the live bindings of the block.
+r_expr raise_from_ssa(const ssa_block&);
+
+// The optimizations of cse.cpp, copy_propagate.cpp and eliminate_dead_code.cpp
+// performed on the flat form. Return whether a change was made.
+bool cse(ssa_block&);
+bool copy_propagate(ssa_block&);
+bool eliminate_dead_code(ssa_block&);
+
+// Apply cse, copy propagation and dead code elimination to every let-chain
+// until no more changes can be made. Let-chains that can't be lowered to the
+// flat form are optimized using the tree-based passes.
+std::pair<resolved_mechanism, bool> optimize_let_chains(const resolved_mechanism&);
+std::pair<r_expr, bool> optimize_let_chains(const r_expr&);
+
+} // namespace resolved_ir
+} // namespace al
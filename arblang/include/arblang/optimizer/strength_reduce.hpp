@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+std::pair<r_expr, bool> strength_reduce(const r_expr&, std::unordered_set<std::string>& reserved);
+std::pair<r_expr, bool> strength_reduce(const r_expr&);
+
+} // namespace resolved_ir
+} // namespace al
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Range of the argument of a tabulated function, in SI units,
+// and the number of intervals of the table.
+struct table_spec {
+    double lo;
+    double hi;
+    unsigned intervals;
+};
+
+// A function of a single argument, evaluated once on the grid of its
+// table_spec. Calls to the function are replaced by a linear interpolation
+// in the table, or by the evaluation of the body outside of the range.
+struct resolved_table {
+    std::string name;
+    r_expr argument;
+    r_expr body;
+    table_spec spec;
+};
+
+// Name of the generated lookup function of a tabulated function.
+inline std::string table_name(const std::string& function) {
+    return "_table_" + function;
+}
+
+// Collect the tables of a mechanism, before function inlining.
+// Only functions of a single quantity argument, returning a quantity, and
+// depending on nothing but their argument and constants can be tabulated.
+std::vector<resolved_table> tabulate(const resolved_mechanism&, const std::unordered_map<std::string, table_spec>&);
+
+} // namespace resolved_ir
+} // namespace al
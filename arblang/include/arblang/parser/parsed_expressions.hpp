@@ -10,6 +10,7 @@
 #include <arblang/parser/token.hpp>
 #include <arblang/parser/parsed_types.hpp>
 #include <arblang/parser/parsed_units.hpp>
+#include <arblang/util/arena.hpp>
 #include <arblang/util/common.hpp>
 
 namespace al {
@@ -76,6 +77,7 @@ struct parsed_mechanism {
     std::vector<p_expr> bindings;       // expect parsed_bind
     std::vector<p_expr> initializations; // expect parsed_initial
     std::vector<p_expr> on_events;      // expect parsed_on_event
+    std::vector<p_expr> post_events;    // expect parsed_on_event
     std::vector<p_expr> effects;        // expect effects_expr
     std::vector<p_expr> evolutions;     // expect parsed_evolve
     std::vector<p_expr> exports;        // expect parsed_export
@@ -333,9 +335,33 @@ std::optional<parsed_int> is_parsed_int(const p_expr&);
 std::optional<parsed_unary> is_parsed_unary(const p_expr&);
 std::optional<parsed_binary> is_parsed_binary(const p_expr&);
 
+// As above, without copying the node: a pointer to the node held by the
+// argument, or nullptr. The pointer is valid as long as the node is alive.
+const parsed_parameter* as_parsed_parameter(const p_expr&);
+const parsed_constant* as_parsed_constant(const p_expr&);
+const parsed_state* as_parsed_state(const p_expr&);
+const parsed_record_alias* as_parsed_record_alias(const p_expr&);
+const parsed_function* as_parsed_function(const p_expr&);
+const parsed_bind* as_parsed_bind(const p_expr&);
+const parsed_initial* as_parsed_initial(const p_expr&);
+const parsed_evolve* as_parsed_evolve(const p_expr&);
+const parsed_effect* as_parsed_effect(const p_expr&);
+const parsed_on_event* as_parsed_on_event(const p_expr&);
+const parsed_export* as_parsed_export(const p_expr&);
+const parsed_call* as_parsed_call(const p_expr&);
+const parsed_object* as_parsed_object(const p_expr&);
+const parsed_let* as_parsed_let(const p_expr&);
+const parsed_with* as_parsed_with(const p_expr&);
+const parsed_conditional* as_parsed_conditional(const p_expr&);
+const parsed_identifier* as_parsed_identifier(const p_expr&);
+const parsed_float* as_parsed_float(const p_expr&);
+const parsed_int* as_parsed_int(const p_expr&);
+const parsed_unary* as_parsed_unary(const p_expr&);
+const parsed_binary* as_parsed_binary(const p_expr&);
+
 template <typename T, typename... Args>
 p_expr make_pexpr(Args&&... args) {
-    return p_expr(new parsed_expr(T(std::forward<Args>(args)...)));
+    return make_node<parsed_expr, T>(std::forward<Args>(args)...);
 }
 
 } // namespace parsed_ir
@@ -8,6 +8,7 @@
 #include <vector>
 
 #include <arblang/parser/token.hpp>
+#include <arblang/util/arena.hpp>
 #include <arblang/util/common.hpp>
 #include <arblang/util/visitor.hpp>
 
@@ -128,7 +129,7 @@ std::optional<parsed_record_alias_type> is_parsed_record_alias_type(const p_type
 
 template <typename T, typename... Args>
 p_type make_ptype(Args&&... args) {
-    return p_type(new type_expr(T(std::forward<Args>(args)...)));
+    return make_node<type_expr, T>(std::forward<Args>(args)...);
 }
 } // namespace parsed_type_ir
 } // namespace al
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include <arblang/parser/token.hpp>
 #include <arblang/parser/parsed_types.hpp>
+#include <arblang/util/arena.hpp>
 #include <arblang/util/visitor.hpp>
 
 namespace al {
@@ -129,7 +130,7 @@ std::optional<parsed_no_unit> is_parsed_no_unit(const p_unit&);
 
 template <typename T, typename... Args>
 p_unit make_punit(Args&&... args) {
-    return p_unit(new parsed_unit(T(std::forward<Args>(args)...)));
+    return make_node<parsed_unit, T>(std::forward<Args>(args)...);
 }
 
 } // namespace parsed_unit_ir
@@ -14,6 +14,16 @@ using namespace parsed_ir;
 using namespace parsed_type_ir;
 using namespace parsed_unit_ir;
 
+// A reaction `lhs -> rhs (rate)` between complexes of species.
+struct parsed_reaction {
+    using complex = std::vector<std::pair<std::string, int>>; // species and their multiplicity
+
+    complex lhs;
+    complex rhs;
+    p_expr rate;
+    src_location loc;
+};
+
 class parser: lexer {
 public:
     parser(std::string const&);
@@ -38,6 +48,8 @@ public:
     p_expr parse_typed_identifier();
     p_expr parse_call();
     p_expr parse_object();
+    std::vector<parsed_reaction> parse_reaction();
+    parsed_reaction::complex parse_complex();
     p_expr parse_let();
     p_expr parse_with();
     p_expr parse_conditional();
@@ -62,6 +74,11 @@ public:
 
 private:
     std::pair<p_expr, p_expr> parse_assignment();
+    p_expr lower_reactions(std::optional<std::string> record_name,
+                           std::vector<p_expr> fields,
+                           std::vector<p_expr> values,
+                           const std::vector<parsed_reaction>& reactions,
+                           const src_location& loc);
 
     std::vector<parsed_mechanism> mechanisms_;
 };
@@ -36,8 +36,8 @@ enum class tok {
     equality,// ==
     ne,      // !=
 
-    // <->
-    arrow,
+    // <-> <- \0
+    arrow, left_arrow, empty_set,
 
     // ; : , .
     semicolon, colon, comma, dot,
@@ -80,7 +80,7 @@ enum class tok {
     parameter, constant, state,
     record, function, import,
     with, let, as, ret,
-    effect, evolve, initial, on_event,
+    effect, evolve, initial, on_event, on_post,
     bind, param_export, density,
 
     // quantity keywords
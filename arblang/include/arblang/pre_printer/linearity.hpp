@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// How a value depends on a set of variables (the states and event weights of a mechanism).
+// Ordered such that combining two values yields at least the maximum of both.
+enum class linearity {
+    constant,  // Independent of the variables.
+    linear,    // Linear and homogeneous in the variables: a sum of variables scaled by constants.
+    nonlinear, // Anything else, including affine values.
+};
+
+using linearity_map = std::unordered_map<std::string, linearity>;
+
+// Classify the value of a procedure. `vars` holds the linearity of the
+// resolved_arguments read by the procedure (unknown arguments are assumed
+// to be constant) and receives the linearity of every let-binding.
+linearity classify_linearity(const r_expr&, linearity_map& vars);
+
+} // namespace resolved_ir
+} // namespace al
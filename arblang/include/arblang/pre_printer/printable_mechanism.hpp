@@ -3,6 +3,7 @@
 #include <unordered_set>
 #include <unordered_map>
 
+#include <arblang/optimizer/tabulate.hpp>
 #include <arblang/resolver/resolved_expressions.hpp>
 
 namespace al {
@@ -11,7 +12,12 @@ namespace resolved_ir {
 using record_field_map = std::unordered_map<std::string, std::unordered_map<std::string, std::string>>;
 
 struct printable_mechanism {
-    printable_mechanism(const resolved_mechanism& m, std::string i_name, std::string g_name);
+    printable_mechanism(const resolved_mechanism& m,
+                        std::string i_name,
+                        std::string g_name,
+                        const std::unordered_set<std::string>& uniform = {},
+                        const std::unordered_set<std::string>& global = {},
+                        const std::vector<resolved_table>& tables = {});
 
     std::string mech_name;
     mechanism_kind mech_kind;
@@ -20,16 +26,41 @@ struct printable_mechanism {
         std::vector<r_expr> assigned_parameters;
         std::vector<r_expr> initializations;
         std::vector<r_expr> on_events;
+        std::vector<r_expr> post_events;
         std::vector<r_expr> effects;
         std::vector<r_expr> evolutions;
     } procedure_pack;
 
+    // Let-bindings that have the same value for all instances, hoisted out of
+    // the procedures of each kernel. Evaluated once per kernel call.
+    struct mechanism_prologues {
+        std::vector<r_expr> init;
+        std::vector<r_expr> on_events;
+        std::vector<r_expr> post_events;
+        std::vector<r_expr> effects;
+        std::vector<r_expr> evolutions;
+    } prologue_pack;
+
+    // Tabulated functions, with their bodies prepared for printing.
+    std::vector<resolved_table> tables;
+
+    // Parameters and bindables that are known to have the same value for all
+    // instances. They are read once per kernel call.
+    std::unordered_set<std::string> uniform_sources;
+
+    // Whether the evolutions, on_events, post_events and effects of the mechanism are linear
+    // and homogeneous in the states and event weights. The simulator can then
+    // coalesce instances of the mechanism with identical parameters.
+    bool is_linear;
+
     // Used to assign storage for parameters and state vars,
     // and to create named pointers to the storage of parameters,
     // state vars, bindables and affectables.
     struct mechanism_fields {
-        std::vector<std::tuple<std::string, double, std::string>> param_sources; // param name to val and unit
+        std::vector<std::tuple<std::string, double, std::string>> param_sources;  // param name to val and unit
+        std::vector<std::tuple<std::string, double, std::string>> global_sources; // global param name to val and unit
         std::vector<std::string> state_sources;
+        std::vector<std::string> cache_sources; // values stored by advance_state for compute_currents, internal state vars
         std::vector<std::tuple<std::string, bindable, std::optional<std::string>>> bind_sources;
         std::vector<std::tuple<std::string, affectable, std::optional<std::string>>> effect_sources;
     } field_pack;
@@ -47,7 +78,8 @@ struct printable_mechanism {
         internal,      // param, state
         external,      // indexed by node_index
         ionic,         // indexed by ionic node_index
-        stream_member, // A member of an event stream (weight)
+        stream_member, // A member of an event stream (weight), or the time since a spike of a post event
+        global,        // global param, one value for all instances
     };
     struct storage_info {
         std::string pointer_name;
@@ -80,6 +112,9 @@ struct printable_mechanism {
     read_map  event_read_map;
     write_map event_write_map;
 
+    read_map  post_read_map;
+    write_map post_write_map;
+
     read_map  effect_read_map;
     write_map effect_write_map;
 
@@ -104,6 +139,9 @@ private:
     void fill_write_maps(const std::unordered_map<std::string, std::unordered_map<std::string, std::string>>&,
                          const write_map&);
     void fill_read_maps();
+    bool check_linearity() const;
+    void cache_shared_values(const std::unordered_set<std::string>& uniform, write_map& writable_variables);
+    void hoist_uniform_values();
 };
 
 } // namespace resolved_ir
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+#include <arblang/util/hash_cons.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Value numbering of the let-bindings of the top-level let-chains of procedures.
+// Bindings of different procedures get the same number if they compute the same
+// value from the same resolved_arguments, regardless of the names of the
+// intermediate variables. Bindings of objects or nested lets are not numbered.
+class value_numbering {
+public:
+    using id = hash_cons::id;
+
+    // Number the bindings of the top-level let-chain of `e`, the value of a procedure.
+    // Returns a map from binding name to value number.
+    std::unordered_map<std::string, id> number(const r_expr& e);
+
+    // The resolved_arguments value `n` depends on.
+    const std::set<std::string>& reads(id n) const { return reads_.at(n); }
+
+private:
+    std::set<std::string> reads_of(const r_expr& e) const;
+
+    hash_cons values_;
+    std::unordered_map<std::string, id> bound_;
+    std::unordered_map<id, std::set<std::string>> reads_;
+};
+
+// Estimated cost of evaluating an expression, relative to an addition.
+unsigned estimated_cost(const r_expr& e);
+
+// Replace the values of the named bindings of the top-level let-chain of `e`.
+r_expr replace_let_values(const r_expr& e, const std::unordered_map<std::string, r_expr>& values);
+
+// Extract the bindings of the top-level let-chain of `e` needed to compute the
+// binding `name`, renamed using `prefix`. The result is a let-chain with the
+// value of `name` as its body.
+r_expr extract_let_chain(const r_expr& e, const std::string& name, const std::string& prefix);
+
+} // namespace resolved_ir
+} // namespace al
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// How a value varies across the instances of a mechanism.
+// Ordered such that combining two values yields the maximum of both.
+enum class variability {
+    uniform,      // Identical for all instances: parameters/bindables annotated as uniform, constants.
+    per_node,     // Depends on values indexed by the node index of the instance: bindables.
+    per_instance, // Depends on values stored per instance: states, parameters, event weights.
+};
+
+using variability_map = std::unordered_map<std::string, variability>;
+
+// Classify the let-bound variables of a procedure. `vars` holds the variability
+// of the resolved_arguments read by the procedure (unknown arguments are assumed
+// to be per_instance) and receives the variability of every let-binding.
+variability classify_variability(const r_expr&, variability_map& vars);
+
+// Remove the uniform let-bindings from a procedure, after classification.
+// The removed bindings are appended to `hoisted` in order of definition, and
+// can be evaluated once ahead of the loop over the instances.
+r_expr hoist_uniform(const r_expr&, const variability_map& vars, std::vector<r_expr>& hoisted);
+
+} // namespace resolved_ir
+} // namespace al
@@ -3,12 +3,16 @@
 #include <string>
 #include <sstream>
 
+#include <arblang/printer/printer_options.hpp>
 #include <arblang/resolver/resolved_expressions.hpp>
 
 namespace al {
 namespace resolved_ir {
 
-void print_expression(const r_expr&, std::stringstream&, const std::string& indent="");
+// The C++ literal of a double, read back as the same value.
+std::string double_literal(double);
+
+void print_expression(const r_expr&, std::stringstream&, const std::string& indent="", const printer_options& opt={});
 
 } // namespace resolved_ir
 } // namespace al
\ No newline at end of file
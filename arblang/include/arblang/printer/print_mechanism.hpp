@@ -2,11 +2,12 @@
 #include <sstream>
 
 #include <arblang/pre_printer/printable_mechanism.hpp>
+#include <arblang/printer/printer_options.hpp>
 
 namespace al {
 namespace resolved_ir {
 
-std::stringstream print_mechanism(const printable_mechanism& mech, const std::string& cpp_namespace);
+std::stringstream print_mechanism(const printable_mechanism& mech, const std::string& cpp_namespace, const printer_options& opt = {});
 
 } // namespace resolved_ir
 } // namespace al
\ No newline at end of file
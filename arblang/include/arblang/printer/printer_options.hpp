@@ -0,0 +1,42 @@
+#pragma once
+
+namespace al {
+namespace resolved_ir {
+
+// Options controlling the flavour of the generated C++ code.
+struct printer_options {
+    // Generate explicitly vectorized kernels written against arbor's SIMD
+    // library. Kernels accessing node-indexed values have a loop specialized
+    // for each class of arbor's index constraint partition (contiguous,
+    // constant, independent, none), over the padded width of the mechanism.
+    // The other kernels handle `simd_width_` instances at a time, with a
+    // scalar loop over the remaining instances.
+    bool simd = false;
+
+    // Distance, in instances, at which scalar loops prefetch the node-indexed
+    // data of a later instance. No prefetches are emitted if zero.
+    unsigned prefetch_distance = 0;
+
+    // Sum the contributions of the scalar kernels of point mechanisms to
+    // node-indexed values per run of instances on the same node, and write
+    // each sum once. Saves memory updates when many instances share a node,
+    // at the cost of a compare and branch per instance. The SIMD kernels
+    // already reduce batches of instances on a single node.
+    bool segmented_writes = false;
+
+    // Annotate the scalar kernels for the auto-vectorizer of the host compiler:
+    // the parameter and state arrays are declared `__restrict__` and aligned,
+    // and loops with independent iterations are marked `#pragma omp simd`.
+    bool vectorize_hints = false;
+
+    // Replace the libm `exp` and `log` and arbor's `exprelr` in the scalar
+    // kernels by inline, branch-free approximations that the host compiler
+    // can vectorize (GCC needs -fno-trapping-math to if-convert the selects).
+    // Errors measured against a long double reference are below 1.2 ulp for
+    // exp, 0.9 ulp for log and 2.4 ulp for exprelr. The SIMD kernels keep
+    // using arbor's SIMD library.
+    bool fast_math = false;
+};
+
+} // namespace resolved_ir
+} // namespace al
@@ -10,6 +10,7 @@
 #include <arblang/parser/token.hpp>
 #include <arblang/parser/parsed_expressions.hpp>
 #include <arblang/resolver/resolved_types.hpp>
+#include <arblang/util/arena.hpp>
 #include <arblang/util/common.hpp>
 
 namespace al {
@@ -79,6 +80,7 @@ struct resolved_mechanism {
     std::vector<r_expr> bindings;       // expect resolved_bind
     std::vector<r_expr> initializations; // expect resolved_initial
     std::vector<r_expr> on_events;      // expect resolved_on_events
+    std::vector<r_expr> post_events;    // expect resolved_on_events
     std::vector<r_expr> effects;        // expect effects_expr
     std::vector<r_expr> evolutions;     // expect resolved_evolve
     std::vector<r_expr> exports;        // expect resolved_export
@@ -405,9 +407,34 @@ std::optional<resolved_int> is_resolved_int(const r_expr&);
 std::optional<resolved_unary> is_resolved_unary(const r_expr&);
 std::optional<resolved_binary> is_resolved_binary(const r_expr&);
 
+// As above, without copying the node: a pointer to the node held by the
+// argument, or nullptr. The pointer is valid as long as the node is alive.
+const resolved_argument* as_resolved_argument(const r_expr&);
+const resolved_variable* as_resolved_variable(const r_expr&);
+const resolved_field_access* as_resolved_field_access(const r_expr&);
+const resolved_parameter* as_resolved_parameter(const r_expr&);
+const resolved_constant* as_resolved_constant(const r_expr&);
+const resolved_state* as_resolved_state(const r_expr&);
+const resolved_record_alias* as_resolved_record_alias(const r_expr&);
+const resolved_function* as_resolved_function(const r_expr&);
+const resolved_bind* as_resolved_bind(const r_expr&);
+const resolved_initial* as_resolved_initial(const r_expr&);
+const resolved_on_event* as_resolved_on_event(const r_expr&);
+const resolved_evolve* as_resolved_evolve(const r_expr&);
+const resolved_effect* as_resolved_effect(const r_expr&);
+const resolved_export* as_resolved_export(const r_expr&);
+const resolved_call* as_resolved_call(const r_expr&);
+const resolved_object* as_resolved_object(const r_expr&);
+const resolved_let* as_resolved_let(const r_expr&);
+const resolved_conditional* as_resolved_conditional(const r_expr&);
+const resolved_float* as_resolved_float(const r_expr&);
+const resolved_int* as_resolved_int(const r_expr&);
+const resolved_unary* as_resolved_unary(const r_expr&);
+const resolved_binary* as_resolved_binary(const r_expr&);
+
 template <typename T, typename... Args>
 r_expr make_rexpr(Args&&... args) {
-    return r_expr(new resolved_expr(T(std::forward<Args>(args)...)));
+    return make_node<resolved_expr, T>(std::forward<Args>(args)...);
 }
 
 } // namespace parsed_ir
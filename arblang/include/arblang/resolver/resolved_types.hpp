@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <unordered_map>
 
 #include <arblang/parser/parsed_types.hpp>
+#include <arblang/util/arena.hpp>
 
 namespace al {
 namespace resolved_type_ir {
@@ -62,7 +64,7 @@ struct resolved_record {
 
 template <typename T, typename... Args>
 r_type make_rtype(Args&&... args) {
-    return r_type(new resolved_type(T(std::forward<Args>(args)...)));
+    return make_node<resolved_type, T>(std::forward<Args>(args)...);
 }
 
 r_type resolve_type(const bindable& b, const src_location& loc = {});
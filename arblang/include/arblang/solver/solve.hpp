@@ -1,11 +1,19 @@
 #pragma once
 
 #include <arblang/resolver/resolved_expressions.hpp>
+#include <arblang/solver/solve_ode.hpp>
 
 namespace al {
 namespace resolved_ir {
 
-resolved_mechanism solve(const resolved_mechanism& e, const std::string& i_name, const std::string& g_name);
+// Throws if the options name a state, or a field of a record state, that the
+// mechanism doesn't have, or ask for no Newton iterations.
+void check_solver_options(const resolved_mechanism& e, const solver_options& opt);
+
+resolved_mechanism solve(const resolved_mechanism& e,
+                         const std::string& i_name,
+                         const std::string& g_name,
+                         const solver_options& opt = {});
 
 } // namespace resolved_ir
 } // namespace al
\ No newline at end of file
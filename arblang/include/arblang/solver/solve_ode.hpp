@@ -1,16 +1,41 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 
 #include <arblang/resolver/resolved_expressions.hpp>
+#include <arblang/solver/sparse_elimination.hpp>
 
 namespace al {
 namespace resolved_ir {
 
-// Very basic solver for ODEs or systems of ODEs that are diagonal linear.
-// This is not necessarily true nor is it checked that this is true.
+// Integration schemes for x' = a*x + b, over a time step dt.
+enum class ode_scheme {
+    cnexp,          // Exact exponential:  x = -b/a + (x + b/a)*exp(a*dt)
+    pade_11,        // As cnexp, with the (1,1) Pade approximant of exp(a*dt)
+    pade_22,        // As cnexp, with the (2,2) Pade approximant of exp(a*dt)
+    euler,          // Forward Euler:      x = x + (a*x + b)*dt
+    backward_euler, // Backward Euler:     x = (x + b*dt)/(1 - a*dt)
+};
+
+std::string to_string(ode_scheme);
+std::optional<ode_scheme> parse_ode_scheme(const std::string&);
+
+struct solver_options {
+    ode_scheme scheme = ode_scheme::pade_11;                 // Default scheme of the mechanism.
+    std::unordered_map<std::string, ode_scheme> state_schemes; // Overrides, per `state` or `state.field`.
+    unsigned newton_iterations = 3;                          // Newton iterations for non-linear ODEs.
+
+    // The scheme used for `state`, or the field `field` of a record `state`.
+    ode_scheme scheme_of(const std::string& state, const std::string& field = {}) const;
+};
+
+// Very basic solver for ODEs or systems of ODEs.
+// Diagonal linear systems are solved per field; coupled linear systems are
+// solved implicitly, as a sparse linear system; non-linear systems are solved
+// implicitly with Newton's method.
 // Only works on resolved_evolve.
 // Not very well written.
 class solver {
@@ -25,12 +50,48 @@ private:
     r_expr state_deriv;      // state derivative
     r_expr state_deriv_body; // innermost body of state_deriv
 
+    solver_options opt;      // integration schemes
+
+    std::unordered_set<std::string>& temps; // names of temporaries, shared by the ODEs of a mechanism
+
+    // x' = rate*(x - x_inf), with rate*dt = time_scale
+    struct relaxation {
+        r_expr x_inf;
+        r_expr time_scale;
+    };
+
+    // The fields of the state, their derivatives and the Jacobian.
+    struct ode_fields {
+        std::vector<std::string> names;
+        std::vector<r_type> types;
+        std::vector<r_expr> values;
+        std::vector<std::vector<r_expr>> jacobian; // nullptr where zero
+        bool coupled = false;
+        bool linear = true;
+    };
+
+    std::unordered_map<std::string, bool> depends_memo;
+
     r_expr make_zero_state();
+    bool depends_on_state(const r_expr&, const std::string& field = {});
+    bool depends_on_state(const r_expr&, const std::string& field, std::unordered_map<std::string, bool>& memo);
+    bool is_state(const r_expr&, const std::string& field);
+    std::optional<relaxation> match_relaxation(const r_expr& deriv, const std::string& field);
+    r_expr generate_relaxation(const relaxation&, const r_expr& x, ode_scheme);
+    ode_fields state_fields();
+    void differentiate(ode_fields&);
+    r_expr field_of(const ode_fields&, const r_expr& state, unsigned i);
+    r_expr make_state(const ode_fields&, const std::vector<r_expr>& values);
+    ode_scheme uniform_scheme(const ode_fields&, const std::string& kind);
+    r_expr implicit_step(ode_scheme, const std::string& kind);
+    sparse_system implicit_matrix(const ode_fields&, const std::vector<std::vector<r_expr>>& jacobian, const r_expr& h);
+    r_expr solve_coupled(const ode_fields&);
+    r_expr solve_newton(const ode_fields&);
 public:
-    solver(const resolved_evolve& e);
+    solver(const resolved_evolve& e, std::unordered_set<std::string>& temps, const solver_options& opt = {});
     r_expr get_b();
     r_expr get_a();
-    r_expr generate_solution(const r_expr& a, const r_expr& b, const r_expr&);
+    r_expr generate_solution(const r_expr& a, const r_expr& b, const r_expr&, ode_scheme);
     resolved_evolve solve();
 };
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Linear system A*x = b with symbolic coefficients.
+// A is stored by rows; missing entries are zero.
+struct sparse_system {
+    std::vector<std::map<unsigned, r_expr>> A;
+    std::vector<r_expr> b;
+
+    unsigned size() const { return b.size(); }
+};
+
+// Fill-reducing elimination order: greedy minimum degree on the
+// symmetrized sparsity pattern of A.
+std::vector<unsigned> min_degree_order(const sparse_system&);
+
+// Solve the system by Gaussian elimination without pivoting, eliminating the
+// unknowns in the given order. Every intermediate value is bound to a new
+// resolved_variable with a unique name using `prefix`; these are appended
+// to `defs` in order of definition. Returns the solution, indexed like b.
+std::vector<r_expr> gaussian_elimination(sparse_system,
+                                         const std::vector<unsigned>& order,
+                                         std::unordered_set<std::string>& reserved,
+                                         const std::string& prefix,
+                                         std::vector<r_expr>& defs);
+
+// Wrap `body` in let statements binding `defs`, in order.
+r_expr let_wrap(const std::vector<r_expr>& defs, const r_expr& body);
+
+} // namespace resolved_ir
+} // namespace al
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace al {
+
+// Allocation of the nodes of the parsed and resolved IRs.
+// Nodes are allocated together with their shared_ptr control blocks, by bumping
+// a pointer in 64 KiB chunks owned by the allocating thread. Freeing a node only
+// decrements the count of live nodes of its chunk; the chunk is returned to the
+// system in bulk once all its nodes are freed, which happens when the results of
+// the passes that allocated them are released.
+// Nodes may outlive the thread that allocated them, and be freed by another.
+
+struct allocation_count {
+    std::size_t nodes = 0;
+    std::size_t bytes = 0;
+};
+
+allocation_count operator-(const allocation_count& lhs, const allocation_count& rhs);
+std::string to_string(const allocation_count&);
+
+// The nodes and bytes allocated by the current thread so far.
+allocation_count ir_allocations();
+
+// Counts the allocations of the current thread since its construction, e.g. during a pass.
+class allocation_counter {
+public:
+    allocation_counter(): start_(ir_allocations()) {}
+    allocation_count count() const { return ir_allocations() - start_; }
+    void reset() { start_ = ir_allocations(); }
+
+private:
+    allocation_count start_;
+};
+
+void* arena_allocate(std::size_t bytes, std::size_t align);
+void arena_deallocate(void* p, std::size_t bytes, std::size_t align) noexcept;
+
+template <typename T>
+struct arena_allocator {
+    using value_type = T;
+
+    arena_allocator() = default;
+    template <typename U>
+    arena_allocator(const arena_allocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena_allocate(n*sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        arena_deallocate(p, n*sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const arena_allocator<U>&) const { return false; }
+};
+
+// Allocate a node of variant type `Node` holding a `T` constructed from `args`.
+template <typename Node, typename T, typename... Args>
+std::shared_ptr<Node> make_node(Args&&... args) {
+    return std::allocate_shared<Node>(arena_allocator<Node>(), T(std::forward<Args>(args)...));
+}
+
+} // namespace al
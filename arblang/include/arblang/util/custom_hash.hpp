@@ -58,10 +58,11 @@ struct hash<resolved_argument> {
 
 template <>
 struct hash<resolved_variable> {
+    // Bindings are uniquely named after canonicalization, so the name identifies the
+    // value. Hashing the value as well revisits shared sub-expressions once per path.
     inline size_t operator()(const resolved_variable& e) const {
         std::size_t res = 0;
         hash_combine(res, e.name);
-        hash_combine(res, *e.value);
         hash_combine(res, *e.type);
         return res;
     }
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Hash-consing of resolved expressions: structurally identical expressions are
+// interned once and identified by a number. Comparing two interned expressions
+// is an integer compare, and the hash of a node is computed once, from the
+// numbers of its operands, rather than by walking its subtree.
+// A bound variable is interned as the value it is bound to (see `bind`). After
+// canonicalization and single assignment the operands of let-bound values are
+// variables, arguments and literals, so interning a value only visits its
+// immediate operands.
+class hash_cons {
+public:
+    using id = unsigned;
+
+    // Intern `e`. Let-expressions and objects are not interned.
+    std::optional<id> intern(const r_expr& e);
+
+    // Bind the variable `name` to the interned value `v`.
+    void bind(const std::string& name, id v) { bound_[name] = v; }
+
+    // Forget the variable bindings, but not the interned values.
+    void clear_bindings() { bound_.clear(); }
+
+    void clear() {
+        nodes_.clear();
+        bound_.clear();
+    }
+
+    std::size_t size() const { return nodes_.size(); }
+
+private:
+    struct node {
+        std::size_t kind;         // Index of the alternative in resolved_expr.
+        int op;                   // Operator of unary and binary expressions.
+        double value;             // Value of numbers.
+        std::string name;         // Name of arguments, free variables, called functions and fields.
+        r_type type;
+        std::vector<id> operands;
+        std::size_t hash;         // Computed once, at construction.
+
+        bool operator==(const node& other) const;
+    };
+    struct node_hash {
+        std::size_t operator()(const node& n) const { return n.hash; }
+    };
+
+    std::unordered_map<node, id, node_hash> nodes_;
+    std::unordered_map<std::string, id> bound_;
+};
+
+} // namespace resolved_ir
+} // namespace al
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Number of floating point operations needed to evaluate an expression, by kind.
+// Both branches of a conditional are counted, as they are in vectorized code.
+struct op_count {
+    unsigned add = 0;    // add, sub, neg, min, max, abs
+    unsigned mul = 0;    // mul
+    unsigned div = 0;    // div
+    unsigned fn  = 0;    // exp, log, cos, sin, exprelr, pow
+    unsigned cmp = 0;    // comparisons and logical operations
+
+    op_count& operator+=(const op_count&);
+};
+
+// Count the operations of a procedure after inlining, without duplicating
+// the operations of let-bound values at each of their uses.
+op_count count_ops(const r_expr&);
+
+std::string to_string(const op_count&);
+
+} // namespace resolved_ir
+} // namespace al
@@ -44,12 +44,16 @@ namespace resolved_ir {
 //
 // Constant folding needs to be performed in a loop,
 // until no more changes can be made.
+// Unchanged sub-expressions are returned as is, `self`, rather
+// than copied: only the parents of folded expressions are rebuilt,
+// so the iterations after the first one allocate little.
 
 bool is_integer(double v) {
     return std::floor(v) == v;
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_record_alias& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
@@ -58,100 +62,125 @@ std::pair<r_expr, bool> constant_fold(const resolved_record_alias& e,
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_argument& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     if (constant_map.count(e.name)) return {constant_map.at(e.name), true};
-    return {make_rexpr<resolved_argument>(e), false};
+    return {self, false};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_variable& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     if (constant_map.count(e.name)) return {constant_map.at(e.name), true};
-    if (rewrites.count(e.name)) return {rewrites.at(e.name), false};
-    return {make_rexpr<resolved_variable>(e), false};
+    if (rewrites.count(e.name)) {
+        // Keep the variable if the value it refers to is unchanged.
+        auto rewrite = rewrites.at(e.name);
+        if (std::get<resolved_variable>(*rewrite).value == e.value) return {self, false};
+        return {rewrite, false};
+    }
+    return {self, false};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_parameter& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto result = constant_fold(e.value, constant_map, rewrites);
+    if (result.first == e.value) return {self, false};
     return {make_rexpr<resolved_parameter>(e.name, result.first, e.type, e.loc), result.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_constant& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto result = constant_fold(e.value, constant_map, rewrites);
+    if (result.first == e.value) return {self, false};
     return {make_rexpr<resolved_constant>(e.name, result.first, e.type, e.loc), result.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_state& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
-    return {make_rexpr<resolved_state>(e), false};
+    return {self, false};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_function& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto result = constant_fold(e.body, constant_map, rewrites);
+    if (result.first == e.body) return {self, false};
     return {make_rexpr<resolved_function>(e.name, e.args, result.first, e.type, e.loc), result.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_bind& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
-    return {make_rexpr<resolved_bind>(e), false};
+    return {self, false};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_initial& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto result = constant_fold(e.value, constant_map, rewrites);
+    if (result.first == e.value) return {self, false};
     return {make_rexpr<resolved_initial>(e.identifier, result.first, e.type, e.loc), result.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_on_event& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto result = constant_fold(e.value, constant_map, rewrites);
+    if (result.first == e.value) return {self, false};
     return {make_rexpr<resolved_on_event>(e.argument, e.identifier, result.first, e.type, e.loc), result.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_evolve& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto result = constant_fold(e.value, constant_map, rewrites);
+    if (result.first == e.value) return {self, false};
     return {make_rexpr<resolved_evolve>(e.identifier, result.first, e.type, e.loc), result.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_effect& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto result = constant_fold(e.value, constant_map, rewrites);
+    if (result.first == e.value) return {self, false};
     return {make_rexpr<resolved_effect>(e.effect, e.ion, result.first, e.type, e.loc), result.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_export& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
-    return {make_rexpr<resolved_export>(e), false};
+    return {self, false};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_call& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
@@ -162,24 +191,29 @@ std::pair<r_expr, bool> constant_fold(const resolved_call& e,
         args.push_back(result.first);
         made_change |= result.second;
     }
+    if (args == e.call_args) return {self, false};
     return {make_rexpr<resolved_call>(e.f_identifier, args, e.type, e.loc), made_change};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_object& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
     std::vector<r_expr> values;
     bool made_change = false;
-    for (const auto& a: e.field_values()) {
+    auto field_values = e.field_values();
+    for (const auto& a: field_values) {
         auto result = constant_fold(a, constant_map, rewrites);
         values.push_back(result.first);
         made_change |= result.second;
     }
+    if (values == field_values) return {self, false};
     return {make_rexpr<resolved_object>(e.field_names(), values, e.type, e.loc), made_change};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_let& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
@@ -190,14 +224,18 @@ std::pair<r_expr, bool> constant_fold(const resolved_let& e,
 
     auto val = constant_fold(e.id_value(), constant_map, rewrites);
 
-    auto var_cst = make_rexpr<resolved_variable>(var_name, val.first, type_of(val.first), location_of(val.first));
+    auto var_cst = val.first == e.id_value()?
+        e.identifier:
+        make_rexpr<resolved_variable>(var_name, val.first, type_of(val.first), location_of(val.first));
     rewrites.insert({var_name, var_cst});
 
     auto body = constant_fold(e.body, constant_map, rewrites);
+    if (var_cst == e.identifier && body.first == e.body) return {self, false};
     return {make_rexpr<resolved_let>(var_cst, body.first, e.type, e.loc), val.second||body.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_conditional& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
@@ -211,25 +249,29 @@ std::pair<r_expr, bool> constant_fold(const resolved_conditional& e,
         }
         return {fval.first, true};
     }
+    if (cond.first == e.condition && tval.first == e.value_true && fval.first == e.value_false) return {self, false};
     return {make_rexpr<resolved_conditional>(cond.first, tval.first, fval.first, e.type, e.loc),
             cond.second||tval.second||fval.second};
 }
 
 std::pair<r_expr, bool>  constant_fold(const resolved_float& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
-    return {make_rexpr<resolved_float>(e), false};
+    return {self, false};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_int& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
-    return {make_rexpr<resolved_int>(e), false};
+    return {self, false};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_unary& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
@@ -259,10 +301,12 @@ std::pair<r_expr, bool> constant_fold(const resolved_unary& e,
         }
         return {make_rexpr<resolved_float>(val, e.type, e.loc), true};
     }
+    if (arg.first == e.arg) return {self, false};
     return {make_rexpr<resolved_unary>(e.op, arg.first, e.type, e.loc), arg.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_binary& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
@@ -399,10 +443,12 @@ std::pair<r_expr, bool> constant_fold(const resolved_binary& e,
             }
         }
     }
+    if (lhs_arg.first == e.lhs && rhs_arg.first == e.rhs) return {self, false};
     return {make_rexpr<resolved_binary>(e.op, lhs_arg.first, rhs_arg.first, e.type, e.loc), lhs_arg.second||rhs_arg.second};
 }
 
 std::pair<r_expr, bool> constant_fold(const resolved_field_access& e,
+                                      const r_expr& self,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
@@ -410,10 +456,10 @@ std::pair<r_expr, bool> constant_fold(const resolved_field_access& e,
     auto field = e.field;
 
     // TODO This shouldn't be in the constant fold pass
-    if (auto o_ptr = is_resolved_object(obj_arg.first)) {
+    if (auto o_ptr = as_resolved_object(obj_arg.first)) {
         int idx = -1;
         for (unsigned i = 0; i < o_ptr->record_fields.size(); ++i) {
-            if (is_resolved_variable(o_ptr->record_fields[i])->name == field) {
+            if (as_resolved_variable(o_ptr->record_fields[i])->name == field) {
                 idx = (int)i;
                 break;
             }
@@ -423,6 +469,7 @@ std::pair<r_expr, bool> constant_fold(const resolved_field_access& e,
         }
         return {o_ptr->field_values()[idx], true};
     }
+    if (obj_arg.first == e.object) return {self, false};
     return {make_rexpr<resolved_field_access>(obj_arg.first, field, e.type, e.loc), obj_arg.second};
 }
 
@@ -445,15 +492,15 @@ std::pair<resolved_mechanism, bool> constant_fold(const resolved_mechanism& e) {
 
         // Keep set of exported parameters.
         // Remaining un-exported parameters can be constant propagated.
-        auto param_id = is_resolved_export(c)->identifier;
-        exported_params.insert(is_resolved_argument(param_id)->name);
+        auto param_id = as_resolved_export(c)->identifier;
+        exported_params.insert(as_resolved_argument(param_id)->name);
     }
     for (const auto& c: e.constants) {
         reset_maps();
         auto result = constant_fold(c, local_constant_map, rewrites);
 
-        auto constant  = is_resolved_constant(result.first);
-        if (is_number(constant->value)) {
+        auto constant  = as_resolved_constant(result.first);
+        if (is_trivial(constant->value)) {
             constants_map.insert({constant->name, constant->value});
         } else {
             mech.constants.push_back(result.first);
@@ -464,8 +511,9 @@ std::pair<resolved_mechanism, bool> constant_fold(const resolved_mechanism& e) {
         reset_maps();
         auto result = constant_fold(c, local_constant_map, rewrites);
 
-        auto param  = is_resolved_parameter(result.first);
-        if (!exported_params.count(param->name) && is_number(param->value)) {
+        auto param  = as_resolved_parameter(result.first);
+        // Records are propagated whole: field accesses on them then fold to the field value.
+        if (!exported_params.count(param->name) && is_trivial(param->value)) {
             constants_map.insert({param->name, param->value});
         } else {
             mech.parameters.push_back(result.first);
@@ -502,6 +550,12 @@ std::pair<resolved_mechanism, bool> constant_fold(const resolved_mechanism& e) {
         mech.on_events.push_back(result.first);
         made_changes |= result.second;
     }
+    for (const auto& c: e.post_events) {
+        reset_maps();
+        auto result = constant_fold(c, local_constant_map, rewrites);
+        mech.post_events.push_back(result.first);
+        made_changes |= result.second;
+    }
     for (const auto& c: e.evolutions) {
         reset_maps();
         auto result = constant_fold(c, local_constant_map, rewrites);
@@ -524,7 +578,7 @@ std::pair<r_expr, bool> constant_fold(const r_expr& e,
                                       std::unordered_map<std::string, r_expr>& constant_map,
                                       std::unordered_map<std::string, r_expr>& rewrites)
 {
-    return std::visit([&](auto& c) {return constant_fold(c, constant_map, rewrites);}, *e);
+    return std::visit([&](auto& c) {return constant_fold(c, e, constant_map, rewrites);}, *e);
 }
 
 std::pair<r_expr, bool> constant_fold(const r_expr& e) {
@@ -152,7 +152,7 @@ std::pair<r_expr, bool> copy_propagate(const resolved_let& e,
                                        std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto id_val = e.id_value();
-    if (is_resolved_argument(id_val) || is_resolved_variable(id_val) || is_resolved_object(id_val)) {
+    if (as_resolved_argument(id_val) || as_resolved_variable(id_val) || as_resolved_object(id_val)) {
         copy_map.insert({e.id_name(), id_val});
     }
     auto val  = copy_propagate(id_val, copy_map, rewrites);
@@ -266,6 +266,13 @@ std::pair<resolved_mechanism, bool> copy_propagate(const resolved_mechanism& e)
         mech.on_events.push_back(result.first);
         made_changes |= result.second;
     }
+    for (const auto& c: e.post_events) {
+        local_copy_map.clear();
+        rewrites.clear();
+        auto result = copy_propagate(c, local_copy_map, rewrites);
+        mech.post_events.push_back(result.first);
+        made_changes |= result.second;
+    }
     for (const auto& c: e.evolutions) {
         local_copy_map.clear();
         rewrites.clear();
@@ -4,6 +4,7 @@
 
 #include <arblang/optimizer/cse.hpp>
 #include <arblang/util/custom_hash.hpp>
+#include <arblang/util/hash_cons.hpp>
 
 namespace al {
 namespace resolved_ir {
@@ -11,7 +12,7 @@ namespace resolved_ir {
 // Common subexpression elimination attempts to
 // simplify the code by not recalculating identical
 // expressions.
-// This is done by hashing the value of all expressions
+// This is done by interning the value of all expressions
 // on the rhs of an assignment in a let_expression, and
 // consolidating identical expressions. e.g.
 //    let a = x + y;
@@ -26,10 +27,24 @@ namespace resolved_ir {
 // CSE needs to be performed in a loop, until no more
 // changes can be made.
 
+// The values of the let-bindings visited so far, mapped to the
+// variables they were first bound to.
+struct cse_map {
+    hash_cons values;
+    std::unordered_map<hash_cons::id, r_expr> bound;
+    std::unordered_map<resolved_expr, r_expr> others; // Values that can't be interned.
+
+    void clear() {
+        values.clear();
+        bound.clear();
+        others.clear();
+    }
+};
+
 // Record aliases are not saved in the mechanism and are not expected
 // after the resolution pass.
 std::pair<r_expr, bool> cse(const resolved_record_alias& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     throw std::runtime_error("Internal compiler error, didn't expect a resolved_record_alias at "
@@ -37,14 +52,14 @@ std::pair<r_expr, bool> cse(const resolved_record_alias& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_argument& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_argument>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_variable& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     if (rewrites.count(e.name)) {
@@ -54,7 +69,7 @@ std::pair<r_expr, bool> cse(const resolved_variable& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_parameter& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto val_cse = cse(e.value, expr_map, rewrites);
@@ -62,7 +77,7 @@ std::pair<r_expr, bool> cse(const resolved_parameter& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_constant& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto val_cse = cse(e.value, expr_map, rewrites);
@@ -70,14 +85,14 @@ std::pair<r_expr, bool> cse(const resolved_constant& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_state& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_state>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_function& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto body_cse = cse(e.body, expr_map, rewrites);
@@ -85,14 +100,14 @@ std::pair<r_expr, bool> cse(const resolved_function& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_bind& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_bind>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_initial& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto val_cse = cse(e.value, expr_map, rewrites);
@@ -100,7 +115,7 @@ std::pair<r_expr, bool> cse(const resolved_initial& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_on_event& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto val_cse = cse(e.value, expr_map, rewrites);
@@ -108,7 +123,7 @@ std::pair<r_expr, bool> cse(const resolved_on_event& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_evolve& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto val_cse = cse(e.value, expr_map, rewrites);
@@ -116,7 +131,7 @@ std::pair<r_expr, bool> cse(const resolved_evolve& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_effect& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     auto val_cse = cse(e.value, expr_map, rewrites);
@@ -124,7 +139,7 @@ std::pair<r_expr, bool> cse(const resolved_effect& e,
 }
 
 std::pair<r_expr, bool> cse(const resolved_export& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_export>(e), false};
@@ -132,7 +147,7 @@ std::pair<r_expr, bool> cse(const resolved_export& e,
 
 // TODO: Do we need to visit the args?
 std::pair<r_expr, bool> cse(const resolved_call& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_call>(e), false};
@@ -140,25 +155,38 @@ std::pair<r_expr, bool> cse(const resolved_call& e,
 
 // TODO: Do we need to visit the args?
 std::pair<r_expr, bool> cse(const resolved_object& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_object>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_let& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     bool made_change = false;
 
     auto val = e.id_value();
-    if (!expr_map.insert({*val, e.identifier}).second) {
-        val = expr_map[*val];
+    auto var_name = e.id_name();
+    if (auto id = expr_map.values.intern(val)) {
+        // The value is identified by its interned id: looking it up doesn't walk its subtree.
+        auto it = expr_map.bound.find(id.value());
+        if (it == expr_map.bound.end()) {
+            expr_map.bound.insert({id.value(), e.identifier});
+        }
+        else {
+            auto var = as_resolved_variable(val);
+            made_change = !var || var->name != as_resolved_variable(it->second)->name;
+            val = it->second;
+        }
+        expr_map.values.bind(var_name, id.value());
+    }
+    else if (!expr_map.others.insert({*val, e.identifier}).second) {
+        val = expr_map.others[*val];
         made_change = true;
     }
 
-    auto var_name = e.id_name();
     auto var_ssa = make_rexpr<resolved_variable>(var_name, val, type_of(val), location_of(val));
     rewrites.insert({var_name, var_ssa});
 
@@ -168,42 +196,42 @@ std::pair<r_expr, bool> cse(const resolved_let& e,
 
 // TODO: Do we need to visit the args?
 std::pair<r_expr, bool> cse(const resolved_conditional& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_conditional>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_float& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_float>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_int& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_int>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_unary& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_unary>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_binary& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_binary>(e), false};
 }
 
 std::pair<r_expr, bool> cse(const resolved_field_access& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return {make_rexpr<resolved_field_access>(e), false};
@@ -211,7 +239,7 @@ std::pair<r_expr, bool> cse(const resolved_field_access& e,
 
 // TODO assert that canonicalize and single_assign were called before cse
 std::pair<resolved_mechanism, bool> cse(const resolved_mechanism& e) {
-    std::unordered_map<resolved_expr, r_expr> expr_map;
+    cse_map expr_map;
     std::unordered_map<std::string, r_expr> rewrites;
     resolved_mechanism mech;
     bool made_changes = false;
@@ -264,6 +292,13 @@ std::pair<resolved_mechanism, bool> cse(const resolved_mechanism& e) {
         mech.on_events.push_back(result.first);
         made_changes |= result.second;
     }
+    for (const auto& c: e.post_events) {
+        expr_map.clear();
+        rewrites.clear();
+        auto result = cse(c, expr_map, rewrites);
+        mech.post_events.push_back(result.first);
+        made_changes |= result.second;
+    }
     for (const auto& c: e.evolutions) {
         expr_map.clear();
         rewrites.clear();
@@ -292,14 +327,14 @@ std::pair<resolved_mechanism, bool> cse(const resolved_mechanism& e) {
 }
 
 std::pair<r_expr, bool> cse(const r_expr& e,
-                            std::unordered_map<resolved_expr, r_expr>& expr_map,
+                            cse_map& expr_map,
                             std::unordered_map<std::string, r_expr>& rewrites)
 {
     return std::visit([&](auto& c) {return cse(c, expr_map, rewrites);}, *e);
 }
 
 std::pair<r_expr, bool> cse(const r_expr& e) {
-    std::unordered_map<resolved_expr, r_expr> expr_map;
+    cse_map expr_map;
     std::unordered_map<std::string, r_expr> rewrites;
     return cse(e, expr_map, rewrites);
 }
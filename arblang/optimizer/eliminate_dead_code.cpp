@@ -76,7 +76,7 @@ void find_dead_code(const resolved_object& e, std::unordered_set<std::string>& d
 }
 
 void find_dead_code(const resolved_let& e, std::unordered_set<std::string>& dead_args) {
-    dead_args.insert(is_resolved_variable(e.identifier)->name);
+    dead_args.insert(as_resolved_variable(e.identifier)->name);
     find_dead_code(e.id_value(), dead_args);
     find_dead_code(e.body, dead_args);
 }
@@ -212,17 +212,17 @@ std::pair<resolved_mechanism, bool> eliminate_dead_code(const resolved_mechanism
 
     bool made_changes = false;
     for (const auto& c: e.constants) {
-        dead_param.insert(is_resolved_constant(c)->name);
+        dead_param.insert(as_resolved_constant(c)->name);
     }
     for (const auto& c: e.parameters) {
         find_dead_code(c, dead_param);
-        dead_param.insert(is_resolved_parameter(c)->name);
+        dead_param.insert(as_resolved_parameter(c)->name);
     }
     for (const auto& c: e.bindings) {
-        dead_param.insert(is_resolved_bind(c)->name);
+        dead_param.insert(as_resolved_bind(c)->name);
     }
     for (const auto& c: e.states) {
-        dead_param.insert(is_resolved_state(c)->name);
+        dead_param.insert(as_resolved_state(c)->name);
     }
     for (const auto& c: e.functions) {
         find_dead_code(c, dead_param);
@@ -233,6 +233,9 @@ std::pair<resolved_mechanism, bool> eliminate_dead_code(const resolved_mechanism
     for (const auto& c: e.on_events) {
         find_dead_code(c, dead_param);
     }
+    for (const auto& c: e.post_events) {
+        find_dead_code(c, dead_param);
+    }
     for (const auto& c: e.evolutions) {
         find_dead_code(c, dead_param);
     }
@@ -244,7 +247,7 @@ std::pair<resolved_mechanism, bool> eliminate_dead_code(const resolved_mechanism
     // and can be skipped in the final mechanism
 
     for (const auto& c: e.constants) {
-        auto name = is_resolved_constant(c)->name;
+        auto name = as_resolved_constant(c)->name;
         if (dead_param.count(name)) continue;
 
         find_dead_code(c, dead_code);
@@ -256,7 +259,7 @@ std::pair<resolved_mechanism, bool> eliminate_dead_code(const resolved_mechanism
         made_changes |= !dead_code.empty();
     }
     for (const auto& c: e.parameters) {
-        auto name = is_resolved_parameter(c)->name;
+        auto name = as_resolved_parameter(c)->name;
         if (dead_param.count(name)) continue;
 
         dead_code.clear();
@@ -269,7 +272,7 @@ std::pair<resolved_mechanism, bool> eliminate_dead_code(const resolved_mechanism
         made_changes |= !dead_code.empty();
     }
     for (const auto& c: e.bindings) {
-        auto name = is_resolved_bind(c)->name;
+        auto name = as_resolved_bind(c)->name;
         if (dead_param.count(name)) continue;
 
         dead_code.clear();
@@ -282,7 +285,7 @@ std::pair<resolved_mechanism, bool> eliminate_dead_code(const resolved_mechanism
         made_changes |= !dead_code.empty();
     }
     for (const auto& c: e.states) {
-        auto name = is_resolved_state(c)->name;
+        auto name = as_resolved_state(c)->name;
         if (dead_param.count(name)) continue;
 
         dead_code.clear();
@@ -324,6 +327,16 @@ std::pair<resolved_mechanism, bool> eliminate_dead_code(const resolved_mechanism
         }
         made_changes |= !dead_code.empty();
     }
+    for (const auto& c: e.post_events) {
+        dead_code.clear();
+        find_dead_code(c, dead_code);
+        if (!dead_code.empty()) {
+            mech.post_events.push_back(remove_dead_code(c, dead_code));
+        } else {
+            mech.post_events.push_back(c);
+        }
+        made_changes |= !dead_code.empty();
+    }
     for (const auto& c: e.evolutions) {
         dead_code.clear();
         find_dead_code(c, dead_code);
@@ -166,13 +166,18 @@ r_expr inline_func(const resolved_call& e,
     }
     auto func = avail_funcs.at(e.f_identifier);
 
+    // Tabulated functions have no body to inline, the call is kept.
+    if (!func) {
+        return make_rexpr<resolved_call>(e.f_identifier, args, e.type, e.loc);
+    }
+
     // Set up f_rewrites to replace the function arguments with the call arguments
     int idx = 0;
     std::unordered_map<std::string, r_expr> f_rewrites;
 
-    const auto& r_func = is_resolved_function(func);
+    const auto& r_func = as_resolved_function(func);
     for (const auto& a: r_func->args) {
-        f_rewrites.insert({is_resolved_argument(a)->name, args[idx++]});
+        f_rewrites.insert({as_resolved_argument(a)->name, args[idx++]});
     }
 
     // Set up f_avail_funcs to disallow recursion
@@ -185,7 +190,7 @@ r_expr inline_func(const resolved_call& e,
     auto func_inlined = inline_func(func, reserved, f_rewrites, f_avail_funcs, pref);
 
     // body of the function can be directly inlined
-    return is_resolved_function(func_inlined)->body;
+    return as_resolved_function(func_inlined)->body;
 }
 
 r_expr inline_func(const resolved_object& e,
@@ -221,8 +226,8 @@ r_expr inline_func(const resolved_let& e,
     auto let_outer = resolved_let(iden, body, e.type, e.loc);
 
     // Extract let
-    if (auto let_opt = is_resolved_let(val)) {
-        auto let_val = let_opt.value();
+    if (auto let_opt = as_resolved_let(val)) {
+        auto let_val = *let_opt;
 
         let_outer.id_value(get_innermost_body(&let_val));
         set_innermost_body(&let_val, make_rexpr<resolved_let>(let_outer));
@@ -294,7 +299,7 @@ r_expr inline_func(const resolved_field_access& e,
     return make_rexpr<resolved_field_access>(obj, e.field, e.type, e.loc);
 }
 
-resolved_mechanism inline_func(const resolved_mechanism& e) {
+resolved_mechanism inline_func(const resolved_mechanism& e, const std::unordered_set<std::string>& tabulated) {
     std::unordered_set<std::string> globals;
     std::unordered_set<std::string> reserved;
     std::unordered_map<std::string, r_expr> rewrites, avail_funcs;
@@ -303,21 +308,22 @@ resolved_mechanism inline_func(const resolved_mechanism& e) {
 
     // Get all globally available symbols
     for (const auto& c: e.constants) {
-        globals.insert(is_resolved_constant(c)->name);
+        globals.insert(as_resolved_constant(c)->name);
     }
     for (const auto& c: e.parameters) {
-        globals.insert(is_resolved_parameter(c)->name);
+        globals.insert(as_resolved_parameter(c)->name);
     }
     for (const auto& c: e.bindings) {
-        globals.insert(is_resolved_bind(c)->name);
+        globals.insert(as_resolved_bind(c)->name);
     }
     for (const auto& c: e.states) {
-        globals.insert(is_resolved_state(c)->name);
+        globals.insert(as_resolved_state(c)->name);
     }
 
     // Get all globally available functions
     for (const auto& c: e.functions) {
-        avail_funcs.insert({is_resolved_function(c)->name, c});
+        auto name = as_resolved_function(c)->name;
+        avail_funcs.insert({name, tabulated.count(name)? nullptr: c});
     }
 
     for (const auto& c: e.constants) {
@@ -350,6 +356,11 @@ resolved_mechanism inline_func(const resolved_mechanism& e) {
         rewrites.clear();
         mech.on_events.push_back(inline_func(c, reserved, rewrites, avail_funcs, pref));
     }
+    for (const auto& c: e.post_events) {
+        reserved = globals;
+        rewrites.clear();
+        mech.post_events.push_back(inline_func(c, reserved, rewrites, avail_funcs, pref));
+    }
     for (const auto& c: e.evolutions) {
         reserved = globals;
         rewrites.clear();
@@ -0,0 +1,441 @@
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arblang/optimizer/copy_propagate.hpp>
+#include <arblang/optimizer/cse.hpp>
+#include <arblang/optimizer/eliminate_dead_code.hpp>
+#include <arblang/optimizer/ssa_block.hpp>
+#include <arblang/util/custom_hash.hpp>
+#include <arblang/util/hash_cons.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+unsigned ssa_block::find(unsigned i) const {
+    while (forward[i] != i) i = forward[i];
+    return i;
+}
+
+std::vector<unsigned> ssa_block::operands_of(unsigned i) const {
+    std::vector<unsigned> result;
+    for (unsigned k = 0; k < num_operands[i]; ++k) {
+        result.push_back(find(operands[first_operand[i] + k]));
+    }
+    return result;
+}
+
+// Lowering
+
+struct ssa_builder {
+    ssa_block block;
+    std::unordered_map<std::string, unsigned> bound;
+    std::unordered_map<resolved_type, unsigned> type_ids;
+    std::unordered_map<std::string, unsigned> string_ids;
+
+    unsigned intern(const r_type& t) {
+        auto it = type_ids.find(*t);
+        if (it != type_ids.end()) return it->second;
+        block.types.push_back(t);
+        return type_ids[*t] = block.types.size()-1;
+    }
+
+    unsigned intern(const std::string& s) {
+        auto it = string_ids.find(s);
+        if (it != string_ids.end()) return it->second;
+        block.strings.push_back(s);
+        return string_ids[s] = block.strings.size()-1;
+    }
+
+    unsigned add(ssa_op op, int kind, const std::vector<unsigned>& args, unsigned payload, const r_type& t, const src_location& loc) {
+        unsigned i = block.size();
+        block.op.push_back(op);
+        block.op_kind.push_back(kind);
+        block.first_operand.push_back(block.operands.size());
+        block.num_operands.push_back(args.size());
+        block.payload.push_back(payload);
+        block.type_id.push_back(intern(t));
+        block.name.push_back(ssa_block::npos);
+        block.forward.push_back(i);
+        block.loc.push_back(loc);
+        block.operands.insert(block.operands.end(), args.begin(), args.end());
+        return i;
+    }
+
+    unsigned add_leaf(const r_expr& e) {
+        block.leaves.push_back(e);
+        return add(ssa_op::leaf, 0, {}, block.leaves.size()-1, type_of(e), location_of(e));
+    }
+
+    std::optional<unsigned> flatten(const std::vector<r_expr>& exprs, std::vector<unsigned>& args) {
+        for (const auto& a: exprs) {
+            auto i = flatten(a);
+            if (!i) return {};
+            args.push_back(i.value());
+        }
+        return 0;
+    }
+
+    // Flatten `e`, returning the instruction computing it.
+    std::optional<unsigned> flatten(const r_expr& e) {
+        std::vector<unsigned> args;
+        if (auto v = as_resolved_variable(e)) {
+            auto it = bound.find(v->name);
+            if (it != bound.end()) return it->second;
+            return add_leaf(e);
+        }
+        if (as_resolved_argument(e) || as_resolved_float(e) || as_resolved_int(e)) {
+            return add_leaf(e);
+        }
+        if (auto u = as_resolved_unary(e)) {
+            if (!flatten({u->arg}, args)) return {};
+            return add(ssa_op::unary, (int)u->op, args, 0, u->type, u->loc);
+        }
+        if (auto b = as_resolved_binary(e)) {
+            if (!flatten({b->lhs, b->rhs}, args)) return {};
+            return add(ssa_op::binary, (int)b->op, args, 0, b->type, b->loc);
+        }
+        if (auto c = as_resolved_call(e)) {
+            if (!flatten(c->call_args, args)) return {};
+            return add(ssa_op::call, 0, args, intern(c->f_identifier), c->type, c->loc);
+        }
+        if (auto c = as_resolved_conditional(e)) {
+            if (!flatten({c->condition, c->value_true, c->value_false}, args)) return {};
+            return add(ssa_op::conditional, 0, args, 0, c->type, c->loc);
+        }
+        if (auto f = as_resolved_field_access(e)) {
+            if (!flatten({f->object}, args)) return {};
+            return add(ssa_op::field_access, 0, args, intern(f->field), f->type, f->loc);
+        }
+        if (auto o = as_resolved_object(e)) {
+            if (!flatten(o->field_values(), args)) return {};
+            unsigned first = block.field_names.size();
+            for (const auto& n: o->field_names()) {
+                block.field_names.push_back(intern(n));
+            }
+            return add(ssa_op::object, 0, args, first, o->type, o->loc);
+        }
+        return {};
+    }
+};
+
+std::optional<ssa_block> lower_to_ssa(const r_expr& e) {
+    ssa_builder builder;
+    auto& block = builder.block;
+
+    auto body = e;
+    while (auto let = as_resolved_let(body)) {
+        auto val = let->id_value();
+        std::optional<unsigned> i;
+        if (auto v = as_resolved_variable(val); v && builder.bound.count(v->name)) {
+            i = builder.add(ssa_op::copy, 0, {builder.bound.at(v->name)}, 0, v->type, v->loc);
+        }
+        else {
+            i = builder.flatten(val);
+        }
+        if (!i) return {};
+
+        // Bind a new instruction, even if the value is a variable bound earlier.
+        block.name[i.value()] = block.names.size();
+        block.names.push_back(let->id_name());
+        block.bindings.push_back(i.value());
+        block.let_type_id.push_back(builder.intern(let->type));
+        builder.bound[let->id_name()] = i.value();
+        body = let->body;
+    }
+
+    auto result = builder.flatten(body);
+    if (!result) return {};
+    block.result = result.value();
+    return std::move(block);
+}
+
+// Raising
+
+struct ssa_raiser {
+    const ssa_block& block;
+    std::vector<r_expr> values;
+
+    ssa_raiser(const ssa_block& block): block(block), values(block.size()) {}
+
+    std::vector<r_expr> operands(unsigned i) {
+        std::vector<r_expr> result;
+        for (auto j: block.operands_of(i)) {
+            result.push_back(reference(j));
+        }
+        return result;
+    }
+
+    // A use of instruction i: a variable if it is named, its value otherwise.
+    r_expr reference(unsigned i) {
+        i = block.find(i);
+        if (block.name[i] == ssa_block::npos) return value(i);
+        return make_rexpr<resolved_variable>(block.names[block.name[i]], values[i], block.types[block.type_id[i]], block.loc[i]);
+    }
+
+    r_expr value(unsigned i) {
+        const auto& type = block.types[block.type_id[i]];
+        const auto& loc = block.loc[i];
+        switch (block.op[i]) {
+            case ssa_op::leaf:
+                return block.leaves[block.payload[i]];
+            case ssa_op::copy:
+                return reference(block.operands[block.first_operand[i]]);
+            case ssa_op::unary: {
+                auto args = operands(i);
+                return make_rexpr<resolved_unary>((unary_op)block.op_kind[i], args[0], type, loc);
+            }
+            case ssa_op::binary: {
+                auto args = operands(i);
+                return make_rexpr<resolved_binary>((binary_op)block.op_kind[i], args[0], args[1], type, loc);
+            }
+            case ssa_op::call:
+                return make_rexpr<resolved_call>(block.strings[block.payload[i]], operands(i), type, loc);
+            case ssa_op::conditional: {
+                auto args = operands(i);
+                return make_rexpr<resolved_conditional>(args[0], args[1], args[2], type, loc);
+            }
+            case ssa_op::field_access:
+                return make_rexpr<resolved_field_access>(operands(i)[0], block.strings[block.payload[i]], type, loc);
+            case ssa_op::object: {
+                std::vector<std::string> fields;
+                for (unsigned k = 0; k < block.num_operands[i]; ++k) {
+                    fields.push_back(block.strings[block.field_names[block.payload[i] + k]]);
+                }
+                return make_rexpr<resolved_object>(fields, operands(i), type, loc);
+            }
+        }
+        throw std::runtime_error("Internal compiler error, unknown ssa_op.");
+    }
+};
+
+r_expr raise_from_ssa(const ssa_block& block) {
+    ssa_raiser raiser(block);
+
+    std::vector<unsigned> lets;
+    for (unsigned k = 0; k < block.bindings.size(); ++k) {
+        auto i = block.bindings[k];
+        if (block.find(i) != i || block.name[i] == ssa_block::npos) continue;
+        raiser.values[i] = raiser.value(i);
+        lets.push_back(k);
+    }
+
+    auto result = raiser.reference(block.result);
+    for (auto it = lets.rbegin(); it != lets.rend(); ++it) {
+        auto i = block.bindings[*it];
+        result = make_rexpr<resolved_let>(block.names[block.name[i]], raiser.values[i], result,
+                                          block.types[block.let_type_id[*it]], block.loc[i]);
+    }
+    return result;
+}
+
+// Optimizations
+
+struct ssa_key_hash {
+    std::size_t operator()(const std::vector<unsigned>& key) const {
+        std::size_t h = 0;
+        for (auto k: key) hash_combine(h, k);
+        return h;
+    }
+};
+
+// Bindings with the same value number as an earlier binding are replaced by it.
+// Instructions are numbered from the numbers of their operands, so each
+// instruction is visited once.
+bool cse(ssa_block& block) {
+    bool made_change = false;
+    hash_cons leaves;
+    std::vector<unsigned> number(block.size());
+    std::unordered_map<std::vector<unsigned>, unsigned, ssa_key_hash> numbered;
+    std::unordered_map<unsigned, unsigned> first_binding;
+
+    for (unsigned i = 0; i < block.size(); ++i) {
+        if (block.find(i) != i) {
+            number[i] = number[block.find(i)];
+            continue;
+        }
+        if (block.op[i] == ssa_op::copy) {
+            number[i] = number[block.find(block.operands[block.first_operand[i]])];
+        }
+        else {
+            std::vector<unsigned> key = {(unsigned)block.op[i], (unsigned)block.op_kind[i], block.type_id[i]};
+            switch (block.op[i]) {
+                case ssa_op::leaf:
+                    key.push_back(leaves.intern(block.leaves[block.payload[i]]).value());
+                    break;
+                case ssa_op::call:
+                case ssa_op::field_access:
+                    key.push_back(block.payload[i]);
+                    break;
+                case ssa_op::object:
+                    for (unsigned k = 0; k < block.num_operands[i]; ++k) {
+                        key.push_back(block.field_names[block.payload[i] + k]);
+                    }
+                    break;
+                default: break;
+            }
+            for (auto j: block.operands_of(i)) {
+                key.push_back(number[j]);
+            }
+            number[i] = numbered.insert({std::move(key), i}).first->second;
+        }
+
+        if (block.name[i] != ssa_block::npos) {
+            auto it = first_binding.insert({number[i], i});
+            if (!it.second) {
+                block.forward[i] = it.first->second;
+                made_change = true;
+            }
+        }
+    }
+    return made_change;
+}
+
+// Copies are replaced by the instruction they copy; bindings of arguments,
+// free variables and objects are substituted into their uses.
+bool copy_propagate(ssa_block& block) {
+    bool made_change = false;
+    for (auto i: block.bindings) {
+        if (block.find(i) != i || block.name[i] == ssa_block::npos) continue;
+        switch (block.op[i]) {
+            case ssa_op::copy:
+                block.forward[i] = block.find(block.operands[block.first_operand[i]]);
+                made_change = true;
+                break;
+            case ssa_op::leaf: {
+                const auto& leaf = block.leaves[block.payload[i]];
+                if (as_resolved_argument(leaf) || as_resolved_variable(leaf)) {
+                    block.name[i] = ssa_block::npos;
+                    made_change = true;
+                }
+                break;
+            }
+            case ssa_op::object:
+                block.name[i] = ssa_block::npos;
+                made_change = true;
+                break;
+            default: break;
+        }
+    }
+    return made_change;
+}
+
+// Bindings that don't contribute to the result are removed. Operands precede
+// their users, so liveness is found in one backward scan.
+bool eliminate_dead_code(ssa_block& block) {
+    std::vector<bool> live(block.size(), false);
+    live[block.find(block.result)] = true;
+    for (unsigned i = block.size(); i-- > 0;) {
+        if (!live[i]) continue;
+        for (auto j: block.operands_of(i)) {
+            live[j] = true;
+        }
+    }
+
+    bool made_change = false;
+    for (auto i: block.bindings) {
+        if (block.find(i) != i || block.name[i] == ssa_block::npos || live[i]) continue;
+        block.name[i] = ssa_block::npos;
+        made_change = true;
+    }
+    return made_change;
+}
+
+std::pair<r_expr, bool> optimize_let_chain(const r_expr& e) {
+    auto block = lower_to_ssa(e);
+    if (!block) {
+        auto cse_result = cse(e);
+        auto cp_result  = copy_propagate(cse_result.first);
+        auto dce_result = eliminate_dead_code(cp_result.first);
+        if (!cse_result.second && !cp_result.second && !dce_result.second) return {e, false};
+        return {dce_result.first, true};
+    }
+
+    bool made_change = false;
+    bool keep_optimizing = true;
+    while (keep_optimizing) {
+        keep_optimizing = cse(block.value());
+        keep_optimizing |= copy_propagate(block.value());
+        keep_optimizing |= eliminate_dead_code(block.value());
+        made_change |= keep_optimizing;
+    }
+    if (!made_change) return {e, false};
+    return {raise_from_ssa(block.value()), true};
+}
+
+std::pair<r_expr, bool> optimize_let_chains(const r_expr& e) {
+    if (auto c = as_resolved_constant(e)) {
+        auto result = optimize_let_chain(c->value);
+        if (!result.second) return {e, false};
+        return {make_rexpr<resolved_constant>(c->name, result.first, c->type, c->loc), result.second};
+    }
+    if (auto c = as_resolved_parameter(e)) {
+        auto result = optimize_let_chain(c->value);
+        if (!result.second) return {e, false};
+        return {make_rexpr<resolved_parameter>(c->name, result.first, c->type, c->loc), result.second};
+    }
+    if (auto c = as_resolved_function(e)) {
+        auto result = optimize_let_chain(c->body);
+        if (!result.second) return {e, false};
+        return {make_rexpr<resolved_function>(c->name, c->args, result.first, c->type, c->loc), result.second};
+    }
+    if (auto c = as_resolved_initial(e)) {
+        auto result = optimize_let_chain(c->value);
+        if (!result.second) return {e, false};
+        return {make_rexpr<resolved_initial>(c->identifier, result.first, c->type, c->loc), result.second};
+    }
+    if (auto c = as_resolved_on_event(e)) {
+        auto result = optimize_let_chain(c->value);
+        if (!result.second) return {e, false};
+        return {make_rexpr<resolved_on_event>(c->argument, c->identifier, result.first, c->type, c->loc), result.second};
+    }
+    if (auto c = as_resolved_evolve(e)) {
+        auto result = optimize_let_chain(c->value);
+        if (!result.second) return {e, false};
+        return {make_rexpr<resolved_evolve>(c->identifier, result.first, c->type, c->loc), result.second};
+    }
+    if (auto c = as_resolved_effect(e)) {
+        auto result = optimize_let_chain(c->value);
+        if (!result.second) return {e, false};
+        return {make_rexpr<resolved_effect>(c->effect, c->ion, result.first, c->type, c->loc), result.second};
+    }
+    if (as_resolved_state(e) || as_resolved_bind(e) || as_resolved_export(e)) {
+        return {e, false};
+    }
+    if (as_resolved_record_alias(e)) {
+        throw std::runtime_error("Internal compiler error, didn't expect a resolved_record_alias at "
+                                 "this stage in the compilation.");
+    }
+    return optimize_let_chain(e);
+}
+
+std::pair<resolved_mechanism, bool> optimize_let_chains(const resolved_mechanism& e) {
+    resolved_mechanism mech;
+    bool made_changes = false;
+    auto optimize = [&](const std::vector<r_expr>& from, std::vector<r_expr>& to) {
+        for (const auto& c: from) {
+            auto result = optimize_let_chains(c);
+            to.push_back(result.first);
+            made_changes |= result.second;
+        }
+    };
+    optimize(e.constants, mech.constants);
+    optimize(e.parameters, mech.parameters);
+    optimize(e.bindings, mech.bindings);
+    optimize(e.states, mech.states);
+    optimize(e.functions, mech.functions);
+    optimize(e.initializations, mech.initializations);
+    optimize(e.on_events, mech.on_events);
+    optimize(e.post_events, mech.post_events);
+    optimize(e.evolutions, mech.evolutions);
+    optimize(e.effects, mech.effects);
+    optimize(e.exports, mech.exports);
+    mech.name = e.name;
+    mech.loc = e.loc;
+    mech.kind = e.kind;
+    return {mech, made_changes};
+}
+
+} // namespace resolved_ir
+} // namespace al
@@ -0,0 +1,271 @@
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <arblang/optimizer/strength_reduce.hpp>
+#include <arblang/util/unique_name.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Strength reduction replaces expensive arithmetic in
+// let-chains with cheaper equivalents:
+// 1. Small integer powers are expanded into a chain of
+//    multiplications using repeated squaring. e.g.
+//       let a = x^4;
+//    becomes:
+//       let _pw0 = x*x;
+//       let _pw1 = _pw0*_pw0;
+//       let a = _pw1;
+// 2. Repeated division by the same variable is replaced
+//    by a single reciprocal followed by multiplications. e.g.
+//       let a = x/d;
+//       let b = y/d;
+//    becomes:
+//       let _rcp0 = 1/d;
+//       let a = x*_rcp0;
+//       let b = y*_rcp0;
+// The pass expects canonical, single-assigned expressions and
+// leaves the copies it creates to the rest of the optimizer.
+
+// Largest exponent expanded into multiplications.
+static constexpr int max_power = 16;
+
+struct let_binding {
+    std::string name;
+    r_expr value;
+    r_type type;
+    src_location loc;
+};
+
+std::pair<r_expr, bool> strength_reduce(const r_expr&, std::unordered_set<std::string>&);
+
+// Returns the integral exponent of `e` if it is a candidate for expansion.
+std::optional<int> small_integer_exponent(const r_expr& e) {
+    double value;
+    if (auto i = as_resolved_int(e)) {
+        value = i->value;
+    }
+    else if (auto f = as_resolved_float(e)) {
+        value = f->value;
+    }
+    else {
+        return {};
+    }
+    if (value != std::trunc(value) || std::abs(value) < 2 || std::abs(value) > max_power) return {};
+    return (int)value;
+}
+
+// Returns the name of the divisor of `e` if it is a variable or argument.
+std::optional<std::string> divisor_name(const r_expr& e) {
+    auto bin = as_resolved_binary(e);
+    if (!bin || bin->op != binary_op::div) return {};
+    if (auto v = as_resolved_variable(bin->rhs)) return v->name;
+    if (auto a = as_resolved_argument(bin->rhs)) return a->name;
+    return {};
+}
+
+// Bind `value` to a new let variable and return the variable.
+r_expr bind(const r_expr& value,
+            const std::string& prefix,
+            const r_type& let_type,
+            std::unordered_set<std::string>& reserved,
+            std::vector<let_binding>& bindings)
+{
+    auto loc = location_of(value);
+    auto name = unique_local_name(reserved, prefix);
+    bindings.push_back({name, value, let_type, loc});
+    return make_rexpr<resolved_variable>(name, value, type_of(value), loc);
+}
+
+// Expand base^n into multiplications by repeated squaring, binding
+// every intermediate product. Returns the final product.
+r_expr expand_power(const r_expr& base,
+                    int n,
+                    const r_type& let_type,
+                    std::unordered_set<std::string>& reserved,
+                    std::vector<let_binding>& bindings)
+{
+    auto loc = location_of(base);
+    bool invert = n < 0;
+    n = std::abs(n);
+
+    r_expr result, square = base;
+    while (true) {
+        if (n & 1) {
+            result = result? bind(make_rexpr<resolved_binary>(binary_op::mul, result, square, loc), "pw", let_type, reserved, bindings): square;
+        }
+        n >>= 1;
+        if (!n) break;
+        square = bind(make_rexpr<resolved_binary>(binary_op::mul, square, square, loc), "pw", let_type, reserved, bindings);
+    }
+    if (invert) {
+        auto one = make_rexpr<resolved_float>(1.0, make_rtype<resolved_quantity>(quantity::real, loc), loc);
+        result = make_rexpr<resolved_binary>(binary_op::div, one, result, loc);
+    }
+    return result;
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_record_alias& e, std::unordered_set<std::string>& reserved) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_record_alias at "
+                             "this stage in the compilation.");
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_argument& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_argument>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_variable& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_variable>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_parameter& e, std::unordered_set<std::string>& reserved) {
+    auto result = strength_reduce(e.value, reserved);
+    return {make_rexpr<resolved_parameter>(e.name, result.first, e.type, e.loc), result.second};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_constant& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_constant>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_state& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_state>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_function& e, std::unordered_set<std::string>& reserved) {
+    auto result = strength_reduce(e.body, reserved);
+    return {make_rexpr<resolved_function>(e.name, e.args, result.first, e.type, e.loc), result.second};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_bind& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_bind>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_initial& e, std::unordered_set<std::string>& reserved) {
+    auto result = strength_reduce(e.value, reserved);
+    return {make_rexpr<resolved_initial>(e.identifier, result.first, e.type, e.loc), result.second};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_on_event& e, std::unordered_set<std::string>& reserved) {
+    auto result = strength_reduce(e.value, reserved);
+    return {make_rexpr<resolved_on_event>(e.argument, e.identifier, result.first, e.type, e.loc), result.second};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_evolve& e, std::unordered_set<std::string>& reserved) {
+    auto result = strength_reduce(e.value, reserved);
+    return {make_rexpr<resolved_evolve>(e.identifier, result.first, e.type, e.loc), result.second};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_effect& e, std::unordered_set<std::string>& reserved) {
+    auto result = strength_reduce(e.value, reserved);
+    return {make_rexpr<resolved_effect>(e.effect, e.ion, result.first, e.type, e.loc), result.second};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_export& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_export>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_call& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_call>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_object& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_object>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_let& e, std::unordered_set<std::string>& reserved) {
+    // Flatten the let-chain, and count how many times
+    // each variable is used as a divisor in the chain.
+    std::vector<resolved_let> chain = {e};
+    while (auto next = as_resolved_let(chain.back().body)) {
+        chain.push_back(*next);
+    }
+    std::unordered_map<std::string, int> divisor_count;
+    for (const auto& l: chain) {
+        reserved.insert(l.id_name());
+        if (auto d = divisor_name(l.id_value())) {
+            divisor_count[d.value()]++;
+        }
+    }
+
+    bool made_change = false;
+    std::vector<let_binding> bindings;
+    std::unordered_map<std::string, r_expr> reciprocals;
+    for (const auto& l: chain) {
+        auto val = l.id_value();
+        if (auto bin = as_resolved_binary(val)) {
+            auto exponent = small_integer_exponent(bin->rhs);
+            if (bin->op == binary_op::pow && exponent) {
+                val = expand_power(bin->lhs, exponent.value(), l.type, reserved, bindings);
+                made_change = true;
+            }
+            else if (auto d = divisor_name(val); d && divisor_count.at(d.value()) > 1) {
+                if (!reciprocals.count(d.value())) {
+                    auto one = make_rexpr<resolved_float>(1.0, make_rtype<resolved_quantity>(quantity::real, bin->loc), bin->loc);
+                    auto rcp = make_rexpr<resolved_binary>(binary_op::div, one, bin->rhs, bin->loc);
+                    reciprocals.insert({d.value(), bind(rcp, "rcp", l.type, reserved, bindings)});
+                }
+                val = make_rexpr<resolved_binary>(binary_op::mul, bin->lhs, reciprocals.at(d.value()), bin->loc);
+                made_change = true;
+            }
+        }
+        else if (as_resolved_conditional(val) || as_resolved_let(val)) {
+            auto result = strength_reduce(val, reserved);
+            val = result.first;
+            made_change |= result.second;
+        }
+        bindings.push_back({l.id_name(), val, l.type, l.loc});
+    }
+
+    auto body = strength_reduce(chain.back().body, reserved);
+    made_change |= body.second;
+
+    if (!made_change) return {make_rexpr<resolved_let>(e), false};
+
+    auto result = body.first;
+    for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+        result = make_rexpr<resolved_let>(it->name, it->value, result, it->type, it->loc);
+    }
+    return {result, true};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_conditional& e, std::unordered_set<std::string>& reserved) {
+    auto tval = strength_reduce(e.value_true, reserved);
+    auto fval = strength_reduce(e.value_false, reserved);
+    return {make_rexpr<resolved_conditional>(e.condition, tval.first, fval.first, e.type, e.loc),
+            tval.second||fval.second};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_float& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_float>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_int& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_int>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_unary& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_unary>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_binary& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_binary>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const resolved_field_access& e, std::unordered_set<std::string>& reserved) {
+    return {make_rexpr<resolved_field_access>(e), false};
+}
+
+std::pair<r_expr, bool> strength_reduce(const r_expr& e, std::unordered_set<std::string>& reserved) {
+    return std::visit([&](auto& c) {return strength_reduce(c, reserved);}, *e);
+}
+
+std::pair<r_expr, bool> strength_reduce(const r_expr& e) {
+    std::unordered_set<std::string> reserved;
+    return strength_reduce(e, reserved);
+}
+
+} // namespace resolved_ir
+} // namespace al
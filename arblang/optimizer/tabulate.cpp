@@ -0,0 +1,82 @@
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <fmt/core.h>
+
+#include <arblang/optimizer/eliminate_dead_code.hpp>
+#include <arblang/optimizer/inline_func.hpp>
+#include <arblang/optimizer/optimizer.hpp>
+#include <arblang/optimizer/tabulate.hpp>
+#include <arblang/resolver/resolved_types.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+std::vector<resolved_table> tabulate(const resolved_mechanism& mech, const std::unordered_map<std::string, table_spec>& specs) {
+    std::unordered_map<std::string, r_expr> avail_funcs;
+    for (const auto& c: mech.functions) {
+        avail_funcs.insert({as_resolved_function(c)->name, c});
+    }
+
+    // Symbols a tabulated function is not allowed to read.
+    std::unordered_set<std::string> globals;
+    for (const auto& c: mech.parameters) {
+        globals.insert(as_resolved_parameter(c)->name);
+    }
+    for (const auto& c: mech.bindings) {
+        globals.insert(as_resolved_bind(c)->name);
+    }
+    for (const auto& c: mech.states) {
+        globals.insert(as_resolved_state(c)->name);
+    }
+
+    for (const auto& [name, spec]: specs) {
+        if (!avail_funcs.count(name)) {
+            throw std::runtime_error(fmt::format("Cannot tabulate function {}: no such function in mechanism {}.",
+                                                 name, mech.name));
+        }
+    }
+
+    std::vector<resolved_table> tables;
+    for (const auto& c: mech.functions) {
+        const auto& func = *as_resolved_function(c);
+        auto name = func.name;
+        if (!specs.count(name)) continue;
+
+        auto spec = specs.at(name);
+        if (func.args.size() != 1 || !is_resolved_quantity_type(type_of(func.args.front()))) {
+            throw std::runtime_error(fmt::format("Cannot tabulate function {} at {}: expected a single argument "
+                                                 "of quantity type.", name, to_string(func.loc)));
+        }
+        if (!is_resolved_quantity_type(func.type)) {
+            throw std::runtime_error(fmt::format("Cannot tabulate function {} at {}: expected a quantity "
+                                                 "return type.", name, to_string(func.loc)));
+        }
+        if (!(spec.lo < spec.hi) || !spec.intervals) {
+            throw std::runtime_error(fmt::format("Cannot tabulate function {}: expected a non-empty range "
+                                                 "and a positive number of intervals.", name));
+        }
+
+        // Inline the functions called by the body, without allowing recursion.
+        auto funcs = avail_funcs;
+        funcs.erase(name);
+        auto body = optimizer(inline_func(func.body, funcs, "f")).optimize();
+
+        // find_dead_code removes every symbol read by the body from `unread`.
+        // The argument of the function can shadow a global.
+        auto unread = globals;
+        unread.erase(as_resolved_argument(func.args.front())->name);
+        auto n_globals = unread.size();
+        find_dead_code(body, unread);
+        if (unread.size() != n_globals) {
+            throw std::runtime_error(fmt::format("Cannot tabulate function {} at {}: the function reads parameters, "
+                                                 "bindings or states.", name, to_string(func.loc)));
+        }
+        tables.push_back({name, func.args.front(), body, spec});
+    }
+    return tables;
+}
+
+} // namespace resolved_ir
+} // namespace al
@@ -327,6 +327,36 @@ private:
                     token_ = {loc(), tok::lor, {character(), character()}};
                     return;
                 }
+                // empty set of a reaction
+                case '\\':
+                    if (peek_char(1)!='0') {
+                        token_ = {loc(), tok::error, "Expected 0 after \\."};
+                        return;
+                    }
+                    token_ = {loc(), tok::empty_set, {character(), character()}};
+                    return;
+                // UTF-8 encoded arrows and empty set of a reaction
+                case '\xE2': {
+                    std::string s = {peek_char(0), peek_char(1), peek_char(2)};
+                    if (s == "\u2192") {
+                        token_ = {loc(), tok::ret, s};
+                    }
+                    else if (s == "\u2190") {
+                        token_ = {loc(), tok::left_arrow, s};
+                    }
+                    else if (s == "\u21C4") {
+                        token_ = {loc(), tok::arrow, s};
+                    }
+                    else if (s == "\u2205") {
+                        token_ = {loc(), tok::empty_set, s};
+                    }
+                    else {
+                        token_ = {loc(), tok::error, std::string("Unexpected character '")+character()+"'"};
+                        return;
+                    }
+                    stream_ += 3;
+                    return;
+                }
                 case ',':
                     token_ = {loc(), tok::comma, {character()}};
                     return;
@@ -41,6 +41,9 @@ parsed_mechanism normalize(const parsed_mechanism& e) {
     for (const auto& c: e.on_events) {
         mech.on_events.push_back(normalize(c));
     }
+    for (const auto& c: e.post_events) {
+        mech.post_events.push_back(normalize(c));
+    }
     for (const auto& c: e.effects) {
         mech.effects.push_back(normalize(c));
     }
@@ -187,6 +187,9 @@ std::string to_string(const parsed_mechanism& e, int indent) {
     for (const auto& p: e.on_events) {
         str += to_string(p, indent+1) + "\n";
     }
+    for (const auto& p: e.post_events) {
+        str += to_string(p, indent+1) + "\n";
+    }
     for (const auto& p: e.evolutions) {
         str += to_string(p, indent+1) + "\n";
     }
@@ -558,6 +561,69 @@ std::optional<parsed_binary> is_parsed_binary(const p_expr& p) {
     if (!std::holds_alternative<parsed_binary>(*p)) return {};
     return std::get<parsed_binary>(*p);
 }
+const parsed_parameter* as_parsed_parameter(const p_expr& p) {
+    return std::get_if<parsed_parameter>(p.get());
+}
+const parsed_constant* as_parsed_constant(const p_expr& p) {
+    return std::get_if<parsed_constant>(p.get());
+}
+const parsed_state* as_parsed_state(const p_expr& p) {
+    return std::get_if<parsed_state>(p.get());
+}
+const parsed_record_alias* as_parsed_record_alias(const p_expr& p) {
+    return std::get_if<parsed_record_alias>(p.get());
+}
+const parsed_function* as_parsed_function(const p_expr& p) {
+    return std::get_if<parsed_function>(p.get());
+}
+const parsed_bind* as_parsed_bind(const p_expr& p) {
+    return std::get_if<parsed_bind>(p.get());
+}
+const parsed_initial* as_parsed_initial(const p_expr& p) {
+    return std::get_if<parsed_initial>(p.get());
+}
+const parsed_evolve* as_parsed_evolve(const p_expr& p) {
+    return std::get_if<parsed_evolve>(p.get());
+}
+const parsed_effect* as_parsed_effect(const p_expr& p) {
+    return std::get_if<parsed_effect>(p.get());
+}
+const parsed_on_event* as_parsed_on_event(const p_expr& p) {
+    return std::get_if<parsed_on_event>(p.get());
+}
+const parsed_export* as_parsed_export(const p_expr& p) {
+    return std::get_if<parsed_export>(p.get());
+}
+const parsed_call* as_parsed_call(const p_expr& p) {
+    return std::get_if<parsed_call>(p.get());
+}
+const parsed_object* as_parsed_object(const p_expr& p) {
+    return std::get_if<parsed_object>(p.get());
+}
+const parsed_let* as_parsed_let(const p_expr& p) {
+    return std::get_if<parsed_let>(p.get());
+}
+const parsed_with* as_parsed_with(const p_expr& p) {
+    return std::get_if<parsed_with>(p.get());
+}
+const parsed_conditional* as_parsed_conditional(const p_expr& p) {
+    return std::get_if<parsed_conditional>(p.get());
+}
+const parsed_identifier* as_parsed_identifier(const p_expr& p) {
+    return std::get_if<parsed_identifier>(p.get());
+}
+const parsed_float* as_parsed_float(const p_expr& p) {
+    return std::get_if<parsed_float>(p.get());
+}
+const parsed_int* as_parsed_int(const p_expr& p) {
+    return std::get_if<parsed_int>(p.get());
+}
+const parsed_unary* as_parsed_unary(const p_expr& p) {
+    return std::get_if<parsed_unary>(p.get());
+}
+const parsed_binary* as_parsed_binary(const p_expr& p) {
+    return std::get_if<parsed_binary>(p.get());
+}
 
 } // namespace al
 } // namespace parsed_ir
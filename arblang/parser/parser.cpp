@@ -1,12 +1,16 @@
+#include <algorithm>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <unordered_set>
 
 #include <fmt/core.h>
 #include <fmt/format.h>
 
 #include <arblang/parser/parser.hpp>
 #include <arblang/parser/token.hpp>
+#include <arblang/util/unique_name.hpp>
+#include <arblang/util/visitor.hpp>
 
 namespace al {
 
@@ -85,6 +89,9 @@ parsed_mechanism parser::parse_mechanism() {
             case tok::on_event:
                 m.on_events.push_back(parse_on_event());
                 break;
+            case tok::on_post:
+                m.post_events.push_back(parse_on_event());
+                break;
             case tok::param_export:
                 m.exports.push_back(parse_export());
                 break;
@@ -315,15 +322,16 @@ p_expr parser::parse_initial() {
     return make_pexpr<parsed_initial>(std::move(assign.first), std::move(assign.second), loc);
 }
 
-// An on_event of the form
+// An on_event or on_post of the form
 // `on_event`(`argument`[:`type`]) `identifier`[:`type`] = `value_expression`;
+// `on_post`(`argument`[:`type`]) `identifier`[:`type`] = `value_expression`;
 p_expr parser::parse_on_event() {
     auto t = current();
-    if (t.type != tok::on_event) {
-        throw std::runtime_error(fmt::format("Expected `on_event`, got {} at {}" + t.spelling, to_string(t.loc)));
+    if (t.type != tok::on_event && t.type != tok::on_post) {
+        throw std::runtime_error(fmt::format("Expected `on_event` or `on_post`, got {} at {}", t.spelling, to_string(t.loc)));
     }
     auto loc = t.loc;
-    t = next(); // consume 'on_event'
+    t = next(); // consume 'on_event' or 'on_post'
 
     if (t.type != tok::lparen) {
         throw std::runtime_error(fmt::format("Expected (, got {} at {}", t.spelling, to_string(t.loc)));
@@ -471,6 +479,8 @@ p_expr parser::parse_call() {
 
 // An object of the form:
 // [`name`] {`field0`[:`type0`] = `value_expression0`; `field1`[:`type1`] = `value_expression1`}
+// The fields may be interleaved with reaction clauses, which define the
+// derivatives of the species they involve (see `parse_reaction`).
 p_expr parser::parse_object() {
     auto t = current();
     auto loc = t.loc;
@@ -486,7 +496,19 @@ p_expr parser::parse_object() {
     t = next(); // consume '{'
 
     std::vector<p_expr> fields, values;
+    std::vector<parsed_reaction> reactions;
     while (t.type != tok::rbrace) {
+        if (t.type != tok::identifier || (peek().type != tok::eq && peek().type != tok::colon)) {
+            auto r = parse_reaction();
+            reactions.insert(reactions.end(), r.begin(), r.end());
+
+            t = current();
+            if (t.type != tok::semicolon) {
+                throw std::runtime_error(fmt::format("Expected ';' after reaction, got {}, {}", t.spelling, to_string(t.loc)));
+            }
+            t = next(); // consume ';'
+            continue;
+        }
         fields.emplace_back(parse_typed_identifier());
         t = current();
         if (t.type != tok::eq) {
@@ -508,9 +530,104 @@ p_expr parser::parse_object() {
     }
     next(); // consume '}'
 
+    if (!reactions.empty()) {
+        return lower_reactions(record_name, std::move(fields), std::move(values), reactions, loc);
+    }
     return make_pexpr<parsed_object>(record_name, std::move(fields), std::move(values), loc);
 }
 
+// A reaction clause of one of the forms:
+// `complex0` -> `complex1` (`value_expression`)
+// `complex0` <- `complex1` (`value_expression`)
+// `complex0` <-> `complex1` (`value_expression0`, `value_expression1`)
+// Returns the equivalent right reactions: one, or two for `<->`.
+std::vector<parsed_reaction> parser::parse_reaction() {
+    auto loc = current().loc;
+    auto lhs = parse_complex();
+
+    // `<-` is lexed as `<` followed by `-`, to keep comparisons such as
+    // `a<-b` valid.
+    auto t = current();
+    auto arrow = t.type;
+    if (arrow == tok::lt && peek().type == tok::minus) {
+        arrow = tok::left_arrow;
+        next(); // consume '<'
+    }
+    else if (arrow != tok::ret && arrow != tok::left_arrow && arrow != tok::arrow) {
+        throw std::runtime_error(fmt::format("Expected '->', '<-' or '<->', got {} at {}", t.spelling, to_string(t.loc)));
+    }
+    next(); // consume arrow
+
+    auto rhs = parse_complex();
+
+    t = current();
+    if (t.type != tok::lparen) {
+        throw std::runtime_error(fmt::format("Expected '(', got {} at {}", t.spelling, to_string(t.loc)));
+    }
+    next(); // consume '('
+
+    auto rate = parse_expr();
+    p_expr reverse_rate;
+    if (arrow == tok::arrow) {
+        t = current();
+        if (t.type != tok::comma) {
+            throw std::runtime_error(fmt::format("Expected ',' between forward and reverse rates, got {} at {}", t.spelling, to_string(t.loc)));
+        }
+        next(); // consume ','
+        reverse_rate = parse_expr();
+    }
+
+    t = current();
+    if (t.type != tok::rparen) {
+        throw std::runtime_error(fmt::format("Expected ')', got {} at {}", t.spelling, to_string(t.loc)));
+    }
+    next(); // consume ')'
+
+    switch (arrow) {
+        case tok::ret:        return {{lhs, rhs, rate, loc}};
+        case tok::left_arrow: return {{rhs, lhs, rate, loc}};
+        default:              return {{lhs, rhs, rate, loc}, {rhs, lhs, reverse_rate, loc}};
+    }
+}
+
+// A complex of the form:
+// `\0`
+// [`integer`]`species0` + [`integer`]`species1` + ...
+parsed_reaction::complex parser::parse_complex() {
+    auto t = current();
+    if (t.type == tok::empty_set) {
+        next(); // consume '\0'
+        return {};
+    }
+
+    parsed_reaction::complex species;
+    while (true) {
+        int multiplicity = 1;
+        if (t.type == tok::integer) {
+            multiplicity = std::stoi(t.spelling);
+            if (multiplicity < 1) {
+                throw std::runtime_error(fmt::format("Expected positive integer coefficient of species, got {} at {}", t.spelling, to_string(t.loc)));
+            }
+            t = next(); // consume integer
+        }
+        if (t.type != tok::identifier) {
+            throw std::runtime_error(fmt::format("Expected species identifier, got {} at {}", t.spelling, to_string(t.loc)));
+        }
+        auto it = std::find_if(species.begin(), species.end(), [&](const auto& s) {return s.first == t.spelling;});
+        if (it != species.end()) {
+            it->second += multiplicity;
+        }
+        else {
+            species.emplace_back(t.spelling, multiplicity);
+        }
+        t = next(); // consume identifier
+
+        if (t.type != tok::plus) break;
+        t = next(); // consume '+'
+    }
+    return species;
+}
+
 // A let expression of the form:
 // let `iden`[: `type`] = `value_expression0`; `value_expression1`
 p_expr parser::parse_let() {
@@ -1057,6 +1174,148 @@ p_unit parser::try_parse_unit(int prec) {
     return std::move(u);
 }
 
+// Insert the names of the identifiers referred to in `e` into `names`.
+static void referenced_names(const p_expr& e, std::unordered_set<std::string>& names) {
+    std::visit(al::util::overloaded {
+        [&](const parsed_identifier& c)  {names.insert(c.name);},
+        [&](const parsed_call& c)        {for (const auto& a: c.call_args) referenced_names(a, names);},
+        [&](const parsed_object& c)      {for (const auto& v: c.record_values) referenced_names(v, names);},
+        [&](const parsed_let& c)         {referenced_names(c.identifier, names);
+                                          referenced_names(c.value, names);
+                                          referenced_names(c.body, names);},
+        [&](const parsed_with& c)        {referenced_names(c.value, names);
+                                          referenced_names(c.body, names);},
+        [&](const parsed_conditional& c) {referenced_names(c.condition, names);
+                                          referenced_names(c.value_true, names);
+                                          referenced_names(c.value_false, names);},
+        [&](const parsed_unary& c)       {referenced_names(c.value, names);},
+        [&](const parsed_binary& c)      {referenced_names(c.lhs, names);
+                                          referenced_names(c.rhs, names);},
+        [&](const auto&) {}
+    }, *e);
+}
+
+// Translates the reactions L_i -> R_i (k_i) of a record literal to the field definitions
+//   a' = sum_i (m(a; R_i) - m(a; L_i))*k_i*prod(L_i)
+// where m(a; C) is the multiplicity of species `a` in complex C, and prod(C) is the
+// product of the species of C. Each distinct product, and the flux k_i*prod(L_i) of
+// each reaction are bound once by a let, and shared between the fields that use them:
+//   let _prod0 = a*a*b; let _flux0 = k_0*_prod0; ...; {a' = -2*_flux0 + ...; ...}
+p_expr parser::lower_reactions(std::optional<std::string> record_name,
+                               std::vector<p_expr> fields,
+                               std::vector<p_expr> values,
+                               const std::vector<parsed_reaction>& reactions,
+                               const src_location& loc)
+{
+    auto no_unit = [](){return make_punit<parsed_no_unit>();};
+    auto species_ref = [&](const std::string& name) {return make_pexpr<parsed_identifier>(name, loc);};
+
+    // The bound products and fluxes are in scope of the rates and of the
+    // field values: their names must differ from those referred to there.
+    std::unordered_set<std::string> reserved;
+    for (const auto& r: reactions) {
+        referenced_names(r.rate, reserved);
+        for (const auto* c: {&r.lhs, &r.rhs}) {
+            for (const auto& [s, m]: *c) reserved.insert(s);
+        }
+    }
+    for (const auto& v: values) {
+        referenced_names(v, reserved);
+    }
+
+    std::vector<std::pair<std::string, p_expr>> defs;
+    auto bind = [&](const std::string& prefix, p_expr value) {
+        auto name = unique_local_name(reserved, prefix);
+        defs.emplace_back(name, std::move(value));
+        return name;
+    };
+
+    // Products of the left complexes, and fluxes of the reactions.
+    std::vector<std::string> species;
+    std::vector<std::pair<parsed_reaction::complex, std::string>> products;
+    std::vector<std::string> fluxes;
+    for (const auto& r: reactions) {
+        for (const auto* c: {&r.lhs, &r.rhs}) {
+            for (const auto& [s, m]: *c) {
+                if (std::find(species.begin(), species.end(), s) == species.end()) species.push_back(s);
+            }
+        }
+
+        p_expr flux = r.rate;
+        if (!r.lhs.empty()) {
+            p_expr prod;
+            if (r.lhs.size() == 1 && r.lhs.front().second == 1) {
+                prod = species_ref(r.lhs.front().first);
+            }
+            else {
+                auto it = std::find_if(products.begin(), products.end(), [&](const auto& p) {return p.first == r.lhs;});
+                if (it == products.end()) {
+                    p_expr p;
+                    for (const auto& [s, m]: r.lhs) {
+                        for (int k = 0; k < m; ++k) {
+                            p = p? make_pexpr<parsed_binary>(binary_op::mul, p, species_ref(s), loc): species_ref(s);
+                        }
+                    }
+                    products.emplace_back(r.lhs, bind("prod", p));
+                    it = std::prev(products.end());
+                }
+                prod = species_ref(it->second);
+            }
+            flux = make_pexpr<parsed_binary>(binary_op::mul, flux, prod, loc);
+        }
+        fluxes.push_back(bind("flux", flux));
+    }
+
+    // The derivative of each species.
+    auto multiplicity = [](const parsed_reaction::complex& c, const std::string& s) {
+        auto it = std::find_if(c.begin(), c.end(), [&](const auto& p) {return p.first == s;});
+        return it == c.end()? 0: it->second;
+    };
+    for (const auto& s: species) {
+        auto field_name = s + "'";
+        for (const auto& f: fields) {
+            const auto& f_id = *as_parsed_identifier(f);
+            if (f_id.name == field_name) {
+                throw std::runtime_error(fmt::format("Field {} is defined explicitly, and by a reaction at {}",
+                                                     field_name, to_string(f_id.loc)));
+            }
+        }
+
+        p_expr deriv;
+        std::optional<unsigned> involved; // a reaction involving the species.
+        for (unsigned i = 0; i < reactions.size(); ++i) {
+            if (!involved && (multiplicity(reactions[i].rhs, s) || multiplicity(reactions[i].lhs, s))) involved = i;
+            int m = multiplicity(reactions[i].rhs, s) - multiplicity(reactions[i].lhs, s);
+            if (m == 0) continue;
+
+            p_expr term = species_ref(fluxes[i]);
+            if (std::abs(m) != 1) {
+                term = make_pexpr<parsed_binary>(binary_op::mul, make_pexpr<parsed_int>(std::abs(m), no_unit(), loc), term, loc);
+            }
+            if (!deriv) {
+                deriv = m > 0? term: make_pexpr<parsed_unary>(unary_op::neg, term, loc);
+            }
+            else {
+                deriv = make_pexpr<parsed_binary>(m > 0? binary_op::add: binary_op::sub, deriv, term, loc);
+            }
+        }
+        if (!deriv) {
+            // The net change of the species is zero, as for a catalyst. The zero
+            // is given the unit of a flux, that of the derivatives of the species.
+            deriv = make_pexpr<parsed_binary>(binary_op::mul, make_pexpr<parsed_int>(0, no_unit(), loc),
+                                              species_ref(fluxes[involved.value()]), loc);
+        }
+        fields.push_back(make_pexpr<parsed_identifier>(field_name, loc));
+        values.push_back(deriv);
+    }
+
+    p_expr body = make_pexpr<parsed_object>(record_name, std::move(fields), std::move(values), loc);
+    for (auto it = defs.rbegin(); it != defs.rend(); ++it) {
+        body = make_pexpr<parsed_let>(make_pexpr<parsed_identifier>(it->first, loc), it->second, body, loc);
+    }
+    return body;
+}
+
 std::pair<p_expr, p_expr> parser::parse_assignment()  {
     auto iden = parse_typed_identifier();
     auto t = current();
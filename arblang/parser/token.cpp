@@ -45,6 +45,7 @@ std::unordered_map<std::string, tok> token::keyword_to_token = {
     {"evolve",        tok::evolve},
     {"initial",       tok::initial},
     {"on_event",      tok::on_event},
+    {"on_post",       tok::on_post},
     {"export",        tok::param_export},
     {"density",       tok::density},
     {"bind",          tok::bind},
@@ -101,6 +102,8 @@ std::unordered_map<tok, std::string> token::token_to_string = {
     {tok::land,          "&&"},
     {tok::lor,           "||"},
     {tok::arrow,         "<->"},
+    {tok::left_arrow,    "<-"},
+    {tok::empty_set,     "\\0"},
     {tok::semicolon,     ";"},
     {tok::colon,         ":"},
     {tok::comma,         ","},
@@ -144,6 +147,7 @@ std::unordered_map<tok, std::string> token::token_to_string = {
     {tok::evolve,        "evolve"},
     {tok::initial,       "initial"},
     {tok::on_event,      "on_event"},
+    {tok::on_post,       "on_post"},
     {tok::param_export,  "export"},
     {tok::density,       "density"},
     {tok::bind,          "bind"},
@@ -4,6 +4,8 @@
 
 #include "arblang/pre_printer/check_mechanism.hpp"
 
+#include "../util/rexp_helpers.hpp"
+
 namespace al {
 namespace resolved_ir {
 
@@ -26,6 +28,10 @@ void check(const resolved_mechanism& e) {
         throw mech_error(fmt::format("Unsupported API call `on_events` for mechanism kind {} (mechanism {}).",
                                      to_string(e.kind), e.name));
     }
+    if (e.kind != mechanism_kind::point && !e.post_events.empty()) {
+        throw mech_error(fmt::format("Unsupported API call `post_events` for mechanism kind {} (mechanism {}).",
+                                     to_string(e.kind), e.name));
+    }
     if (!e.functions.empty()) {
         throw mech_error(fmt::format("Internal compiler error, expected zero functions after inlining."));
     }
@@ -34,7 +40,7 @@ void check(const resolved_mechanism& e) {
     }
 
     for (const auto& a: e.states) {
-        auto p = is_resolved_state(a);
+        auto p = as_resolved_state(a);
         if (!p) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_state in "
                                          "resolved_mechanism::states"));
@@ -54,7 +60,7 @@ void check(const resolved_mechanism& e) {
     std::unordered_set<std::string> const_params;
     std::unordered_set<std::string> assigned_params;
     for (const auto& a: e.parameters) {
-        auto p = is_resolved_parameter(a);
+        auto p = as_resolved_parameter(a);
         if (!p) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_parameter in "
                                          "resolved_mechanism::parameters"));
@@ -69,7 +75,7 @@ void check(const resolved_mechanism& e) {
                 }
             }
         }
-        if (is_resolved_int(p->value) || is_resolved_float(p->value)) {
+        if (is_trivial(p->value)) {
             const_params.insert(p->name);
         }
         else {
@@ -78,12 +84,12 @@ void check(const resolved_mechanism& e) {
     }
 
     for (const auto& a: e.exports) {
-        auto x = is_resolved_export(a);
+        auto x = as_resolved_export(a);
         if (!x) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_export in "
                                          "resolved_mechanism::exports"));
         }
-        auto p = is_resolved_argument(x->identifier);
+        auto p = as_resolved_argument(x->identifier);
         if (!p) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_argument as the identifier "
                                          "of a resolved_export"));
@@ -106,7 +112,7 @@ void check(const resolved_mechanism& e) {
     }
 
     for (const auto& a: e.bindings) {
-        auto b = is_resolved_bind(a);
+        auto b = as_resolved_bind(a);
         if (!b) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_bind in "
                                          "resolved_mechanism::bindings"));
@@ -125,7 +131,7 @@ void check(const resolved_mechanism& e) {
     }
 
     for (const auto& a: e.effects) {
-        auto b = is_resolved_effect(a);
+        auto b = as_resolved_effect(a);
         if (!b) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_effect in "
                                          "resolved_mechanism::effects"));
@@ -185,41 +191,58 @@ void check(const resolved_mechanism& e) {
     }
 
     for (const auto& a: e.initializations) {
-        auto init = is_resolved_initial(a);
+        auto init = as_resolved_initial(a);
         if (!init) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_initial in "
                                          "resolved_mechanism::initializations"));
         }
-        auto arg = is_resolved_argument(init->identifier);
+        auto arg = as_resolved_argument(init->identifier);
         if (!arg) {
             throw mech_error("Internal compiler error: expected identifier of resolved_initial to be a "
                              "resolved_argument.");
         }
     }
     for (const auto& a: e.on_events) {
-        auto on_event = is_resolved_on_event(a);
+        auto on_event = as_resolved_on_event(a);
         if (!on_event) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_on_event in "
                                          "resolved_mechanism::on_events"));
         }
-        auto arg = is_resolved_argument(on_event->argument);
+        auto arg = as_resolved_argument(on_event->argument);
+        if (!arg) {
+            throw mech_error("Internal compiler error: expected argument of resolved_on_event to be a "
+                             "resolved_argument.");
+        }
+        auto iden = as_resolved_argument(on_event->identifier);
+        if (!iden) {
+            throw mech_error("Internal compiler error: expected identifier of resolved_on_event to be a "
+                             "resolved_argument.");
+        }
+    }
+    for (const auto& a: e.post_events) {
+        auto on_event = as_resolved_on_event(a);
+        if (!on_event) {
+            throw mech_error(fmt::format("Internal compiler error, expected resolved_on_event in "
+                                         "resolved_mechanism::post_events"));
+        }
+        auto arg = as_resolved_argument(on_event->argument);
         if (!arg) {
             throw mech_error("Internal compiler error: expected argument of resolved_on_event to be a "
                              "resolved_argument.");
         }
-        auto iden = is_resolved_argument(on_event->identifier);
+        auto iden = as_resolved_argument(on_event->identifier);
         if (!iden) {
             throw mech_error("Internal compiler error: expected identifier of resolved_on_event to be a "
                              "resolved_argument.");
         }
     }
     for (const auto& a: e.evolutions) {
-        auto evolve = is_resolved_evolve(a);
+        auto evolve = as_resolved_evolve(a);
         if (!evolve) {
             throw mech_error(fmt::format("Internal compiler error, expected resolved_evolve in "
                                          "resolved_mechanism::evolutions"));
         }
-        auto arg = is_resolved_argument(evolve->identifier);
+        auto arg = as_resolved_argument(evolve->identifier);
         if (!arg) {
             throw mech_error("Internal compiler error: expected identifier of resolved_evolve to be a "
                              "resolved_argument.");
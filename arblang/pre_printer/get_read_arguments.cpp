@@ -25,8 +25,9 @@ void read_arguments(const resolved_function& e, std::vector<std::string>& vec) {
 }
 
 void read_arguments(const resolved_call& e, std::vector<std::string>& vec) {
-    throw std::runtime_error("Internal compiler error, didn't expect a resolved_call at "
-                             "this stage in the compilation (after inlining).");
+    for (const auto& a: e.call_args) {
+        read_arguments(a, vec);
+    }
 }
 
 void read_arguments(const resolved_state& e, std::vector<std::string>& vec) {
@@ -0,0 +1,158 @@
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include <arblang/pre_printer/linearity.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Linearity analysis: a value is linear in a set of variables if it is a sum
+// of the variables scaled by values that are constant in the variables.
+// Mixing constant and linear terms in a sum gives an affine, hence nonlinear, value.
+
+linearity join(linearity a, linearity b) {
+    if (a == b) return a;
+    return linearity::nonlinear;
+}
+
+// Linearity of an operation that is only linear if all of its operands are constant.
+linearity nonlinear_unless_constant(linearity a, linearity b = linearity::constant) {
+    if (a == linearity::constant && b == linearity::constant) return linearity::constant;
+    return linearity::nonlinear;
+}
+
+linearity classify_linearity(const resolved_record_alias& e, linearity_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_record_alias at "
+                             "this stage in the compilation (after resolution).");
+}
+
+linearity classify_linearity(const resolved_constant& e, linearity_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_constant at "
+                             "this stage in the compilation (after optimization).");
+}
+
+linearity classify_linearity(const resolved_function& e, linearity_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_function at "
+                             "this stage in the compilation (after inlining).");
+}
+
+linearity classify_linearity(const resolved_call& e, linearity_map& vars) {
+    auto result = linearity::constant;
+    for (const auto& a: e.call_args) {
+        result = join(result, classify_linearity(a, vars));
+    }
+    return nonlinear_unless_constant(result);
+}
+
+linearity classify_linearity(const resolved_state& e, linearity_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_state at "
+                             "this stage in the compilation (during printing prep).");
+}
+
+linearity classify_linearity(const resolved_bind& e, linearity_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_bind at "
+                             "this stage in the compilation (during printing prep).");
+}
+
+linearity classify_linearity(const resolved_export& e, linearity_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_export at "
+                             "this stage in the compilation (during printing prep).");
+}
+
+linearity classify_linearity(const resolved_field_access& e, linearity_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_field_access at "
+                             "this stage in the compilation (after simplification).");
+}
+
+linearity classify_linearity(const resolved_parameter& e, linearity_map& vars) {
+    return classify_linearity(e.value, vars);
+}
+
+linearity classify_linearity(const resolved_initial& e, linearity_map& vars) {
+    return classify_linearity(e.value, vars);
+}
+
+linearity classify_linearity(const resolved_on_event& e, linearity_map& vars) {
+    return classify_linearity(e.value, vars);
+}
+
+linearity classify_linearity(const resolved_evolve& e, linearity_map& vars) {
+    return classify_linearity(e.value, vars);
+}
+
+linearity classify_linearity(const resolved_effect& e, linearity_map& vars) {
+    return classify_linearity(e.value, vars);
+}
+
+linearity classify_linearity(const resolved_argument& e, linearity_map& vars) {
+    if (vars.count(e.name)) return vars.at(e.name);
+    return linearity::constant;
+}
+
+linearity classify_linearity(const resolved_variable& e, linearity_map& vars) {
+    if (vars.count(e.name)) return vars.at(e.name);
+    return classify_linearity(e.value, vars);
+}
+
+linearity classify_linearity(const resolved_object& e, linearity_map& vars) {
+    auto values = e.field_values();
+    if (values.empty()) return linearity::constant;
+
+    auto result = classify_linearity(values.front(), vars);
+    for (const auto& f: values) {
+        result = join(result, classify_linearity(f, vars));
+    }
+    return result;
+}
+
+linearity classify_linearity(const resolved_let& e, linearity_map& vars) {
+    vars[e.id_name()] = classify_linearity(e.id_value(), vars);
+    return classify_linearity(e.body, vars);
+}
+
+linearity classify_linearity(const resolved_conditional& e, linearity_map& vars) {
+    // Selecting between linear values is only linear if the selection doesn't depend on the variables.
+    if (classify_linearity(e.condition, vars) != linearity::constant) return linearity::nonlinear;
+    return join(classify_linearity(e.value_true, vars), classify_linearity(e.value_false, vars));
+}
+
+linearity classify_linearity(const resolved_float& e, linearity_map& vars) {
+    return linearity::constant;
+}
+
+linearity classify_linearity(const resolved_int& e, linearity_map& vars) {
+    return linearity::constant;
+}
+
+linearity classify_linearity(const resolved_unary& e, linearity_map& vars) {
+    auto arg = classify_linearity(e.arg, vars);
+    if (e.op == unary_op::neg) return arg;
+    return nonlinear_unless_constant(arg);
+}
+
+linearity classify_linearity(const resolved_binary& e, linearity_map& vars) {
+    auto lhs = classify_linearity(e.lhs, vars);
+    auto rhs = classify_linearity(e.rhs, vars);
+    switch (e.op) {
+        case binary_op::add:
+        case binary_op::sub:
+            return join(lhs, rhs);
+        case binary_op::mul:
+            if (lhs == linearity::constant) return rhs;
+            if (rhs == linearity::constant) return lhs;
+            return linearity::nonlinear;
+        case binary_op::div:
+            if (rhs == linearity::constant) return lhs;
+            return linearity::nonlinear;
+        default:
+            return nonlinear_unless_constant(lhs, rhs);
+    }
+}
+
+linearity classify_linearity(const r_expr& e, linearity_map& vars) {
+    return std::visit([&](auto&& c) {return classify_linearity(c, vars);}, *e);
+}
+
+} // namespace resolved_ir
+} // namespace al
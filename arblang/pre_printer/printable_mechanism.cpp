@@ -1,13 +1,19 @@
+#include <algorithm>
 #include <cassert>
 #include <string>
 #include <sstream>
 #include <unordered_map>
 
 #include <arblang/optimizer/optimizer.hpp>
+#include <arblang/optimizer/strength_reduce.hpp>
 #include <arblang/pre_printer/check_mechanism.hpp>
 #include <arblang/pre_printer/get_read_arguments.hpp>
+#include <arblang/pre_printer/linearity.hpp>
 #include <arblang/pre_printer/simplify.hpp>
 #include <arblang/pre_printer/printable_mechanism.hpp>
+#include <arblang/pre_printer/shared_values.hpp>
+#include <arblang/pre_printer/uniformity.hpp>
+#include <arblang/printer/print_expressions.hpp>
 #include <arblang/resolver/resolved_expressions.hpp>
 #include <arblang/solver/solve.hpp>
 
@@ -19,27 +25,37 @@ namespace al {
 namespace resolved_ir {
 
 // TODO Add support for nested param/state records.
-printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::string i_name, std::string g_name)
+printable_mechanism::printable_mechanism(const resolved_mechanism& mech,
+                                         std::string i_name,
+                                         std::string g_name,
+                                         const std::unordered_set<std::string>& uniform,
+                                         const std::unordered_set<std::string>& global,
+                                         const std::vector<resolved_table>& tabulated)
     : current_field_name_(std::move(i_name)), conductance_field_name_(std::move(g_name))
 {
     mech_kind = mech.kind;
     mech_name = mech.name;
 
+    for (auto t: tabulated) {
+        t.body = optimizer(simplify(t.body, {})).optimize();
+        tables.push_back(t);
+    }
+
     // Check that the mechanism can be printed
     check(mech);
 
     // Collect all possible writable variables.
     std::vector<std::pair<std::string, r_type>> mech_writables;
     for (const auto& s: mech.states) {
-        auto state = is_resolved_state(s).value();
+        const auto& state = *as_resolved_state(s);
         mech_writables.emplace_back(state.name, state.type);
     }
     for (const auto& e: mech.parameters) {
-        auto param = is_resolved_parameter(e).value();
+        const auto& param = *as_resolved_parameter(e);
         mech_writables.emplace_back(param.name, param.type);
     }
     for (const auto& e: mech.effects) {
-        auto effect = is_resolved_effect(e).value();
+        const auto& effect = *as_resolved_effect(e);
         mech_writables.emplace_back(effect_rec_name_, effect.type);
     }
 
@@ -60,7 +76,7 @@ printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::st
     // States
     write_map writable_variables;
     for (const auto& s: mech.states) {
-        auto state = is_resolved_state(s).value();
+        const auto& state = *as_resolved_state(s);
         auto state_name = state.name;
 
         // State variables can be written
@@ -84,7 +100,7 @@ printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::st
 
     // Parameters
     for (const auto& c: mech.parameters) {
-        auto param = is_resolved_parameter(c).value();
+        const auto& param = *as_resolved_parameter(c);
         auto param_name = param.name;
 
         // Parameters can be written (if they are a function of other parameters, i.e. not constant).
@@ -92,6 +108,17 @@ printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::st
         if (!param_rec) {
             auto val = is_number(param.value);
             auto type = is_resolved_quantity_type(param.type)->type;
+            if (global.count(param.name)) {
+                // Global parameters are constant: they are set by the simulator, not computed.
+                if (!val) {
+                    throw std::runtime_error(fmt::format("Cannot declare parameter {} global: its value is "
+                                                         "not a constant.", param.name));
+                }
+                field_pack.global_sources.emplace_back(param.name, val.value(), to_string(type));
+                pointer_map.insert({param.name, {prefix(param.name), storage_class::global}});
+                uniform_sources.insert(param.name);
+                continue;
+            }
             field_pack.param_sources.emplace_back(param.name, val.value_or(NAN), to_string(type));
             storage_info storage = {prefix(param.name), storage_class::internal};
             pointer_map.insert({param.name, storage});
@@ -100,7 +127,7 @@ printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::st
             }
         }
         else {
-            auto param_obj = is_resolved_object(param.value);
+            auto param_obj = as_resolved_object(param.value);
             if (!param_obj) {
                 throw std::runtime_error(fmt::format("Internal compiler error: Expected a resolved_object value "
                                                      "for parameter {}", param.name));
@@ -130,7 +157,7 @@ printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::st
     // Bindings
     std::unordered_map<std::string, unsigned> ion_idx;
     for (const auto& c: mech.bindings) {
-        auto bind = is_resolved_bind(c).value();
+        const auto& bind = *as_resolved_bind(c);
         auto bind_name = bind.name;
         if (bind.ion) bind_name += ("_" + bind.ion.value());
 
@@ -230,7 +257,7 @@ printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::st
 
     // TODO handle effects other than current_denisty_pair and current_pair
     for (const auto& c: mech.effects) {
-        auto eff = is_resolved_effect(c).value();
+        const auto& eff = *as_resolved_effect(c);
         if (eff.ion) {
             auto ion = eff.ion.value();
             if (!ion_idx.count(ion)) {
@@ -260,7 +287,7 @@ printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::st
     /**** Fill procedure_pack after a final simplification of the mechanism methods ****/
     auto p_mech = simplify_mech(mech, record_field_decoder);
     for (const auto& c: p_mech.parameters) {
-        auto param_value = is_resolved_parameter(c)->value;
+        auto param_value = as_resolved_parameter(c)->value;
         if (!is_trivial(param_value)) {
             procedure_pack.assigned_parameters.push_back(c);
         }
@@ -274,15 +301,43 @@ printable_mechanism::printable_mechanism(const resolved_mechanism& mech, std::st
     for (const auto& c: p_mech.on_events) {
         procedure_pack.on_events.push_back(c);
     }
+    for (const auto& c: p_mech.post_events) {
+        procedure_pack.post_events.push_back(c);
+    }
     for (const auto& c: p_mech.evolutions) {
         procedure_pack.evolutions.push_back(c);
     }
 
+    /**** Store values shared by the evolutions and effects ****/
+    cache_shared_values(uniform, writable_variables);
+
     /**** Fill proc_write_var maps ****/
     fill_write_maps(record_field_decoder, writable_variables);
 
     /**** Fill proc_read_var maps using ****/
     fill_read_maps();
+
+    /**** Check the linearity of the procedures before hoisting ****/
+    is_linear = check_linearity();
+
+    /**** Fill uniform_sources and prologue_pack ****/
+    for (const auto& g: global) {
+        if (!uniform_sources.count(g)) {
+            throw std::runtime_error(fmt::format("Cannot declare {} global: expected a scalar parameter of "
+                                                 "mechanism {}.", g, mech_name));
+        }
+    }
+    for (const auto& u: uniform) {
+        if (!pointer_map.count(u) || pointer_map.at(u).pointer_kind == storage_class::stream_member) {
+            throw std::runtime_error(fmt::format("Cannot declare {} uniform: expected a parameter or binding of "
+                                                 "mechanism {}.", u, mech_name));
+        }
+        if (std::find(field_pack.state_sources.begin(), field_pack.state_sources.end(), u) != field_pack.state_sources.end()) {
+            throw std::runtime_error(fmt::format("Cannot declare state {} uniform.", u));
+        }
+        uniform_sources.insert(u);
+    }
+    hoist_uniform_values();
 }
 
 record_field_map printable_mechanism::gen_record_field_map(const std::vector<std::pair<std::string, r_type>>& writables) {
@@ -315,8 +370,8 @@ void printable_mechanism::fill_write_maps(
     auto form_result = [](const std::string& id, const r_expr& val) {
         // Get innermost result of val
         r_expr result = val;
-        if (auto let_opt = is_resolved_let(val)) {
-            result = get_innermost_body(&let_opt.value());
+        if (auto let_opt = as_resolved_let(val)) {
+            result = get_innermost_body(let_opt);
         }
         return resolved_variable(id, result, type_of(result), location_of(result));
     };
@@ -329,11 +384,11 @@ void printable_mechanism::fill_write_maps(
                 [&](const resolved_argument& t) {return t.name;},
                 [&](const resolved_variable& t) {return t.name;},
                 [&](const resolved_int& t)      {return std::to_string(t.value);},
-                [&](const resolved_float& t)    {std::ostringstream os; os << t.value; return os.str();},
+                [&](const resolved_float& t)    {return double_literal(t.value);},
                 [&](const auto& t) {return std::string();}
         };
 
-        if (auto obj = is_resolved_object(result.value)) {
+        if (auto obj = as_resolved_object(result.value)) {
             // Only state variables can be objects because only they can have resolved_record type
             auto field_names  = obj->field_names();
             auto field_values = obj->field_values();
@@ -379,38 +434,46 @@ void printable_mechanism::fill_write_maps(
 
     // Fill the procedure-specific write maps.
     for (const auto& c: procedure_pack.initializations) {
-        auto init = is_resolved_initial(c).value();
+        const auto& init = *as_resolved_initial(c);
 
-        auto state_name = is_resolved_argument(init.identifier)->name;
+        auto state_name = as_resolved_argument(init.identifier)->name;
         auto state_assignment = form_result(state_name, init.value);
         write_var(state_assignment, init_write_map);
     }
 
     for (const auto& c: procedure_pack.on_events) {
-        auto init = is_resolved_on_event(c).value();
+        const auto& init = *as_resolved_on_event(c);
 
-        auto state_name = is_resolved_argument(init.identifier)->name;
+        auto state_name = as_resolved_argument(init.identifier)->name;
         auto state_assignment = form_result(state_name, init.value);
         write_var(state_assignment, event_write_map);
     }
 
+    for (const auto& c: procedure_pack.post_events) {
+        const auto& post = *as_resolved_on_event(c);
+
+        auto state_name = as_resolved_argument(post.identifier)->name;
+        auto state_assignment = form_result(state_name, post.value);
+        write_var(state_assignment, post_write_map);
+    }
+
     for (const auto& c: procedure_pack.evolutions) {
-        auto evolve = is_resolved_evolve(c).value();
+        const auto& evolve = *as_resolved_evolve(c);
 
-        auto state_name = is_resolved_argument(evolve.identifier)->name;
+        auto state_name = as_resolved_argument(evolve.identifier)->name;
         auto state_assignment  = form_result(state_name, evolve.value);
         write_var(state_assignment, evolve_write_map);
     }
 
     for (const auto& c: procedure_pack.effects) {
-        auto effect = is_resolved_effect(c).value();
+        const auto& effect = *as_resolved_effect(c);
 
         auto effect_assignment = form_result(effect_rec_name_, effect.value);
         write_var(effect_assignment, effect_write_map);
     }
 
     for (const auto& c: procedure_pack.assigned_parameters) {
-        auto param = is_resolved_parameter(c).value();
+        const auto& param = *as_resolved_parameter(c);
 
         auto param_name = param.name;
         auto param_assignment = form_result(param_name, param.value);
@@ -448,8 +511,8 @@ void printable_mechanism::fill_read_maps() {
     }
 
     for (const auto& c: procedure_pack.on_events) {
-        auto event = is_resolved_on_event(c).value();
-        auto arg   = is_resolved_argument(event.argument).value();
+        const auto& event = *as_resolved_on_event(c);
+        const auto& arg   = *as_resolved_argument(event.argument);
 
         std::vector<std::string> read_args;
         read_arguments(c, read_args);
@@ -468,6 +531,27 @@ void printable_mechanism::fill_read_maps() {
         }
     }
 
+    for (const auto& c: procedure_pack.post_events) {
+        const auto& post = *as_resolved_on_event(c);
+        const auto& arg  = *as_resolved_argument(post.argument);
+
+        std::vector<std::string> read_args;
+        read_arguments(c, read_args);
+
+        for (const auto& a: read_args) {
+            if (a == arg.name) {
+                // this is the time since the spike, provided by the simulator in ms
+                post_read_map.insert({a, {"time_since_spike", storage_class::stream_member, {}, 1e-3}});
+            }
+            else if (pointer_map.count(a)) {
+                post_read_map.insert({a, pointer_map.at(a)});
+            }
+            else {
+                throw std::runtime_error("Internal compiler error: can not find parameter that is being read.");
+            }
+        }
+    }
+
     for (const auto& c: procedure_pack.evolutions) {
         std::vector<std::string> read_args;
         read_arguments(c, read_args);
@@ -495,29 +579,222 @@ void printable_mechanism::fill_read_maps() {
     }
 }
 
+bool printable_mechanism::check_linearity() const {
+    linearity_map states;
+    for (const auto& s: field_pack.state_sources) {
+        states[s] = linearity::linear;
+    }
+
+    for (const auto& c: procedure_pack.evolutions) {
+        auto vars = states;
+        if (classify_linearity(c, vars) != linearity::linear) return false;
+    }
+    for (const auto& c: procedure_pack.on_events) {
+        // The event weight scales the update like a state does.
+        auto vars = states;
+        vars[as_resolved_argument(as_resolved_on_event(c)->argument)->name] = linearity::linear;
+        if (classify_linearity(c, vars) != linearity::linear) return false;
+    }
+    for (const auto& c: procedure_pack.post_events) {
+        auto vars = states;
+        if (classify_linearity(c, vars) != linearity::linear) return false;
+    }
+    for (const auto& c: procedure_pack.effects) {
+        auto vars = states;
+        if (classify_linearity(c, vars) != linearity::linear) return false;
+    }
+    return true;
+}
+
+// Arbor calls advance_state after updating the membrane potential, and
+// compute_currents at the start of the next time step with the same membrane
+// potential. Values computed by both kernels from the membrane potential and
+// parameters alone can be stored per instance by advance_state, and loaded by
+// compute_currents, if that is cheaper than computing them again. init stores
+// them for the first time step.
+void printable_mechanism::cache_shared_values(const std::unordered_set<std::string>& uniform, write_map& writable_variables) {
+    // Storing a value in advance_state and loading it in compute_currents,
+    // relative to the cost of an addition.
+    const int cache_cost = 8;
+
+    // The sources that can't change between advance_state and compute_currents.
+    std::unordered_set<std::string> stable_sources;
+    std::optional<std::string> voltage;
+    for (const auto& [name, val, unit]: field_pack.param_sources) {
+        stable_sources.insert(name);
+    }
+    for (const auto& [name, val, unit]: field_pack.global_sources) {
+        stable_sources.insert(name);
+    }
+    for (const auto& [name, bind, ion]: field_pack.bind_sources) {
+        if (ion) continue;
+        if (bind == bindable::membrane_potential) voltage = name;
+        if (bind == bindable::membrane_potential || bind == bindable::temperature) stable_sources.insert(name);
+    }
+    // Values shared by all instances are better hoisted.
+    if (!voltage || uniform.count(voltage.value())) return;
+
+    value_numbering numbering;
+    std::unordered_map<unsigned, std::pair<std::string, r_expr>> evolved; // value number to binding and evolution
+    for (const auto& c: procedure_pack.evolutions) {
+        auto value = as_resolved_evolve(c)->value;
+        for (const auto& [name, n]: numbering.number(value)) {
+            evolved.insert({n, {name, value}});
+        }
+    }
+    auto cacheable = [&](unsigned n) {
+        const auto& reads = numbering.reads(n);
+        return evolved.count(n) && reads.count(voltage.value()) &&
+               std::all_of(reads.begin(), reads.end(), [&](const auto& r) {return stable_sources.count(r);});
+    };
+
+    // Cache the shared values of the effects one at a time, starting from the
+    // result, if that saves more than it costs: the bindings needed to compute
+    // a cached value may still be needed by other bindings.
+    std::vector<std::pair<unsigned, std::string>> cached;
+    std::unordered_map<unsigned, r_expr> cache_args;
+
+    // The cached values are stored as internal state variables, named
+    // `_cache<n>`: neither an identifier of the mechanism, which starts with
+    // a letter, nor a field of a record state, `_<state>_<field>`.
+    auto cache_name = [&]() {
+        for (unsigned k = 0; ; ++k) {
+            auto name = fmt::format("_cache{}", k);
+            bool used = pointer_map.count(name) ||
+                        std::any_of(cached.begin(), cached.end(), [&](const auto& c) {return c.second == name;});
+            if (!used) return name;
+        }
+    };
+    for (auto& c: procedure_pack.effects) {
+        bool made_change = true;
+        while (made_change) {
+            made_change = false;
+            const auto& effect = *as_resolved_effect(c);
+            auto numbers = numbering.number(effect.value);
+
+            std::vector<resolved_let> chain;
+            for (auto let = as_resolved_let(effect.value); let; let = as_resolved_let(let->body)) {
+                chain.push_back(*let);
+            }
+            for (auto it = chain.rbegin(); it != chain.rend() && !made_change; ++it) {
+                auto name = it->id_name();
+                if (!numbers.count(name) || !cacheable(numbers.at(name))) continue;
+
+                auto n = numbers.at(name);
+                auto arg = cache_args.count(n)? cache_args.at(n):
+                           make_rexpr<resolved_argument>(cache_name(), type_of(it->id_value()), it->loc);
+                auto value = replace_let_values(effect.value, {{name, arg}});
+                auto candidate = optimizer(make_rexpr<resolved_effect>(effect.effect, effect.ion, value, effect.type, effect.loc)).optimize();
+
+                auto savings = (int)estimated_cost(c) - (int)estimated_cost(candidate);
+                if (savings <= cache_cost) continue;
+                if (!cache_args.count(n)) {
+                    cached.emplace_back(n, as_resolved_argument(arg)->name);
+                    cache_args.insert({n, arg});
+                }
+                c = candidate;
+                made_change = true;
+            }
+        }
+    }
+    if (cached.empty()) return;
+
+    std::unordered_map<unsigned, std::string> initialized;
+    for (const auto& c: procedure_pack.initializations) {
+        for (const auto& [name, n]: numbering.number(as_resolved_initial(c)->value)) {
+            initialized.insert({n, name});
+        }
+    }
+
+    for (const auto& [n, cache_name]: cached) {
+        storage_info storage = {prefix(cache_name), storage_class::internal};
+        pointer_map.insert({cache_name, storage});
+        field_pack.cache_sources.push_back(cache_name);
+
+        const auto& [evolve_name, evolve_value] = evolved.at(n);
+        evolve_write_map.insert({evolve_name, storage});
+
+        if (initialized.count(n)) {
+            init_write_map.insert({initialized.at(n), storage});
+        }
+        else {
+            // Compute the value in init, with its own copy of the bindings it needs.
+            auto arg = cache_args.at(n);
+            auto value = extract_let_chain(evolve_value, evolve_name, cache_name);
+            procedure_pack.initializations.push_back(
+                make_rexpr<resolved_initial>(arg, value, type_of(arg), location_of(arg)));
+            writable_variables.insert({cache_name, storage});
+        }
+    }
+}
+
+void printable_mechanism::hoist_uniform_values() {
+    auto hoist = [&](std::vector<r_expr>& procedures, const read_map& reads, std::vector<r_expr>& prologue) {
+        variability_map vars;
+        for (const auto& [var, ptr]: reads) {
+            if (uniform_sources.count(var)) {
+                vars[var] = variability::uniform;
+            }
+            else if (ptr.pointer_kind == storage_class::external || ptr.pointer_kind == storage_class::ionic) {
+                vars[var] = variability::per_node;
+            }
+            else {
+                vars[var] = variability::per_instance;
+            }
+        }
+        for (auto& p: procedures) {
+            classify_variability(p, vars);
+            p = hoist_uniform(p, vars, prologue);
+        }
+    };
+
+    // Assigned parameters and initializations share the init kernel.
+    hoist(procedure_pack.assigned_parameters, init_read_map, prologue_pack.init);
+    hoist(procedure_pack.initializations, init_read_map, prologue_pack.init);
+    hoist(procedure_pack.on_events, event_read_map, prologue_pack.on_events);
+    hoist(procedure_pack.post_events, post_read_map, prologue_pack.post_events);
+    hoist(procedure_pack.effects, effect_read_map, prologue_pack.effects);
+    hoist(procedure_pack.evolutions, evolve_read_map, prologue_pack.evolutions);
+}
+
 resolved_mechanism printable_mechanism::simplify_mech(const resolved_mechanism& mech, const record_field_map& field_map) {
     resolved_mechanism s_mech;
 
+    // Strength reduction runs on the optimized expressions; the copies
+    // it introduces are cleaned up by a second round of optimization.
+    // Procedures can end up in the same kernel, so the names of the
+    // introduced variables are reserved across the whole mechanism.
+    std::unordered_set<std::string> reserved;
+    auto reduce = [&reserved](const r_expr& e) {
+        auto result = strength_reduce(e, reserved);
+        if (!result.second) return e;
+        return optimizer(result.first).optimize();
+    };
+
     std::vector<r_expr> param_exprs;
     for (const auto& c: mech.parameters) {
         auto opt = optimizer(simplify(c, {}));
-        param_exprs.push_back(opt.optimize());
+        param_exprs.push_back(reduce(opt.optimize()));
     }
     for (const auto& c: mech.effects) {
         auto opt = optimizer(simplify(c, field_map));
-        s_mech.effects.push_back(opt.optimize());
+        s_mech.effects.push_back(reduce(opt.optimize()));
     }
     for (const auto& c: mech.initializations) {
         auto opt = optimizer(simplify(c, field_map));
-        s_mech.initializations.push_back(opt.optimize());
+        s_mech.initializations.push_back(reduce(opt.optimize()));
     }
     for (const auto& c: mech.on_events) {
         auto opt = optimizer(simplify(c, field_map));
-        s_mech.on_events.push_back(opt.optimize());
+        s_mech.on_events.push_back(reduce(opt.optimize()));
+    }
+    for (const auto& c: mech.post_events) {
+        auto opt = optimizer(simplify(c, field_map));
+        s_mech.post_events.push_back(reduce(opt.optimize()));
     }
     for (const auto& c: mech.evolutions) {
         auto opt = optimizer(simplify(c, field_map));
-        s_mech.evolutions.push_back(opt.optimize());
+        s_mech.evolutions.push_back(reduce(opt.optimize()));
     }
 
     // If a parameter reads from another parameter:
@@ -532,11 +809,11 @@ resolved_mechanism printable_mechanism::simplify_mech(const resolved_mechanism&
     std::unordered_map<std::string, r_expr> param_map;
     for (const auto& c: param_exprs) {
         s_mech.parameters.push_back(copy_propagate(c, param_map).first);
-        auto param = is_resolved_parameter(c).value();
+        const auto& param = *as_resolved_parameter(c);
         if (!is_trivial(param.value)) {
             r_expr result = param.value;
-            if (auto let_opt = is_resolved_let(param.value)) {
-                result = get_innermost_body(&let_opt.value());
+            if (auto let_opt = as_resolved_let(param.value)) {
+                result = get_innermost_body(let_opt);
             }
             param_map.insert({param.name, result});
         }
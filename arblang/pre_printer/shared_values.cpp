@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <arblang/pre_printer/shared_values.hpp>
+#include <arblang/util/op_count.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+unsigned estimated_cost(const r_expr& e) {
+    auto c = count_ops(e);
+    return c.add + c.mul + c.cmp + 4*c.div + 20*c.fn;
+}
+
+std::vector<resolved_let> flatten_let_chain(const r_expr& e) {
+    std::vector<resolved_let> chain;
+    auto let = as_resolved_let(e);
+    while (let) {
+        chain.push_back(*let);
+        let = as_resolved_let(let->body);
+    }
+    return chain;
+}
+
+std::set<std::string> value_numbering::reads_of(const r_expr& e) const {
+    if (auto v = as_resolved_variable(e)) {
+        if (bound_.count(v->name)) return reads_.at(bound_.at(v->name));
+        return {};
+    }
+    if (auto a = as_resolved_argument(e)) return {a->name};
+
+    std::vector<r_expr> operands;
+    if (auto u = as_resolved_unary(e)) operands = {u->arg};
+    else if (auto b = as_resolved_binary(e)) operands = {b->lhs, b->rhs};
+    else if (auto c = as_resolved_call(e)) operands = c->call_args;
+    else if (auto c = as_resolved_conditional(e)) operands = {c->condition, c->value_true, c->value_false};
+    else if (auto f = as_resolved_field_access(e)) operands = {f->object};
+
+    std::set<std::string> result;
+    for (const auto& o: operands) {
+        auto r = reads_of(o);
+        result.insert(r.begin(), r.end());
+    }
+    return result;
+}
+
+std::unordered_map<std::string, value_numbering::id> value_numbering::number(const r_expr& e) {
+    // The names of the bindings are only unique within a procedure.
+    values_.clear_bindings();
+    bound_.clear();
+    for (const auto& l: flatten_let_chain(e)) {
+        if (auto n = values_.intern(l.id_value())) {
+            if (!reads_.count(n.value())) {
+                reads_.insert({n.value(), reads_of(l.id_value())});
+            }
+            values_.bind(l.id_name(), n.value());
+            bound_.insert({l.id_name(), n.value()});
+        }
+    }
+    return bound_;
+}
+
+r_expr replace_let_values(const r_expr& e, const std::unordered_map<std::string, r_expr>& values) {
+    auto chain = flatten_let_chain(e);
+    if (chain.empty()) return e;
+
+    auto result = chain.back().body;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        auto name = it->id_name();
+        auto value = values.count(name)? values.at(name): it->id_value();
+        result = make_rexpr<resolved_let>(name, value, result, it->type, it->loc);
+    }
+    return result;
+}
+
+// Rebuild `e` with its variables renamed. Only expects the values of numbered bindings.
+r_expr rename_variables(const r_expr& e, const std::unordered_map<std::string, r_expr>& renamed, std::set<std::string>& used) {
+    if (auto v = as_resolved_variable(e)) {
+        used.insert(v->name);
+        return renamed.count(v->name)? renamed.at(v->name): e;
+    }
+    if (auto u = as_resolved_unary(e)) {
+        return make_rexpr<resolved_unary>(u->op, rename_variables(u->arg, renamed, used), u->type, u->loc);
+    }
+    if (auto b = as_resolved_binary(e)) {
+        return make_rexpr<resolved_binary>(b->op, rename_variables(b->lhs, renamed, used),
+                                           rename_variables(b->rhs, renamed, used), b->type, b->loc);
+    }
+    if (auto c = as_resolved_call(e)) {
+        std::vector<r_expr> args;
+        for (const auto& a: c->call_args) {
+            args.push_back(rename_variables(a, renamed, used));
+        }
+        return make_rexpr<resolved_call>(c->f_identifier, args, c->type, c->loc);
+    }
+    return e;
+}
+
+r_expr extract_let_chain(const r_expr& e, const std::string& name, const std::string& prefix) {
+    auto chain = flatten_let_chain(e);
+    auto last = std::find_if(chain.begin(), chain.end(), [&](const auto& l) {return l.id_name() == name;});
+    if (last == chain.end()) {
+        throw std::runtime_error(fmt::format("Internal compiler error: can not find binding {} to extract.", name));
+    }
+    chain.erase(last+1, chain.end());
+
+    // Find the bindings needed to compute `name`.
+    std::set<std::string> needed = {name};
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (needed.count(it->id_name())) {
+            rename_variables(it->id_value(), {}, needed);
+        }
+    }
+
+    std::vector<std::pair<std::string, r_expr>> bindings;
+    std::unordered_map<std::string, r_expr> renamed;
+    std::set<std::string> used;
+    for (const auto& l: chain) {
+        if (!needed.count(l.id_name())) continue;
+        auto value = rename_variables(l.id_value(), renamed, used);
+        auto new_name = prefix + l.id_name();
+        bindings.emplace_back(new_name, value);
+        renamed.insert({l.id_name(), make_rexpr<resolved_variable>(new_name, value, type_of(value), location_of(value))});
+    }
+
+    auto result = renamed.at(name);
+    for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+        result = make_rexpr<resolved_let>(it->first, it->second, result, type_of(result), location_of(it->second));
+    }
+    return result;
+}
+
+} // namespace resolved_ir
+} // namespace al
@@ -32,8 +32,11 @@ r_expr simplify(const resolved_function& e, const record_field_map& map, std::un
 }
 
 r_expr simplify(const resolved_call& e, const record_field_map& map, std::unordered_map<std::string, r_expr>& rewrites) {
-    throw std::runtime_error("Internal compiler error, didn't expect a resolved_call at "
-                             "this stage in the compilation (after inlining).");
+    std::vector<r_expr> args;
+    for (const auto& a: e.call_args) {
+        args.push_back(simplify(a, map, rewrites));
+    }
+    return make_rexpr<resolved_call>(e.f_identifier, args, simplify(e.type), e.loc);
 }
 
 r_expr simplify(const resolved_state& e, const record_field_map& map, std::unordered_map<std::string, r_expr>& rewrites) {
@@ -161,7 +164,7 @@ r_expr simplify(const resolved_binary& e, const record_field_map& map, std::unor
 }
 
 r_expr simplify(const resolved_field_access& e, const record_field_map& map, std::unordered_map<std::string, r_expr>& rewrites) {
-    if (auto arg = is_resolved_argument(e.object)) {
+    if (auto arg = as_resolved_argument(e.object)) {
         // Should be referring to a state
         if (!map.count(arg->name)) {
             throw std::runtime_error(fmt::format("Internal compiler error, object of resolved_field_access "
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <arblang/pre_printer/uniformity.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+// Uniformity analysis: a let-binding is as variable as the most variable
+// of its operands. Uniform let-bindings can be computed once per kernel call
+// rather than once per instance.
+
+variability combine(variability a, variability b) {
+    return std::max(a, b);
+}
+
+variability classify_variability(const resolved_record_alias& e, variability_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_record_alias at "
+                             "this stage in the compilation (after resolution).");
+}
+
+variability classify_variability(const resolved_constant& e, variability_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_constant at "
+                             "this stage in the compilation (after optimization).");
+}
+
+variability classify_variability(const resolved_function& e, variability_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_function at "
+                             "this stage in the compilation (after inlining).");
+}
+
+// A tabulated function only depends on its arguments.
+variability classify_variability(const resolved_call& e, variability_map& vars) {
+    auto result = variability::uniform;
+    for (const auto& a: e.call_args) {
+        result = combine(result, classify_variability(a, vars));
+    }
+    return result;
+}
+
+variability classify_variability(const resolved_state& e, variability_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_state at "
+                             "this stage in the compilation (during printing prep).");
+}
+
+variability classify_variability(const resolved_bind& e, variability_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_bind at "
+                             "this stage in the compilation (during printing prep).");
+}
+
+variability classify_variability(const resolved_export& e, variability_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_export at "
+                             "this stage in the compilation (during printing prep).");
+}
+
+variability classify_variability(const resolved_field_access& e, variability_map& vars) {
+    throw std::runtime_error("Internal compiler error, didn't expect a resolved_field_access at "
+                             "this stage in the compilation (after simplification).");
+}
+
+variability classify_variability(const resolved_parameter& e, variability_map& vars) {
+    return classify_variability(e.value, vars);
+}
+
+variability classify_variability(const resolved_initial& e, variability_map& vars) {
+    return classify_variability(e.value, vars);
+}
+
+variability classify_variability(const resolved_on_event& e, variability_map& vars) {
+    return classify_variability(e.value, vars);
+}
+
+variability classify_variability(const resolved_evolve& e, variability_map& vars) {
+    return classify_variability(e.value, vars);
+}
+
+variability classify_variability(const resolved_effect& e, variability_map& vars) {
+    return classify_variability(e.value, vars);
+}
+
+variability classify_variability(const resolved_argument& e, variability_map& vars) {
+    if (vars.count(e.name)) return vars.at(e.name);
+    return variability::per_instance;
+}
+
+variability classify_variability(const resolved_variable& e, variability_map& vars) {
+    if (vars.count(e.name)) return vars.at(e.name);
+    return classify_variability(e.value, vars);
+}
+
+variability classify_variability(const resolved_object& e, variability_map& vars) {
+    auto result = variability::uniform;
+    for (const auto& f: e.field_values()) {
+        result = combine(result, classify_variability(f, vars));
+    }
+    return result;
+}
+
+variability classify_variability(const resolved_let& e, variability_map& vars) {
+    vars[e.id_name()] = classify_variability(e.id_value(), vars);
+    return classify_variability(e.body, vars);
+}
+
+variability classify_variability(const resolved_conditional& e, variability_map& vars) {
+    auto result = classify_variability(e.condition, vars);
+    result = combine(result, classify_variability(e.value_true, vars));
+    return combine(result, classify_variability(e.value_false, vars));
+}
+
+variability classify_variability(const resolved_float& e, variability_map& vars) {
+    return variability::uniform;
+}
+
+variability classify_variability(const resolved_int& e, variability_map& vars) {
+    return variability::uniform;
+}
+
+variability classify_variability(const resolved_unary& e, variability_map& vars) {
+    return classify_variability(e.arg, vars);
+}
+
+variability classify_variability(const resolved_binary& e, variability_map& vars) {
+    return combine(classify_variability(e.lhs, vars), classify_variability(e.rhs, vars));
+}
+
+variability classify_variability(const r_expr& e, variability_map& vars) {
+    return std::visit([&](auto&& c) {return classify_variability(c, vars);}, *e);
+}
+
+r_expr hoist_uniform_let(const r_expr& e, const variability_map& vars, std::vector<r_expr>& hoisted) {
+    auto let = as_resolved_let(e);
+    if (!let) return e;
+
+    auto body = hoist_uniform_let(let->body, vars, hoisted);
+    auto name = let->id_name();
+    if (vars.count(name) && vars.at(name) == variability::uniform) {
+        // The hoisted binding is its own body: only the binding itself gets printed.
+        hoisted.push_back(make_rexpr<resolved_let>(let->identifier, let->identifier, let->type, let->loc));
+        return body;
+    }
+    return make_rexpr<resolved_let>(let->identifier, body, let->type, let->loc);
+}
+
+r_expr hoist_uniform(const r_expr& e, const variability_map& vars, std::vector<r_expr>& hoisted) {
+    // Bindings are visited innermost first; restore the order of definition.
+    std::vector<r_expr> bindings;
+    r_expr result;
+    if (auto p = as_resolved_parameter(e)) {
+        auto val = hoist_uniform_let(p->value, vars, bindings);
+        result = make_rexpr<resolved_parameter>(p->name, val, p->type, p->loc);
+    }
+    else if (auto p = as_resolved_initial(e)) {
+        auto val = hoist_uniform_let(p->value, vars, bindings);
+        result = make_rexpr<resolved_initial>(p->identifier, val, p->type, p->loc);
+    }
+    else if (auto p = as_resolved_on_event(e)) {
+        auto val = hoist_uniform_let(p->value, vars, bindings);
+        result = make_rexpr<resolved_on_event>(p->argument, p->identifier, val, p->type, p->loc);
+    }
+    else if (auto p = as_resolved_evolve(e)) {
+        auto val = hoist_uniform_let(p->value, vars, bindings);
+        result = make_rexpr<resolved_evolve>(p->identifier, val, p->type, p->loc);
+    }
+    else if (auto p = as_resolved_effect(e)) {
+        auto val = hoist_uniform_let(p->value, vars, bindings);
+        result = make_rexpr<resolved_effect>(p->effect, p->ion, val, p->type, p->loc);
+    }
+    else {
+        throw std::runtime_error(fmt::format("Internal compiler error, expected a mechanism procedure "
+                                             "when hoisting uniform values at {}.", to_string(location_of(e))));
+    }
+    hoisted.insert(hoisted.end(), bindings.rbegin(), bindings.rend());
+    return result;
+}
+
+} // namespace resolved_ir
+} // namespace al
@@ -1,253 +1,310 @@
+#include <cmath>
 #include <string>
 #include <sstream>
 
 #include <fmt/core.h>
 
+#include <arblang/optimizer/tabulate.hpp>
 #include <arblang/printer/print_expressions.hpp>
 
 namespace al {
 namespace resolved_ir {
 
-void print_non_trivial_expression(const r_expr& e, std::stringstream& out, const std::string& indent) {
-    if (is_resolved_let(e)) {
-        print_expression(e, out, indent);
+// In SIMD mode, math functions are taken from arbor's SIMD library, and
+// their arguments are converted to SIMD values, as literals and values
+// hoisted out of the loop are scalars.
+// In fast math mode, the scalar exp, log and exprelr are replaced by the
+// approximations printed at the top of the generated file.
+std::string function_name(const std::string& name, const printer_options& opt) {
+    if (opt.simd) return "S::" + name;
+    if (opt.fast_math && (name == "exp" || name == "log" || name == "exprelr")) return "fast_" + name;
+    return name;
+}
+
+void print_function_argument(const r_expr& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    if (opt.simd) {
+        out << "simd_value(";
+        print_expression(e, out, indent, opt);
+        out << ")";
+        return;
+    }
+    print_expression(e, out, indent, opt);
+}
+
+void print_non_trivial_expression(const r_expr& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    if (as_resolved_let(e)) {
+        print_expression(e, out, indent, opt);
     }
 }
 
-void print_expression(const resolved_record_alias& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_record_alias& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     throw std::runtime_error("Internal compiler error, didn't expect a resolved_record_alias at "
                              "this stage in the compilation (after resolution).");
 }
-void print_expression(const resolved_constant& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_constant& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     throw std::runtime_error("Internal compiler error, didn't expect a resolved_constant at "
                              "this stage in the compilation (after optimization).");
 }
 
-void print_expression(const resolved_function& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_function& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     throw std::runtime_error("Internal compiler error, didn't expect a resolved_function at "
                              "this stage in the compilation (after inlining).");
 }
 
-void print_expression(const resolved_call& e, std::stringstream& out, const std::string& indent) {
-    throw std::runtime_error("Internal compiler error, didn't expect a resolved_call at "
-                             "this stage in the compilation (after inlining).");
+void print_expression(const resolved_call& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    out << table_name(e.f_identifier) << "(";
+    bool first = true;
+    for (const auto& a: e.call_args) {
+        if (!first) out << ", ";
+        print_function_argument(a, out, indent, opt);
+        first = false;
+    }
+    out << ")";
 }
 
-void print_expression(const resolved_state& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_state& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     throw std::runtime_error("Internal compiler error, didn't expect a resolved_state at "
                              "this stage in the compilation (during printing prep).");
 }
 
-void print_expression(const resolved_bind& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_bind& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     throw std::runtime_error("Internal compiler error, didn't expect a resolved_bind at "
                              "this stage in the compilation (during printing prep).");
 }
 
-void print_expression(const resolved_export& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_export& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     throw std::runtime_error("Internal compiler error, didn't expect a resolved_export at "
                              "this stage in the compilation (during printing prep).");
 }
 
-void print_expression(const resolved_field_access& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_field_access& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     throw std::runtime_error("Internal compiler error, didn't expect a resolved_field_access at "
                              "this stage in the compilation (after printing prep).");
 }
 
-void print_expression(const resolved_parameter& e, std::stringstream& out, const std::string& indent) {
-    print_non_trivial_expression(e.value, out, indent);
+void print_expression(const resolved_parameter& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    print_non_trivial_expression(e.value, out, indent, opt);
 }
 
-void print_expression(const resolved_initial& e, std::stringstream& out, const std::string& indent) {
-    print_non_trivial_expression(e.value, out, indent);
+void print_expression(const resolved_initial& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    print_non_trivial_expression(e.value, out, indent, opt);
 }
 
-void print_expression(const resolved_on_event& e, std::stringstream& out, const std::string& indent) {
-    print_non_trivial_expression(e.value, out, indent);
+void print_expression(const resolved_on_event& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    print_non_trivial_expression(e.value, out, indent, opt);
 }
 
-void print_expression(const resolved_evolve& e, std::stringstream& out, const std::string& indent) {
-    print_non_trivial_expression(e.value, out, indent);
+void print_expression(const resolved_evolve& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    print_non_trivial_expression(e.value, out, indent, opt);
 }
 
-void print_expression(const resolved_effect& e, std::stringstream& out, const std::string& indent) {
-    print_non_trivial_expression(e.value, out, indent);
+void print_expression(const resolved_effect& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    print_non_trivial_expression(e.value, out, indent, opt);
 }
 
-void print_expression(const resolved_argument& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_argument& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     out << e.name;
 }
 
-void print_expression(const resolved_variable& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_variable& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     out << e.name;
 }
 
-void print_expression(const resolved_object& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_object& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     // Don't do anything. We should only encounter object for the final body of a
     // let statement or nested let statements. This is handled in print_mechanism.
 }
 
-void print_expression(const resolved_let& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_let& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     auto name = e.id_name();
     auto val  = e.id_value();
-    out << indent << "auto " << name << " = ";
-    print_expression(val, out, indent);
-    out << ";\n";
+    auto cond = as_resolved_conditional(val);
+    if (opt.simd && cond) {
+        // Masked assignment: start from the false branch and overwrite
+        // the lanes where the condition holds.
+        out << indent << "simd_value " << name << " = simd_value(";
+        print_expression(cond->value_false, out, indent, opt);
+        out << ");\n";
+        out << indent << "S::where(simd_mask(";
+        print_expression(cond->condition, out, indent, opt);
+        out << "), " << name << ") = simd_value(";
+        print_expression(cond->value_true, out, indent, opt);
+        out << ");\n";
+    }
+    else {
+        out << indent << "auto " << name << " = ";
+        print_expression(val, out, indent, opt);
+        out << ";\n";
+    }
 
     // only print the body if it another let statement
-    if (is_resolved_let(e.body)) {
-        print_expression(e.body, out, indent);
+    if (as_resolved_let(e.body)) {
+        print_expression(e.body, out, indent, opt);
     }
 }
 
-void print_expression(const resolved_conditional& e, std::stringstream& out, const std::string& indent) {
-    print_expression(e.condition, out, indent);
+void print_expression(const resolved_conditional& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    print_expression(e.condition, out, indent, opt);
     out << " ? ";
-    print_expression(e.value_true, out, indent);
+    print_expression(e.value_true, out, indent, opt);
     out << " : ";
-    print_expression(e.value_false, out, indent);
-    out << ";\n";
+    print_expression(e.value_false, out, indent, opt);
+}
+
+// Literals are printed as double literals, so that overloads such as `min`
+// and `max` that take both arguments by the same type can be resolved. They
+// are printed with the shortest representation that reads back as the same
+// double, and non-finite values are taken from std::numeric_limits.
+std::string double_literal(double value) {
+    if (std::isnan(value)) return "std::numeric_limits<double>::quiet_NaN()";
+    if (std::isinf(value)) {
+        return value < 0? "(-std::numeric_limits<double>::infinity())": "std::numeric_limits<double>::infinity()";
+    }
+    auto str = fmt::format("{}", value);
+    if (str.find_first_of(".e") == std::string::npos) str += ".0";
+    return str;
 }
 
-void print_expression(const resolved_float& e, std::stringstream& out, const std::string& indent) {
-    out << e.value;
+void print_expression(const resolved_float& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    out << double_literal(e.value);
 }
 
-void print_expression(const resolved_int& e, std::stringstream& out, const std::string& indent) {
-    out << e.value;
+void print_expression(const resolved_int& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    out << double_literal(e.value);
 }
 
-void print_expression(const resolved_unary& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_unary& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     switch (e.op) {
         case unary_op::exp:
-            out << "exp(";
-            print_expression(e.arg, out, indent);
+            out << function_name("exp", opt) << "(";
+            print_function_argument(e.arg, out, indent, opt);
             out << ")";
             break;
         case unary_op::log:
-            out << "log(";
-            print_expression(e.arg, out, indent);
+            out << function_name("log", opt) << "(";
+            print_function_argument(e.arg, out, indent, opt);
             out << ")";
             break;
         case unary_op::cos:
-            out << "cos(";
-            print_expression(e.arg, out, indent);
+            out << function_name("cos", opt) << "(";
+            print_function_argument(e.arg, out, indent, opt);
             out << ")";
             break;
         case unary_op::sin:
-            out << "sin(";
-            print_expression(e.arg, out, indent);
+            out << function_name("sin", opt) << "(";
+            print_function_argument(e.arg, out, indent, opt);
             out << ")";
             break;
         case unary_op::abs:
-            out << "abs(";
-            print_expression(e.arg, out, indent);
+            out << function_name("abs", opt) << "(";
+            print_function_argument(e.arg, out, indent, opt);
             out << ")";
             break;
         case unary_op::exprelr:
-            out << "exprelr(";
-            print_expression(e.arg, out, indent);
+            out << function_name("exprelr", opt) << "(";
+            print_function_argument(e.arg, out, indent, opt);
             out << ")";
             break;
         case unary_op::lnot:
             out << "!";
-            print_expression(e.arg, out, indent);
+            print_expression(e.arg, out, indent, opt);
             break;
         case unary_op::neg:
             out << "-";
-            print_expression(e.arg, out, indent);
+            print_expression(e.arg, out, indent, opt);
             break;
     }
 }
 
-void print_expression(const resolved_binary& e, std::stringstream& out, const std::string& indent) {
+void print_expression(const resolved_binary& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
     switch (e.op) {
         case binary_op::add:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " + ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::sub:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " - ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::mul:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " * ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::div:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " / ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::pow:
-            out << "pow(";
-            print_expression(e.lhs, out, indent);
+            out << function_name("pow", opt) << "(";
+            print_function_argument(e.lhs, out, indent, opt);
             out << ", ";
-            print_expression(e.rhs, out, indent);
+            print_function_argument(e.rhs, out, indent, opt);
             out << ")";
             break;
         case binary_op::lt:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " < ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::le:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " <= ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::gt:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " > ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::ge:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " >= ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::eq:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " == ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::ne:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " != ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::land:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " && ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::lor:
-            print_expression(e.lhs, out, indent);
+            print_expression(e.lhs, out, indent, opt);
             out << " || ";
-            print_expression(e.rhs, out, indent);
+            print_expression(e.rhs, out, indent, opt);
             break;
         case binary_op::min:
-            out << "min(";
-            print_expression(e.lhs, out, indent);
+            out << function_name("min", opt) << "(";
+            print_function_argument(e.lhs, out, indent, opt);
             out << ", ";
-            print_expression(e.lhs, out, indent);
+            print_function_argument(e.rhs, out, indent, opt);
             out << ")";
             break;
         case binary_op::max:
-            out << "max(";
-            print_expression(e.lhs, out, indent);
+            out << function_name("max", opt) << "(";
+            print_function_argument(e.lhs, out, indent, opt);
             out << ", ";
-            print_expression(e.lhs, out, indent);
+            print_function_argument(e.rhs, out, indent, opt);
             out << ")";
             break;
         case binary_op::dot: break;
     }
 }
 
-void print_expression(const r_expr& e, std::stringstream& out, const std::string& indent) {
-    return std::visit([&](auto&& c){return print_expression(c, out, indent);}, *e);
+void print_expression(const r_expr& e, std::stringstream& out, const std::string& indent, const printer_options& opt) {
+    return std::visit([&](auto&& c){return print_expression(c, out, indent, opt);}, *e);
 }
 
 } // namespace resolved_ir
@@ -1,3 +1,4 @@
+#include <cmath>
 #include <regex>
 #include <sstream>
 
@@ -45,22 +46,43 @@ std::stringstream print_header(
                        std::regex_replace(cpp_namespace, std::regex{"::"}, "_"),
                        mech.mech_name);
 
-    // print empty globals
-    out << "    static arb_field_info* globals = NULL;\n";
-    out << "    static arb_size_type n_globals = 0;\n";
-    
+    // print globals:
+    if (mech.field_pack.global_sources.empty()) {
+        out << "    static arb_field_info* globals = NULL;\n";
+    }
+    else {
+        out << "    static arb_field_info globals[] = {\n";
+        for (const auto& [p, val, unit]: mech.field_pack.global_sources) {
+            out << fmt::format("        {{\"{}\", \"{}\", {}, {}, {}}}, \n", p, unit, val, min, max);
+        }
+        out << "    };\n";
+    }
+    out << "    static arb_size_type n_globals = " << mech.field_pack.global_sources.size() << ";\n";
+
     // print states:
     out << "    static arb_field_info state_vars[] = {\n";
     for (const auto& p: mech.field_pack.state_sources) {
         out << fmt::format("        {{\"{}\", \"{}\", {}, {}, {}}}, \n", p, "", "NAN", min, max);
     }
+    // Cached values are stored as additional state variables, the only
+    // per-instance storage the simulator allocates. They are internal to the
+    // kernels, not part of the state of the mechanism, and listed last.
+    if (!mech.field_pack.cache_sources.empty()) {
+        out << "        // Internal: values stored by advance_state for compute_currents, not to be probed.\n";
+    }
+    for (const auto& p: mech.field_pack.cache_sources) {
+        out << fmt::format("        {{\"{}\", \"{}\", {}, {}, {}}}, \n", p, "", "NAN", min, max);
+    }
     out << "    };\n";
-    out << "    static arb_size_type n_state_vars = " << mech.field_pack.state_sources.size() << ";\n";
+    out << "    static arb_size_type n_state_vars = "
+        << mech.field_pack.state_sources.size() + mech.field_pack.cache_sources.size() << ";\n";
 
     // print parameters:
     out << "    static arb_field_info parameters[] = {\n";
     for (const auto& [p, val, unit]: mech.field_pack.param_sources) {
-        out << fmt::format("        {{\"{}\", \"{}\", {}, {}, {}}}, \n", p, unit, val, min, max);
+        // Assigned parameters have no default value.
+        auto val_str = std::isnan(val)? std::string("NAN"): fmt::format("{}", val);
+        out << fmt::format("        {{\"{}\", \"{}\", {}, {}, {}}}, \n", p, unit, val_str, min, max);
     }
     out << "    };\n";
     out << "    static arb_size_type n_parameters = " << mech.field_pack.param_sources.size() << ";\n";
@@ -96,8 +118,8 @@ std::stringstream print_header(
                        mech.mech_name,
                        fingerprint,
                        arb_mechanism_kind(mech.mech_kind),
-                       false, // TODO: actually check linearity
-                       false) // TODO: actually check post_events
+                       mech.is_linear,
+                       !mech.procedure_pack.post_events.empty())
         << fmt::format("  arb_mechanism_interface* make_arb_{0}_catalogue_{1}_interface_multicore(){2}\n"
                        "  arb_mechanism_interface* make_arb_{0}_catalogue_{1}_interface_gpu(){3}\n"
                        "}}\n",
@@ -1,3 +1,4 @@
+#include <set>
 #include <sstream>
 
 #include <fmt/compile.h>
@@ -7,6 +8,8 @@
 #include <arblang/printer/print_expressions.hpp>
 #include <arblang/util/unique_name.hpp>
 
+#include "../util/rexp_helpers.hpp"
+
 namespace std {
 template <>
 struct hash<al::resolved_ir::printable_mechanism::storage_info> {
@@ -22,7 +25,108 @@ bool operator==(const printable_mechanism::storage_info& lhs, const printable_me
     return lhs.pointer_name == rhs.pointer_name;
 }
 
-std::stringstream print_mechanism(const printable_mechanism& mech, const std::string& cpp_namespace) {
+// Printed at the top of the generated file in fast math mode.
+static constexpr const char* fast_math_functions = R"(// Branch-free approximations of exp, log and exprelr, which the host
+// compiler can vectorize. Maximum errors: exp 1.2 ulp on [-708.39, 709.78],
+// log 0.9 ulp on positive arguments, exprelr 2.4 ulp on (-inf, 709.78].
+static inline std::uint64_t fast_as_bits_(double x) {
+    std::uint64_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+static inline double fast_from_bits_(std::uint64_t u) {
+    double x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+static inline double fast_exp(double x) {
+    // exp(x) = 2^n * exp(r), with n = round(x/ln2) and |r| <= ln2/2.
+    // exp(r) is evaluated by its Taylor polynomial of degree 13.
+    constexpr double ln2_hi = 6.93147180369123816490e-01;
+    constexpr double ln2_lo = 1.90821492927058770002e-10;
+    constexpr double shift  = 0x1.8p52;
+    double xc = std::min(std::max(x, -708.39), 709.78);
+    double t = xc*1.44269504088896338700e+00 + shift;
+    double n = t - shift;
+    double r = (xc - n*ln2_hi) - n*ln2_lo;
+    double p = 1.0/6227020800.0;
+    p = p*r + 1.0/479001600.0;
+    p = p*r + 1.0/39916800.0;
+    p = p*r + 1.0/3628800.0;
+    p = p*r + 1.0/362880.0;
+    p = p*r + 1.0/40320.0;
+    p = p*r + 1.0/5040.0;
+    p = p*r + 1.0/720.0;
+    p = p*r + 1.0/120.0;
+    p = p*r + 1.0/24.0;
+    p = p*r + 1.0/6.0;
+    p = p*r + 0.5;
+    p = p*r + 1.0;
+    p = p*r + 1.0;
+    // 2^n is built in two halves, from the low bits of t and t1 which hold
+    // n - n1 and n1, so that each half has a normal exponent.
+    double n1 = std::floor(0.5*n);
+    double t1 = n1 + shift;
+    double scale  = fast_from_bits_((fast_as_bits_(t) - fast_as_bits_(t1) + 1023) << 52);
+    double scale1 = fast_from_bits_((fast_as_bits_(t1) + 1023) << 52);
+    double e = p*scale*scale1;
+    e = x < -708.39? 0.0: e;
+    e = x > 709.78? HUGE_VAL: e;
+    return e;
+}
+
+static inline double fast_log(double x) {
+    // log(x) = k*ln2 + log(m), with m in [sqrt(2)/2, sqrt(2)), evaluated as
+    // log(1+f) = f - f^2/2 + s*(f^2/2 + R(s^2)), s = f/(2+f), as in fdlibm.
+    constexpr double ln2_hi = 6.93147180369123816490e-01;
+    constexpr double ln2_lo = 1.90821492927058770002e-10;
+    // Subnormal arguments are scaled into the normal range.
+    bool subnormal = x < 2.2250738585072014e-308;
+    double xs = subnormal? x*0x1p54: x;
+    std::uint64_t bits = fast_as_bits_(xs);
+    // The biased exponent is converted to double through the mantissa of 2^52.
+    double k = fast_from_bits_((bits >> 52) | 0x4330000000000000ull) - 0x1p52;
+    k -= subnormal? 1077.0: 1023.0;
+    double m = fast_from_bits_((bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull);
+    bool large = m > 1.41421356237309504880;
+    m = large? 0.5*m: m;
+    k = large? k + 1.0: k;
+    double f = m - 1.0;
+    double s = f/(2.0 + f);
+    double z = s*s;
+    double R = 1.479819860511658591e-01;
+    R = R*z + 1.531383769920937332e-01;
+    R = R*z + 1.818357216161805012e-01;
+    R = R*z + 2.222219843214978396e-01;
+    R = R*z + 2.857142874366239149e-01;
+    R = R*z + 3.999999999940941908e-01;
+    R = R*z + 6.666666666666735130e-01;
+    R = R*z;
+    double hfsq = 0.5*f*f;
+    double l = k*ln2_hi - ((hfsq - (s*(hfsq + R) + k*ln2_lo)) - f);
+    l = x == HUGE_VAL? x: l;
+    l = x == 0.0? -HUGE_VAL: l;
+    l = x < 0.0? std::numeric_limits<double>::quiet_NaN(): l;
+    return l;
+}
+
+static inline double fast_exprelr(double x) {
+    // x/(exp(x)-1) = log(u)/(u-1) with u = exp(x), which avoids the
+    // cancellation in exp(x)-1 for small x. Below -37, exp(x)-1 rounds
+    // to -1 and the result is -x.
+    double u = fast_exp(x);
+    double r = fast_log(u)/(u - 1.0);
+    r = u == 1.0? 1.0: r;
+    r = x < -37.0? -x: r;
+    r = x > 709.78? 0.0: r;
+    return r;
+}
+
+)";
+
+std::stringstream print_mechanism(const printable_mechanism& mech, const std::string& cpp_namespace, const printer_options& opt) {
     std::stringstream out;
 
     // Define names for pointers to simulator defined indices and parameters
@@ -31,16 +135,36 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
     static constexpr const char* mech_node_weight  = "_pp_sim_weight";
     static constexpr const char* mech_id           = "_pp_sim_mechanism_id";
     static constexpr const char* mech_ion_idx_pref = "_pp_sim_index_ion_";
+    static constexpr const char* mech_index_constraints = "_pp_sim_index_constraints";
+    static constexpr const char* mech_multiplicity = "_pp_sim_multiplicity";
+    static constexpr const char* mech_cell_index   = "_pp_sim_vec_ci";
+    static constexpr const char* mech_n_detectors  = "_pp_sim_n_detectors";
+    static constexpr const char* mech_spike_time   = "_pp_sim_time_since_spike";
     static constexpr const char* node_idx_var      = "_nidx";
+    static constexpr const char* cell_idx_var      = "_cidx";
     static constexpr const char* ion_idx_var_pref  = "_nidx_";
+    static constexpr const char* node_weight_var   = "_weight";
+    static constexpr const char* simd_end_var      = "_simd_end";
 
     // Print includes
     out << "#include <algorithm>\n"
            "#include <cmath>\n"
            "#include <cstddef>\n"
-           "#include <memory>\n"
-           "#include <arbor/mechanism_abi.h>\n"
-           "#include <arbor/math.hpp>\n\n";
+           "#include <limits>\n"
+           "#include <memory>\n";
+    if (opt.fast_math) {
+        out << "#include <cstdint>\n"
+               "#include <cstring>\n";
+    }
+    if (!mech.tables.empty()) {
+        out << "#include <vector>\n";
+    }
+    out << "#include <arbor/mechanism_abi.h>\n"
+           "#include <arbor/math.hpp>\n";
+    if (opt.simd) {
+        out << "#include <arbor/simd/simd.hpp>\n";
+    }
+    out << "\n";
 
     // Open namespaces
     out << fmt::format("namespace arb {{\n");
@@ -60,8 +184,75 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
            "using ::std::sin;\n"
            "\n";
 
-    out << "static constexpr unsigned simd_width_ = 1;\n"  // TODO change when we implement vectorization
-           "static constexpr unsigned min_align_ = std::max(alignof(arb_value_type), alignof(arb_index_type));\n\n";
+    if (opt.fast_math) {
+        out << fast_math_functions;
+    }
+
+    if (opt.simd) {
+        out << "namespace S = ::arb::simd;\n"
+               "using S::index_constraint;\n"
+               "using S::indirect;\n"
+               "using S::assign;\n"
+               "\n"
+               "static constexpr unsigned simd_width_ = S::simd_abi::native_width<arb_value_type>::value;\n"
+               "using simd_value = S::simd<arb_value_type, simd_width_, S::simd_abi::default_abi>;\n"
+               "using simd_index = S::simd<arb_index_type, simd_width_, S::simd_abi::default_abi>;\n"
+               "using simd_mask  = S::simd_mask<arb_value_type, simd_width_, S::simd_abi::default_abi>;\n"
+               "static constexpr unsigned min_align_ = std::max(alignof(simd_value), alignof(simd_index));\n\n";
+    }
+    else {
+        out << "static constexpr unsigned simd_width_ = 1;\n"
+               "static constexpr unsigned min_align_ = std::max(alignof(arb_value_type), alignof(arb_index_type));\n\n";
+    }
+
+    // Print the tabulated functions: the function itself, its table, filled
+    // once when the library is loaded, and the lookup used by the kernels.
+    for (const auto& t: mech.tables) {
+        auto name = table_name(t.name);
+        auto arg = as_resolved_argument(t.argument)->name;
+        auto scalar_opt = opt;
+        scalar_opt.simd = false;
+
+        out << fmt::format("static arb_value_type {}_eval(arb_value_type {}) {{\n", name, arg);
+        auto result = t.body;
+        if (auto let = as_resolved_let(t.body)) {
+            print_expression(t.body, out, "    ", scalar_opt);
+            result = get_innermost_body(let);
+        }
+        out << "    return ";
+        print_expression(result, out, "", scalar_opt);
+        out << ";\n}\n\n";
+
+        out << fmt::format("static constexpr arb_value_type {}_lo_ = {};\n", name, t.spec.lo);
+        out << fmt::format("static constexpr arb_value_type {}_hi_ = {};\n", name, t.spec.hi);
+        out << fmt::format("static constexpr unsigned {}_n_ = {};\n", name, t.spec.intervals);
+        out << fmt::format("static const std::vector<arb_value_type> {0}_data_ = [] {{\n"
+                           "    std::vector<arb_value_type> t({0}_n_+1);\n"
+                           "    for (unsigned k = 0; k <= {0}_n_; ++k) {{\n"
+                           "        t[k] = {0}_eval({0}_lo_ + ({0}_hi_ - {0}_lo_)*k/{0}_n_);\n"
+                           "    }}\n"
+                           "    return t;\n"
+                           "}}();\n\n", name);
+
+        out << fmt::format("static arb_value_type {0}(arb_value_type v_) {{\n"
+                           "    auto x_ = (v_ - {0}_lo_)*({0}_n_/({0}_hi_ - {0}_lo_));\n"
+                           "    if (!(x_ >= 0 && x_ < {0}_n_)) return {0}_eval(v_);\n"
+                           "    auto k_ = static_cast<unsigned>(x_);\n"
+                           "    auto f_ = x_ - k_;\n"
+                           "    return {0}_data_[k_] + f_*({0}_data_[k_+1] - {0}_data_[k_]);\n"
+                           "}}\n\n", name);
+
+        if (opt.simd) {
+            out << fmt::format("static simd_value {0}(const simd_value& v_) {{\n"
+                               "    arb_value_type x_[simd_width_], r_[simd_width_];\n"
+                               "    v_.copy_to(x_);\n"
+                               "    for (unsigned k_ = 0; k_ < simd_width_; ++k_) r_[k_] = {0}(x_[k_]);\n"
+                               "    simd_value result_;\n"
+                               "    result_.copy_from(r_);\n"
+                               "    return result_;\n"
+                               "}}\n\n", name);
+        }
+    }
 
     // Define PPACK_IFACE_BLOCK
 
@@ -71,6 +262,17 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
     out << fmt::format("[[maybe_unused]] auto* {} = pp->node_index;\\\n", mech_node_index);
     out << fmt::format("[[maybe_unused]] auto* {} = pp->weight;\\\n", mech_node_weight);
     out << fmt::format("[[maybe_unused]] auto& {} = pp->mechanism_id;\\\n", mech_id);
+    out << fmt::format("[[maybe_unused]] auto& {} = pp->index_constraints;\\\n", mech_index_constraints);
+    // Identical instances of linear point mechanisms can be coalesced by the simulator.
+    bool coalescable = mech.is_linear && mech.mech_kind == mechanism_kind::point;
+    if (coalescable) {
+        out << fmt::format("[[maybe_unused]] auto* {} = pp->multiplicity;\\\n", mech_multiplicity);
+    }
+    if (!mech.procedure_pack.post_events.empty()) {
+        out << fmt::format("[[maybe_unused]] auto* {} = pp->vec_ci;\\\n", mech_cell_index);
+        out << fmt::format("[[maybe_unused]] auto  {} = pp->n_detectors;\\\n", mech_n_detectors);
+        out << fmt::format("[[maybe_unused]] auto* {} = pp->time_since_spike;\\\n", mech_spike_time);
+    }
 
     unsigned idx = 0;
     for (const auto& item: mech.ionic_fields) {
@@ -173,6 +375,17 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
             }
         }
     }
+    // The storage of each parameter and state is a separate array, aligned
+    // to min_align_ by the simulator.
+    auto print_internal_pointer = [&](const std::string& pointer_name, const std::string& source) {
+        if (opt.vectorize_hints) {
+            out << fmt::format("[[maybe_unused]] auto* __restrict__ {} = static_cast<arb_value_type*>(__builtin_assume_aligned({}, min_align_));\\\n",
+                               pointer_name, source);
+        } else {
+            out << fmt::format("[[maybe_unused]] auto* {} = {};\\\n", pointer_name, source);
+        }
+    };
+
     // Print the pointers to the parameters
     idx = 0;
     for (const auto& [name, val, unit]: mech.field_pack.param_sources) {
@@ -181,7 +394,15 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
                                                  name));
         }
         auto pointer_name = mech.pointer_map.at(name).pointer_name;
-        out << fmt::format("[[maybe_unused]] auto* {} = pp->parameters[{}];\\\n", pointer_name, idx);
+        print_internal_pointer(pointer_name, fmt::format("pp->parameters[{}]", idx));
+        idx++;
+    }
+
+    // Print the values of the global parameters
+    idx = 0;
+    for (const auto& [name, val, unit]: mech.field_pack.global_sources) {
+        auto pointer_name = mech.pointer_map.at(name).pointer_name;
+        out << fmt::format("[[maybe_unused]] auto {} = pp->globals[{}];\\\n", pointer_name, idx);
         idx++;
     }
 
@@ -193,7 +414,13 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
                                                  name));
         }
         auto pointer_name = mech.pointer_map.at(name).pointer_name;
-        out << fmt::format("[[maybe_unused]] auto* {} = pp->state_vars[{}];\\\n", pointer_name, idx);
+        print_internal_pointer(pointer_name, fmt::format("pp->state_vars[{}]", idx));
+        idx++;
+    }
+
+    // Print the pointers to the cached values, stored after the states
+    for (const auto& name: mech.field_pack.cache_sources) {
+        print_internal_pointer(mech.pointer_map.at(name).pointer_name, fmt::format("pp->state_vars[{}]", idx));
         idx++;
     }
     out << "\n";
@@ -217,25 +444,80 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
         }
         return {external_access, ions_accessed};
     };
-    auto print_read = [&](const auto& map, const std::string& indent) {
+    // The loop over the mechanism instances comes in several flavours. The
+    // SIMD flavours correspond to the classes of arbor's index constraint
+    // partition: a batch of node indices is either contiguous, constant,
+    // free of duplicates (independent), or has no known structure (none).
+    // Only the latter needs gathers and conflict-resolving scatters.
+    enum class loop_variant {scalar, simd_contiguous, simd_constant, simd_independent, simd_none};
+    auto constraint_of = [](loop_variant variant) -> std::string {
+        return variant==loop_variant::simd_independent? "index_constraint::independent": "index_constraint::none";
+    };
+    // Contiguous and constant batches are addressed through the first node index only.
+    auto has_scalar_index = [](loop_variant variant) {
+        return variant==loop_variant::scalar || variant==loop_variant::simd_contiguous || variant==loop_variant::simd_constant;
+    };
+    auto print_simd_read = [&](const std::string& var, const std::string& src, const std::optional<double>& scale, const std::string& indent) {
+        out << fmt::format("{}simd_value {}; assign({}, {});\n", indent, var, var, src);
+        if (scale) {
+            out << fmt::format("{}{} = {}*{};\n", indent, var, var, scale.value());
+        }
+    };
+    auto print_indexed_read = [&](const std::string& var, const std::string& pointer, const std::string& index, const std::optional<double>& scale, const std::string& indent, loop_variant variant) {
+        switch (variant) {
+            case loop_variant::scalar:
+                if (scale) {
+                    out << fmt::format("{}auto {} = {}[{}]*{};\n", indent, var, pointer, index, scale.value());
+                } else {
+                    out << fmt::format("{}auto {} = {}[{}];\n", indent, var, pointer, index);
+                }
+                break;
+            case loop_variant::simd_contiguous:
+                print_simd_read(var, fmt::format("indirect({} + {}, simd_width_)", pointer, index), scale, indent);
+                break;
+            case loop_variant::simd_constant:
+                out << fmt::format("{}simd_value {}({}[{}]);\n", indent, var, pointer, index);
+                if (scale) {
+                    out << fmt::format("{}{} = {}*{};\n", indent, var, var, scale.value());
+                }
+                break;
+            default:
+                print_simd_read(var, fmt::format("indirect({}, {}, simd_width_, {})", pointer, index, constraint_of(variant)), scale, indent);
+        }
+    };
+    auto print_indexed_write = [&](const std::string& var, const std::string& pointer, const std::string& index, const std::string& weight, const std::string& indent, loop_variant variant) {
+        switch (variant) {
+            case loop_variant::scalar:
+                out << fmt::format("{4}{0}[{1}] = fma({2}, {3}, {0}[{1}]);\n", pointer, index, weight, var, indent);
+                break;
+            case loop_variant::simd_contiguous:
+                out << fmt::format("{0}{{\n"
+                                   "{0}    simd_value acc_; assign(acc_, indirect({1} + {2}, simd_width_));\n"
+                                   "{0}    indirect({1} + {2}, simd_width_) = acc_ + {3}*{4};\n"
+                                   "{0}}}\n", indent, pointer, index, weight, var);
+                break;
+            case loop_variant::simd_constant:
+                out << fmt::format("{}{}[{}] += S::reduce({}*{});\n", indent, pointer, index, weight, var);
+                break;
+            default:
+                out << fmt::format("{}indirect({}, {}, simd_width_, {}) += {}*{};\n", indent, pointer, index, constraint_of(variant), weight, var);
+        }
+    };
+    auto print_read = [&](const auto& map, const std::string& indent, loop_variant variant = loop_variant::scalar) {
         for (const auto& [var, ptr]: map) {
+            // Uniform sources are read in the kernel prologue.
+            if (mech.uniform_sources.count(var)) continue;
             switch (ptr.pointer_kind) {
                 case printable_mechanism::storage_class::ionic:
-                    if (ptr.scale) {
-                        out << fmt::format("{}auto {} = {}[{}{}]*{};\n", indent, var, ptr.pointer_name, ion_idx_var_pref, ptr.ion.value(), ptr.scale.value());
-                    } else {
-                        out << fmt::format("{}auto {} = {}[{}{}];\n", indent, var, ptr.pointer_name, ion_idx_var_pref, ptr.ion.value());
-                    }
+                    print_indexed_read(var, ptr.pointer_name, ion_idx_var_pref + ptr.ion.value(), ptr.scale, indent, variant);
                     break;
                 case printable_mechanism::storage_class::external:
-                    if (ptr.scale) {
-                        out << fmt::format("{}auto {} = {}[{}]*{};\n", indent, var, ptr.pointer_name, node_idx_var, ptr.scale.value());
-                    } else {
-                        out << fmt::format("{}auto {} = {}[{}];\n", indent, var, ptr.pointer_name, node_idx_var);
-                    }
+                    print_indexed_read(var, ptr.pointer_name, node_idx_var, ptr.scale, indent, variant);
                     break;
                 case printable_mechanism::storage_class::internal:
-                    if (ptr.scale) {
+                    if (variant != loop_variant::scalar) {
+                        print_simd_read(var, fmt::format("indirect({} + i_, simd_width_)", ptr.pointer_name), ptr.scale, indent);
+                    } else if (ptr.scale) {
                         out << fmt::format("{}auto {} = {}[i_]*{};\n", indent, var, ptr.pointer_name, ptr.scale.value());
                     } else {
                         out << fmt::format("{}auto {} = {}[i_];\n", indent, var, ptr.pointer_name);
@@ -245,7 +527,21 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
             }
         }
     };
-    auto print_write = [&](const auto& map, const std::string& indent) {
+    // The name of the accumulator of the contributions to a node-indexed destination.
+    auto accumulator_of = [](const printable_mechanism::storage_info& ptr) {
+        return ptr.pointer_name + "_acc";
+    };
+    // Accumulate a contribution of a scalar loop while the next instance
+    // writes to the same index, and only then write the accumulated sum.
+    auto print_segmented_write = [&](const std::string& var, const printable_mechanism::storage_info& ptr, const std::string& index_ptr, const std::string& index, const std::string& weight, const std::string& indent) {
+        auto acc = accumulator_of(ptr);
+        out << fmt::format("{0}{1} = fma({2}, {3}, {1});\n"
+                           "{0}if (i_+1 == {4} || {5}[i_+1] != {6}) {{\n"
+                           "{0}    {7}[{6}] += {1};\n"
+                           "{0}    {1} = 0;\n"
+                           "{0}}}\n", indent, acc, weight, var, mech_width, index_ptr, index, ptr.pointer_name);
+    };
+    auto print_write = [&](const auto& map, const std::string& indent, loop_variant variant = loop_variant::scalar, bool segmented = false) {
         // If an external or ionic storage class is written to multiple times,
         // write the sum of the variables only once.
         std::unordered_map<printable_mechanism::storage_info, std::vector<std::string>> reduced_map;
@@ -253,6 +549,11 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
             reduced_map[ptr].push_back(var);
         }
         std::unordered_set<std::string> reserved_names;
+        bool simd = variant != loop_variant::scalar;
+        if (simd && check_access(map).external_access) {
+            out << fmt::format("{0}simd_value {1}; assign({1}, indirect({2} + i_, simd_width_));\n",
+                               indent, node_weight_var, mech_node_weight);
+        }
         for (const auto& [ptr, vars]: reduced_map) {
             std::string var_name = vars.front();
             if (vars.size() > 1) {
@@ -267,27 +568,34 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
                 }
                 out << fmt::format("{}auto {} = {};\n", indent, var_name, var_val);
             }
+            std::string weight = simd? node_weight_var: fmt::format("{}[i_]", mech_node_weight);
+            if (ptr.scale) {
+                if (simd) {
+                    var_name = fmt::format("{}*{}", ptr.scale.value(), var_name);
+                } else {
+                    weight = fmt::format("{}*{}", ptr.scale.value(), weight);
+                }
+            }
             switch (ptr.pointer_kind) {
                 case printable_mechanism::storage_class::ionic:
-                    if (ptr.scale) {
-                        out << fmt::format("{6}{0}[{1}{2}] = fma({5}*{3}[i_], {4}, {0}[{1}{2}]);\n",
-                                           ptr.pointer_name, ion_idx_var_pref, ptr.ion.value(), mech_node_weight, var_name, ptr.scale.value(), indent);
-                    } else {
-                        out << fmt::format("{5}{0}[{1}{2}] = fma({3}[i_], {4}, {0}[{1}{2}]);\n",
-                                           ptr.pointer_name, ion_idx_var_pref, ptr.ion.value(), mech_node_weight, var_name, indent);
+                    if (segmented) {
+                        print_segmented_write(var_name, ptr, mech_ion_idx_pref + ptr.ion.value(), ion_idx_var_pref + ptr.ion.value(), weight, indent);
+                        break;
                     }
+                    print_indexed_write(var_name, ptr.pointer_name, ion_idx_var_pref + ptr.ion.value(), weight, indent, variant);
                     break;
                 case printable_mechanism::storage_class::external:
-                    if (ptr.scale) {
-                        out << fmt::format("{5}{0}[{1}] = fma({4}*{2}[i_], {3}, {0}[{1}]);\n",
-                                           ptr.pointer_name, node_idx_var, mech_node_weight, var_name, ptr.scale.value(), indent);
-                    } else {
-                        out << fmt::format("{4}{0}[{1}] = fma({2}[i_], {3}, {0}[{1}]);\n",
-                                           ptr.pointer_name, node_idx_var, mech_node_weight, var_name, indent);
+                    if (segmented) {
+                        print_segmented_write(var_name, ptr, mech_node_index, node_idx_var, weight, indent);
+                        break;
                     }
+                    print_indexed_write(var_name, ptr.pointer_name, node_idx_var, weight, indent, variant);
                     break;
                 case printable_mechanism::storage_class::internal:
-                    if (ptr.scale) {
+                    if (simd) {
+                        out << fmt::format("{}indirect({} + i_, simd_width_) = simd_value({});\n",
+                                           indent, ptr.pointer_name, var_name);
+                    } else if (ptr.scale) {
                         out << fmt::format("{3}{0}[i_] = {2}*{1};\n", ptr.pointer_name, var_name, ptr.scale.value(), indent);
                     } else {
                         out << fmt::format("{2}{0}[i_] = {1};\n", ptr.pointer_name, var_name, indent);
@@ -297,80 +605,198 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
             }
         }
     };
+    // Print the body of a loop over the mechanism instances:
+    // index loads, memory reads, calculations and memory writes.
+    auto print_loop_body = [&](const auto& read_map, const auto& write_map, const std::vector<r_expr>& procedures, loop_variant variant, bool segmented = false) {
+        const std::string indent = "       ";
+        auto expr_opt = opt;
+        expr_opt.simd = variant != loop_variant::scalar;
+
+        auto read_access = check_access(read_map);
+        auto write_access = check_access(write_map);
+
+        // print indices
+        if (read_access.external_access || write_access.external_access) {
+            if (has_scalar_index(variant)) {
+                out << fmt::format("{}auto {} = {}[i_];\n", indent, node_idx_var, mech_node_index);
+            }
+            else {
+                out << fmt::format("{0}simd_index {1}; assign({1}, indirect({2} + i_, simd_width_));\n", indent, node_idx_var, mech_node_index);
+            }
+        }
+        read_access.ions_accessed.merge(write_access.ions_accessed);
+        for (const auto &ion: read_access.ions_accessed) {
+            if (has_scalar_index(variant)) {
+                out << fmt::format("{0}auto {1}{3} = {2}{3}[i_];\n", indent, ion_idx_var_pref, mech_ion_idx_pref, ion);
+            }
+            else {
+                out << fmt::format("{0}simd_index {1}{3}; assign({1}{3}, indirect({2}{3} + i_, simd_width_));\n", indent, ion_idx_var_pref, mech_ion_idx_pref, ion);
+            }
+        }
+        // print prefetches of the node-indexed data of a later instance
+        if (variant == loop_variant::scalar && opt.prefetch_distance) {
+            std::set<std::pair<std::string, std::string>> prefetches; // index and data pointers
+            auto add_prefetches = [&](const auto& map) {
+                for (const auto& [var, ptr]: map) {
+                    if (ptr.pointer_kind == printable_mechanism::storage_class::external) {
+                        prefetches.emplace(mech_node_index, ptr.pointer_name);
+                    }
+                    else if (ptr.pointer_kind == printable_mechanism::storage_class::ionic) {
+                        prefetches.emplace(mech_ion_idx_pref + ptr.ion.value(), ptr.pointer_name);
+                    }
+                }
+            };
+            add_prefetches(read_map);
+            add_prefetches(write_map);
+            if (!prefetches.empty()) {
+                out << fmt::format("{}if (i_ + {} < {}) {{\n", indent, opt.prefetch_distance, mech_width);
+                for (const auto& [index, pointer]: prefetches) {
+                    out << fmt::format("{}    __builtin_prefetch({} + {}[i_ + {}]);\n", indent, pointer, index, opt.prefetch_distance);
+                }
+                out << fmt::format("{}}}\n", indent);
+            }
+        }
+        // print reads
+        out << indent << "// Perform memory reads\n";
+        print_read(read_map, indent, variant);
+
+        // print expressions
+        out << indent << "// Perform calculations\n";
+        for (const auto &p: procedures) {
+            print_expression(p, out, indent, expr_opt);
+        }
 
-    // print init
-    {
-        out << fmt::format("static void init(arb_mechanism_ppack* pp) {{\n");
-        if (!(mech.procedure_pack.assigned_parameters.empty() && mech.procedure_pack.initializations.empty())) {
-            out << fmt::format("    PPACK_IFACE_BLOCK;\n");
+        // print writes
+        out << indent << "// Perform memory writes\n";
+        print_write(write_map, indent, variant, segmented);
+    };
+    // Print the loop(s) over all mechanism instances.
+    auto print_loop = [&](const auto& read_map, const auto& write_map, const std::vector<r_expr>& procedures) {
+        if (!opt.simd) {
+            // Many instances of a point mechanism commonly share a node. Their
+            // contributions can be summed per run of equal indices, and written once.
+            bool point = mech.mech_kind == mechanism_kind::point;
+            bool segmented = point && opt.segmented_writes;
+            if (segmented) {
+                std::set<std::string> accumulators;
+                for (const auto& [var, ptr]: write_map) {
+                    if (ptr.pointer_kind == printable_mechanism::storage_class::external ||
+                        ptr.pointer_kind == printable_mechanism::storage_class::ionic) {
+                        accumulators.insert(accumulator_of(ptr));
+                    }
+                }
+                for (const auto& acc: accumulators) {
+                    out << fmt::format("    arb_value_type {} = 0;\n", acc);
+                }
+            }
+            // The iterations are independent, unless instances of a point
+            // mechanism that share a node write to it.
+            if (opt.vectorize_hints && !(point && check_access(write_map).external_access)) {
+                out << "    #pragma omp simd\n";
+            }
             out << fmt::format("    for (arb_size_type i_ = 0; i_ < {}; ++i_) {{\n", mech_width);
-
-            auto read_access = check_access(mech.init_read_map);
-            auto write_access = check_access(mech.init_write_map);
-
-            // print indices
-            if (read_access.external_access || write_access.external_access) {
-                out << fmt::format("       auto {} = {}[i_];\n", node_idx_var, mech_node_index);
+            print_loop_body(read_map, write_map, procedures, loop_variant::scalar, segmented);
+            out << fmt::format("    }}\n");
+            return;
+        }
+        if (check_access(read_map).external_access || check_access(write_map).external_access) {
+            // Kernels touching node-indexed data iterate over each class of the
+            // index constraint partition with a specialized loop. The partition
+            // covers the padded width of the mechanism.
+            std::pair<loop_variant, std::string> classes[] = {
+                {loop_variant::simd_contiguous,  "contiguous"},
+                {loop_variant::simd_constant,    "constant"},
+                {loop_variant::simd_independent, "independent"},
+                {loop_variant::simd_none,        "none"},
+            };
+            for (const auto& [variant, name]: classes) {
+                out << fmt::format("    for (arb_size_type p_ = 0; p_ < {0}.n_{1}; ++p_) {{\n"
+                                   "       arb_size_type i_ = {0}.{1}[p_];\n", mech_index_constraints, name);
+                print_loop_body(read_map, write_map, procedures, variant);
+                out << fmt::format("    }}\n");
             }
-            read_access.ions_accessed.merge(write_access.ions_accessed);
-            for (const auto &ion: read_access.ions_accessed) {
-                out << fmt::format("       auto {0}{2} = {1}{2}[i_];\n", ion_idx_var_pref, mech_ion_idx_pref, ion);
+            return;
+        }
+        // Otherwise, the bulk of the instances is handled `simd_width_` at a
+        // time, and a scalar loop takes care of any remaining instances.
+        out << fmt::format("    arb_size_type {0} = {1} - {1}%simd_width_;\n", simd_end_var, mech_width);
+        out << fmt::format("    for (arb_size_type i_ = 0; i_ < {}; i_ += simd_width_) {{\n", simd_end_var);
+        print_loop_body(read_map, write_map, procedures, loop_variant::simd_none);
+        out << fmt::format("    }}\n");
+        out << fmt::format("    for (arb_size_type i_ = {}; i_ < {}; ++i_) {{\n", simd_end_var, mech_width);
+        print_loop_body(read_map, write_map, procedures, loop_variant::scalar);
+        out << fmt::format("    }}\n");
+    };
+    // Print the values shared by all instances, computed once ahead of the
+    // loop(s) over the instances: reads of uniform sources followed by the
+    // let-bindings hoisted from the procedures of the kernel.
+    auto print_prologue = [&](const auto& read_map, const std::vector<r_expr>& prologue) {
+        std::vector<std::pair<std::string, printable_mechanism::storage_info>> uniform_reads;
+        for (const auto& [var, ptr]: read_map) {
+            if (mech.uniform_sources.count(var)) uniform_reads.emplace_back(var, ptr);
+        }
+        if (prologue.empty() && uniform_reads.empty()) return;
+
+        const std::string indent = "    ";
+        out << fmt::format("{}if (!{}) return;\n", indent, mech_width);
+        out << indent << "// Compute values shared by all instances\n";
+        for (const auto& [var, ptr]: uniform_reads) {
+            if (ptr.pointer_kind == printable_mechanism::storage_class::global) {
+                out << fmt::format("{}auto {} = {};\n", indent, var, ptr.pointer_name);
+                continue;
             }
-            // print reads
-            out << "       // Perform memory reads\n";
-            print_read(mech.init_read_map, "       ");
-
-            // print expressions
-            out << "       // Perform calculations\n";
-            for (const auto &p: mech.procedure_pack.assigned_parameters) {
-                print_expression(p, out, "       ");
+            std::string index = "0";
+            if (ptr.pointer_kind == printable_mechanism::storage_class::external) {
+                index = fmt::format("{}[0]", mech_node_index);
             }
-            for (const auto &p: mech.procedure_pack.initializations) {
-                print_expression(p, out, "       ");
+            else if (ptr.pointer_kind == printable_mechanism::storage_class::ionic) {
+                index = fmt::format("{}{}[0]", mech_ion_idx_pref, ptr.ion.value());
             }
+            if (ptr.scale) {
+                out << fmt::format("{}auto {} = {}[{}]*{};\n", indent, var, ptr.pointer_name, index, ptr.scale.value());
+            } else {
+                out << fmt::format("{}auto {} = {}[{}];\n", indent, var, ptr.pointer_name, index);
+            }
+        }
+        auto expr_opt = opt;
+        expr_opt.simd = false;
+        for (const auto& p: prologue) {
+            print_expression(p, out, indent, expr_opt);
+        }
+    };
 
-            // print writes
-            out << "       // Perform memory writes\n";
-            print_write(mech.init_write_map, "       ");
+    // print init
+    {
+        out << fmt::format("static void init(arb_mechanism_ppack* pp) {{\n");
+        if (!(mech.procedure_pack.assigned_parameters.empty() && mech.procedure_pack.initializations.empty())) {
+            auto procedures = mech.procedure_pack.assigned_parameters;
+            procedures.insert(procedures.end(), mech.procedure_pack.initializations.begin(), mech.procedure_pack.initializations.end());
 
-            out << fmt::format("    }}\n");
+            out << fmt::format("    PPACK_IFACE_BLOCK;\n");
+            print_prologue(mech.init_read_map, mech.prologue_pack.init);
+            print_loop(mech.init_read_map, mech.init_write_map, procedures);
+
+            // A coalesced instance stands for `multiplicity` identical instances.
+            // As the mechanism is linear, its state is the sum of their states.
+            if (coalescable && !mech.field_pack.state_sources.empty()) {
+                out << fmt::format("    if ({}) {{\n"
+                                   "        for (arb_size_type i_ = 0; i_ < {}; ++i_) {{\n", mech_multiplicity, mech_width);
+                for (const auto& name: mech.field_pack.state_sources) {
+                    out << fmt::format("            {}[i_] *= {}[i_];\n", mech.pointer_map.at(name).pointer_name, mech_multiplicity);
+                }
+                out << "        }\n"
+                       "    }\n";
+            }
         }
         out << fmt::format("}}\n");
     }
     // print state
     {
-
         out << fmt::format("static void advance_state(arb_mechanism_ppack* pp) {{\n");
         if (!mech.procedure_pack.evolutions.empty()) {
             out << fmt::format("    PPACK_IFACE_BLOCK;\n");
-            out << fmt::format("    for (arb_size_type i_ = 0; i_ < {}; ++i_) {{\n", mech_width);
-
-            auto read_access = check_access(mech.evolve_read_map);
-            auto write_access = check_access(mech.evolve_write_map);
-
-            // print indices
-            if (read_access.external_access || write_access.external_access) {
-                out << fmt::format("       auto {} = {}[i_];\n", node_idx_var, mech_node_index);
-            }
-            read_access.ions_accessed.merge(write_access.ions_accessed);
-            for (const auto &ion: read_access.ions_accessed) {
-                out << fmt::format("       auto {0}{2} = {1}{2}[i_];\n", ion_idx_var_pref, mech_ion_idx_pref, ion);
-            }
-            // print reads
-            out << "       // Perform memory reads\n";
-            print_read(mech.evolve_read_map, "       ");
-
-            // print expressions
-            for (const auto &p: mech.procedure_pack.evolutions) {
-                out << "       // Perform calculations\n";
-                print_expression(p, out, "       ");
-            }
-
-            // print writes
-            out << "       // Perform memory writes\n";
-            print_write(mech.evolve_write_map, "       ");
-
-            out << fmt::format("    }}\n");
+            print_prologue(mech.evolve_read_map, mech.prologue_pack.evolutions);
+            print_loop(mech.evolve_read_map, mech.evolve_write_map, mech.procedure_pack.evolutions);
         }
         out << fmt::format("}}\n");
     }
@@ -379,50 +805,101 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
         out << fmt::format("static void compute_currents(arb_mechanism_ppack* pp) {{\n");
         if (!mech.procedure_pack.effects.empty()) {
             out << fmt::format("    PPACK_IFACE_BLOCK;\n");
-            out << fmt::format("    for (arb_size_type i_ = 0; i_ < {}; ++i_) {{\n", mech_width);
-
-            auto read_access = check_access(mech.effect_read_map);
-            auto write_access = check_access(mech.effect_write_map);
-
-            if (read_access.external_access || write_access.external_access) {
-                out << fmt::format("       auto {} = {}[i_];\n", node_idx_var, mech_node_index);
-            }
-            read_access.ions_accessed.merge(write_access.ions_accessed);
-            for (const auto &ion: read_access.ions_accessed) {
-                out << fmt::format("       auto {0}{2} = {1}{2}[i_];\n", ion_idx_var_pref, mech_ion_idx_pref, ion);
-            }
-            // print reads
-            out << "       // Perform memory reads\n";
-            print_read(mech.effect_read_map, "       ");
-
-            // print expressions
-            for (const auto &p: mech.procedure_pack.effects) {
-                out << "       // Perform calculations\n";
-                print_expression(p, out, "       ");
-            }
-
-            // print writes
-            out << "       // Perform memory writes\n";
-            print_write(mech.effect_write_map, "       ");
-
-            out << fmt::format("    }}\n");
+            print_prologue(mech.effect_read_map, mech.prologue_pack.effects);
+            print_loop(mech.effect_read_map, mech.effect_write_map, mech.procedure_pack.effects);
         }
         out << fmt::format("}}\n");
     }
     // print apply_events
+    // The events of a stream are ordered by time, and those of different
+    // mechanisms may be interleaved: the events of the mechanism are found by
+    // testing the id of every event of the stream.
+    // In SIMD mode, runs of simd_width_ events of the mechanism with strictly
+    // increasing targets are applied at once; any other event of the mechanism
+    // is applied on its own.
     {
         auto read_access = check_access(mech.event_read_map);
         auto write_access = check_access(mech.event_write_map);
+        bool simd = opt.simd && !read_access.external_access && !write_access.external_access;
+
+        if (!mech.procedure_pack.on_events.empty() && simd) {
+            out << "// Whether the next simd_width_ events are all events of the mechanism\n"
+                   "// with distinct targets.\n"
+                   "static bool independent_targets_(const arb_deliverable_event_data* p, arb_size_type id) {\n"
+                   "    if (p[0].mech_id != id) return false;\n"
+                   "    for (unsigned k_ = 1; k_ < simd_width_; ++k_) {\n"
+                   "        if (p[k_].mech_id != id || p[k_].mech_index <= p[k_-1].mech_index) return false;\n"
+                   "    }\n"
+                   "    return true;\n"
+                   "}\n";
+        }
         out << fmt::format(FMT_COMPILE("static void apply_events(arb_mechanism_ppack* pp, arb_deliverable_event_stream* stream_ptr) {{\n"));
 
         if (!mech.procedure_pack.on_events.empty()) {
-            out << fmt::format(FMT_COMPILE("    PPACK_IFACE_BLOCK;\n"
-                                           "    auto ncell = stream_ptr->n_streams;\n"
+            const std::string indent = "                ";
+            out << fmt::format(FMT_COMPILE("    PPACK_IFACE_BLOCK;\n"));
+            print_prologue(mech.event_read_map, mech.prologue_pack.on_events);
+            out << fmt::format(FMT_COMPILE("    auto ncell = stream_ptr->n_streams;\n"
                                            "    for (arb_size_type c = 0; c<ncell; ++c) {{\n"
                                            "        auto begin  = stream_ptr->events + stream_ptr->begin[c];\n"
                                            "        auto end    = stream_ptr->events + stream_ptr->end[c];\n"
-                                           "        for (auto p = begin; p<end; ++p) {{\n"
-                                           "            auto i_     = p->mech_index;\n"));
+                                           "        for (auto p = begin; p<end;) {{\n"));
+
+            if (simd) {
+                out << fmt::format("            if (end - p >= std::ptrdiff_t(simd_width_) && independent_targets_(p, {})) {{\n", mech_id);
+                out << "                arb_index_type idx_[simd_width_];\n"
+                       "                arb_value_type weight_[simd_width_];\n"
+                       "                for (unsigned k_ = 0; k_ < simd_width_; ++k_) {\n"
+                       "                    idx_[k_] = p[k_].mech_index;\n"
+                       "                    weight_[k_] = p[k_].weight;\n"
+                       "                }\n"
+                       "                simd_index i_; assign(i_, indirect(idx_, simd_width_));\n";
+                for (const auto&[var, ptr]: mech.event_read_map) {
+                    if (ptr.pointer_kind == printable_mechanism::storage_class::stream_member) {
+                        out << fmt::format("{0}simd_value {1}; assign({1}, indirect(weight_, simd_width_));\n", indent, var);
+                    }
+                }
+
+                // print reads
+                out << indent << "// Perform memory reads\n";
+                for (const auto& [var, ptr]: mech.event_read_map) {
+                    if (mech.uniform_sources.count(var)) continue;
+                    if (ptr.pointer_kind != printable_mechanism::storage_class::internal) continue;
+                    print_simd_read(var, fmt::format("indirect({}, i_, simd_width_, index_constraint::independent)", ptr.pointer_name), ptr.scale, indent);
+                }
+
+                // print expressions
+                auto expr_opt = opt;
+                out << indent << "// Perform calculations\n";
+                for (const auto &p: mech.procedure_pack.on_events) {
+                    print_expression(p, out, indent, expr_opt);
+                }
+
+                // print writes
+                out << indent << "// Perform memory writes\n";
+                for (const auto& [var, ptr]: mech.event_write_map) {
+                    if (ptr.pointer_kind != printable_mechanism::storage_class::internal) continue;
+                    auto value = ptr.scale? fmt::format("{}*{}", ptr.scale.value(), var): var;
+                    out << fmt::format("{}indirect({}, i_, simd_width_, index_constraint::independent) = simd_value({});\n",
+                                       indent, ptr.pointer_name, value);
+                }
+                out << "                p += simd_width_;\n"
+                       "                continue;\n"
+                       "            }\n";
+            }
+
+            out << fmt::format("            if (p->mech_id != {}) {{\n"
+                               "                ++p;\n"
+                               "                continue;\n"
+                               "            }}\n", mech_id);
+            out << "            auto i_     = p->mech_index;\n";
+            if (read_access.external_access || write_access.external_access) {
+                out << fmt::format("            auto {} = {}[i_];\n", node_idx_var, mech_node_index);
+            }
+            read_access.ions_accessed.merge(write_access.ions_accessed);
+            for (const auto &ion: read_access.ions_accessed) {
+                out << fmt::format("            auto {0}{2} = {1}{2}[i_];\n", ion_idx_var_pref, mech_ion_idx_pref, ion);
+            }
 
             // find the and read stream members
             for (const auto&[var, ptr]: mech.event_read_map) {
@@ -430,31 +907,83 @@ std::stringstream print_mechanism(const printable_mechanism& mech, const std::st
                     out << fmt::format("            auto {}     = p->{};\n", var, ptr.pointer_name);
                 }
             }
-            out << fmt::format(FMT_COMPILE("            if (p->mech_id=={0}) {{\n"), mech_id);
+            out << "            {\n";
 
             // print reads
-            out << "                // Perform memory reads\n";
-            print_read(mech.event_read_map, "                ");
+            out << indent << "// Perform memory reads\n";
+            print_read(mech.event_read_map, indent);
 
             // print expressions
             for (const auto &p: mech.procedure_pack.on_events) {
-                out << "                // Perform calculations\n";
-                print_expression(p, out, "                ");
+                out << indent << "// Perform calculations\n";
+                print_expression(p, out, indent);
             }
 
             // print writes
-            out << "                // Perform memory writes\n";
-            print_write(mech.event_write_map, "                ");
+            out << indent << "// Perform memory writes\n";
+            print_write(mech.event_write_map, indent);
             out << "            }\n"
+                   "            ++p;\n"
                    "        }\n"
                    "    }\n";
         }
         out << "}\n";
     }
-    // print write_ions, post_events (empty)
+    // print post_event
+    // The handlers are applied once for every spike detector of the cell of an
+    // instance that has generated a spike in the last time step.
+    {
+        if (mech.procedure_pack.post_events.empty()) {
+            out << fmt::format("static void post_event(arb_mechanism_ppack*) {{}}\n");
+        }
+        else {
+            out << fmt::format("static void post_event(arb_mechanism_ppack* pp) {{\n");
+            const std::string indent = "                ";
+            out << fmt::format("    PPACK_IFACE_BLOCK;\n");
+            print_prologue(mech.post_read_map, mech.prologue_pack.post_events);
+            out << fmt::format("    for (arb_size_type i_ = 0; i_ < {}; ++i_) {{\n"
+                               "        auto {} = {}[i_];\n", mech_width, node_idx_var, mech_node_index);
+            for (const auto &ion: check_access(mech.post_read_map).ions_accessed) {
+                out << fmt::format("        auto {0}{2} = {1}{2}[i_];\n", ion_idx_var_pref, mech_ion_idx_pref, ion);
+            }
+            out << fmt::format("        auto {0} = {1}[{2}];\n"
+                               "        for (arb_size_type d_ = 0; d_ < {3}; ++d_) {{\n",
+                               cell_idx_var, mech_cell_index, node_idx_var, mech_n_detectors);
+
+            // find and read the time since the spike
+            std::vector<std::string> spike_times;
+            for (const auto&[var, ptr]: mech.post_read_map) {
+                if (ptr.pointer_kind == printable_mechanism::storage_class::stream_member) {
+                    out << fmt::format("            auto {} = {}[{}*{} + d_]*{};\n",
+                                       var, mech_spike_time, cell_idx_var, mech_n_detectors, ptr.scale.value());
+                    spike_times.push_back(var);
+                }
+            }
+            auto spike_time = fmt::format("{}[{}*{} + d_]", mech_spike_time, cell_idx_var, mech_n_detectors);
+            out << fmt::format("            if ({} >= 0) {{\n", spike_times.empty()? spike_time: spike_times.front());
+
+            // print reads
+            out << indent << "// Perform memory reads\n";
+            print_read(mech.post_read_map, indent);
+
+            // print expressions
+            out << indent << "// Perform calculations\n";
+            for (const auto &p: mech.procedure_pack.post_events) {
+                print_expression(p, out, indent);
+            }
+
+            // print writes
+            out << indent << "// Perform memory writes\n";
+            print_write(mech.post_write_map, indent);
+            out << "            }\n"
+                   "        }\n"
+                   "    }\n"
+                   "}\n";
+        }
+    }
+    // print write_ions (empty)
     {
         out << fmt::format("static void write_ions(arb_mechanism_ppack*) {{}}\n");
-        out << fmt::format("static void post_event(arb_mechanism_ppack*) {{}}\n");
     }
     // undef PPACK_IFACE_BLOCK
 
@@ -181,8 +181,8 @@ r_expr canonicalize(const resolved_call& e,
     resolved_let let_outer;
     for (const auto& arg: e.call_args) {
         auto arg_canon = canonicalize(arg, reserved, rewrites, pref);
-        if (auto let_opt = is_resolved_let(arg_canon)) {
-            auto let_arg = let_opt.value();
+        if (auto let_opt = as_resolved_let(arg_canon)) {
+            auto let_arg = *let_opt;
 
             // The innermost body of let_arg is the new call argument
             args_canon.push_back(get_innermost_body(&let_arg));
@@ -246,8 +246,8 @@ r_expr canonicalize(const resolved_object& e,
     resolved_let let_outer;
     for (const auto& arg: e.field_values()) {
         auto arg_canon = canonicalize(arg, reserved, rewrites, pref);
-        if (auto let_opt = is_resolved_let(arg_canon)) {
-            auto let_val = let_opt.value();
+        if (auto let_opt = as_resolved_let(arg_canon)) {
+            auto let_val = *let_opt;
 
             // The innermost body of let_val is the new call argument
             values_canon.push_back(get_innermost_body(&let_val));
@@ -311,8 +311,8 @@ r_expr canonicalize(const resolved_let& e,
     auto body_canon = canonicalize(e.body, reserved, rewrites, pref);
     auto let_outer = resolved_let(var_canon, body_canon, e.type, e.loc);
 
-    if (auto let_opt = is_resolved_let(val_canon)) {
-        auto let_val = let_opt.value();
+    if (auto let_opt = as_resolved_let(val_canon)) {
+        auto let_val = *let_opt;
 
         let_outer.id_value(get_innermost_body(&let_val));
         set_innermost_body(&let_val, make_rexpr<resolved_let>(let_outer));
@@ -348,14 +348,14 @@ r_expr canonicalize(const resolved_conditional& e,
 
     resolved_let let_outer;
     bool has_let = false;
-    if (auto let_opt = is_resolved_let(cond_canon)) {
-        auto let_cond = let_opt.value();
+    if (auto let_opt = as_resolved_let(cond_canon)) {
+        auto let_cond = *let_opt;
         let_outer = let_cond;
         cond_canon = get_innermost_body(&let_cond);
         has_let = true;
     }
-    if (auto let_opt = is_resolved_let(true_canon)) {
-        auto let_true = let_opt.value();
+    if (auto let_opt = as_resolved_let(true_canon)) {
+        auto let_true = *let_opt;
         if (!has_let) {
             let_outer = let_true;
         }
@@ -365,8 +365,8 @@ r_expr canonicalize(const resolved_conditional& e,
         has_let = true;
         true_canon = get_innermost_body(&let_true);
     }
-    if (auto let_opt = is_resolved_let(false_canon)) {
-        auto let_false = let_opt.value();
+    if (auto let_opt = as_resolved_let(false_canon)) {
+        auto let_false = *let_opt;
         if (!has_let) {
             let_outer = let_false;
         }
@@ -424,8 +424,8 @@ r_expr canonicalize(const resolved_unary& e,
 
     resolved_let let_outer;
     bool has_let = false;
-    if (auto let_opt = is_resolved_let(arg_canon)) {
-        auto let_first = let_opt.value();
+    if (auto let_opt = as_resolved_let(arg_canon)) {
+        auto let_first = *let_opt;
         arg_canon = get_innermost_body(&let_first);
         let_outer = let_first;
         has_let = true;
@@ -471,14 +471,14 @@ r_expr canonicalize(const resolved_binary& e,
 
     resolved_let let_outer;
     bool has_let = false;
-    if (auto let_opt = is_resolved_let(lhs_canon)) {
-        auto let_first = let_opt.value();
+    if (auto let_opt = as_resolved_let(lhs_canon)) {
+        auto let_first = *let_opt;
         let_outer = let_first;
         lhs_canon = get_innermost_body(&let_first);
         has_let = true;
     }
-    if (auto let_opt = is_resolved_let(rhs_canon)) {
-        auto let_first = let_opt.value();
+    if (auto let_opt = as_resolved_let(rhs_canon)) {
+        auto let_first = *let_opt;
         if (!has_let) {
             let_outer = let_first;
         }
@@ -520,8 +520,8 @@ r_expr canonicalize(const resolved_field_access& e,
 
     resolved_let let_outer;
     bool has_let = false;
-    if (auto let_opt = is_resolved_let(obj_canon)) {
-        auto let_obj = let_opt.value();
+    if (auto let_opt = as_resolved_let(obj_canon)) {
+        auto let_obj = *let_opt;
         let_outer = let_obj;
         obj_canon = get_innermost_body(&let_obj);
         has_let = true;
@@ -590,6 +590,14 @@ resolved_mechanism canonicalize(const resolved_mechanism& e) {
         mech.on_events.push_back(canonicalize(c, reserved, rewrites, pref));
     }
 
+    // All post_events share the same reserved_map because they share the
+    // same API call.
+    reserved.clear();
+    for (const auto& c: e.post_events) {
+        rewrites.clear();
+        mech.post_events.push_back(canonicalize(c, reserved, rewrites, pref));
+    }
+
     // All evolutions share the same reserved_map because they share the
     // same API call.
     reserved.clear();
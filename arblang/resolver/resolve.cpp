@@ -50,7 +50,7 @@ void check_duplicate(const std::string& name, const src_location& loc, const in_
 }
 
 r_expr resolve(const parsed_parameter& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -84,7 +84,7 @@ r_expr resolve(const parsed_parameter& e, const in_scope_map& map) {
 }
 
 r_expr resolve(const parsed_constant& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -119,7 +119,7 @@ r_expr resolve(const parsed_constant& e, const in_scope_map& map) {
 }
 
 r_expr resolve(const parsed_state& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -139,7 +139,7 @@ r_expr resolve(const parsed_state& e, const in_scope_map& map) {
 }
 
 r_expr resolve(const parsed_bind& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -182,12 +182,12 @@ r_expr resolve(const parsed_function& e, const in_scope_map& map) {
     auto available_map = map;
     std::vector<r_expr> f_args;
     for (const auto& a: e.args) {
-        auto arg_id = is_parsed_identifier(a);
+        auto arg_id = as_parsed_identifier(a);
         if (!arg_id) {
             throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                                  to_string(a), to_string(location_of(a))));
         }
-        auto a_id = arg_id.value();
+        const auto& a_id = *arg_id;
 
         // Check that function arguments have defined types.
         if (!a_id.type) {
@@ -222,7 +222,7 @@ r_expr resolve(const parsed_function& e, const in_scope_map& map) {
 }
 
 r_expr resolve(const parsed_initial& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -265,7 +265,7 @@ r_expr resolve(const parsed_initial& e, const in_scope_map& map) {
 }
 
 r_expr resolve(const parsed_on_event& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -281,7 +281,7 @@ r_expr resolve(const parsed_on_event& e, const in_scope_map& map) {
     // on_event expressions contain an optional argument,
     // sent from the simulator (weight argument in a connection).
     // This argument needs to have a user-defined type.
-    auto a_id = is_parsed_identifier(e.argument);
+    auto a_id = as_parsed_identifier(e.argument);
     if (!a_id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.argument), to_string(location_of(e.argument))));
@@ -327,7 +327,7 @@ r_expr resolve(const parsed_on_event& e, const in_scope_map& map) {
 }
 
 r_expr resolve(const parsed_evolve& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -390,7 +390,7 @@ r_expr resolve(const parsed_effect& e, const in_scope_map& map) {
 }
 
 r_expr resolve(const parsed_export& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -417,7 +417,7 @@ r_expr resolve(const parsed_call& e, const in_scope_map& map) {
         throw std::runtime_error(fmt::format("function {} called at {} is not defined.", f_name, to_string(e.loc)));
     }
     auto f_expr = map.func_map.at(f_name);
-    auto func = is_resolved_function(f_expr).value();
+    const auto& func = *as_resolved_function(f_expr);
 
     // Resolve the call arguments
     std::vector<r_expr> c_args;
@@ -463,7 +463,7 @@ r_expr resolve(const parsed_object& e, const in_scope_map& map) {
     std::vector<r_expr> o_fields;
     std::vector<std::pair<std::string, r_type>> o_types;
     for (unsigned i = 0; i < e.record_fields.size(); ++i) {
-        auto f_id = is_parsed_identifier(e.record_fields[i]);
+        auto f_id = as_parsed_identifier(e.record_fields[i]);
         if (!f_id) {
             throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                                  to_string(e.record_fields[i]), to_string(location_of(e.record_fields[i]))));
@@ -510,7 +510,7 @@ r_expr resolve(const parsed_object& e, const in_scope_map& map) {
 }
 
 r_expr resolve(const parsed_let& e, const in_scope_map& map) {
-    auto id = is_parsed_identifier(e.identifier);
+    auto id = as_parsed_identifier(e.identifier);
     if (!id) {
         throw std::runtime_error(fmt::format("Internal compiler error, expected identifier instead of {} at {}.",
                                              to_string(e.identifier), to_string(location_of(e.identifier))));
@@ -656,7 +656,7 @@ r_expr resolve(const parsed_binary& e, const in_scope_map& map) {
     if (e.op == binary_op::dot) {
         if (auto lhs_rec = is_resolved_record_type(lhs_t)) {
             // rhs needs to be an identifier
-            auto rhs = is_parsed_identifier(e.rhs);
+            auto rhs = as_parsed_identifier(e.rhs);
             if (!rhs) {
                 throw std::runtime_error(fmt::format("incompatible argument type to dot operator, at {}", to_string(e.loc)));
             }
@@ -805,7 +805,7 @@ resolved_mechanism resolve(const parsed_mechanism& e) {
     //    a `record foo' {a':real/time; b':voltage/time;};` is implicitly
     // defined, unless the user explicitly defines it too.
     for (const auto& r: e.records) {
-        auto rec = is_parsed_record_alias(r);
+        auto rec = as_parsed_record_alias(r);
         if (!rec) {
             throw std::runtime_error(fmt::format("internal compiler error, expected record expression at {}",
                                                  to_string(location_of(r))));
@@ -813,7 +813,7 @@ resolved_mechanism resolve(const parsed_mechanism& e) {
 
         // regular
         auto resolved_record = resolve(r, available_map);
-        auto resolved_record_val = is_resolved_record_alias(resolved_record);
+        auto resolved_record_val = as_resolved_record_alias(resolved_record);
         if (!resolved_record_val) {
             throw std::runtime_error(fmt::format("internal compiler error, expected record expression at {}",
                                                  to_string(location_of(r))));
@@ -834,7 +834,7 @@ resolved_mechanism resolve(const parsed_mechanism& e) {
         auto val = resolve(c, available_map);
         mech.constants.push_back(val);
 
-        auto const_val = is_resolved_constant(val);
+        auto const_val = as_resolved_constant(val);
         if (!const_val) {
             throw std::runtime_error(fmt::format("internal compiler error, expected constant expression at {}",
                                                  to_string(location_of(val))));
@@ -852,7 +852,7 @@ resolved_mechanism resolve(const parsed_mechanism& e) {
         auto val =resolve(c, available_map);
         mech.parameters.push_back(val);
 
-        auto param_val = is_resolved_parameter(val);
+        auto param_val = as_resolved_parameter(val);
         if (!param_val) {
             throw std::runtime_error(fmt::format("internal compiler error, expected parameter expression at {}",
                                                  to_string(location_of(val))));
@@ -870,7 +870,7 @@ resolved_mechanism resolve(const parsed_mechanism& e) {
         auto val = resolve(c, available_map);
         mech.bindings.push_back(val);
 
-        auto bind_val = is_resolved_bind(val);
+        auto bind_val = as_resolved_bind(val);
         if (!bind_val) {
             throw std::runtime_error(fmt::format("internal compiler error, expected bind expression at {}",
                                                  to_string(location_of(val))));
@@ -888,7 +888,7 @@ resolved_mechanism resolve(const parsed_mechanism& e) {
         auto val = resolve(c, available_map);
         mech.states.push_back(val);
 
-        auto state_val = is_resolved_state(val);
+        auto state_val = as_resolved_state(val);
         if (!state_val) {
             throw std::runtime_error(fmt::format("internal compiler error, expected state expression at {}",
                                                  to_string(location_of(val))));
@@ -906,7 +906,7 @@ resolved_mechanism resolve(const parsed_mechanism& e) {
         auto val = resolve(c, available_map);
         mech.functions.push_back(val);
 
-        auto func_val = is_resolved_function(val);
+        auto func_val = as_resolved_function(val);
         if (!func_val) {
             throw std::runtime_error(fmt::format("internal compiler error, expected function expression at {}",
                                                  to_string(location_of(val))));
@@ -925,6 +925,18 @@ resolved_mechanism resolve(const parsed_mechanism& e) {
     for (const auto& c: e.on_events) {
         mech.on_events.push_back(resolve(c, available_map));
     }
+    for (const auto& c: e.post_events) {
+        auto val = resolve(c, available_map);
+
+        // The argument of a post event is the time since the spike was generated.
+        auto arg = as_resolved_on_event(val)->argument;
+        auto arg_type = is_resolved_quantity_type(type_of(arg));
+        if (!arg_type || arg_type->type != normalized_type(quantity::time)) {
+            throw std::runtime_error(fmt::format("on_post argument at {} has invalid quantity type {}; "
+                                                 "expected time.", to_string(location_of(arg)), to_string(type_of(arg))));
+        }
+        mech.post_events.push_back(val);
+    }
     for (const auto& c: e.evolutions) {
         mech.evolutions.push_back(resolve(c, available_map));
     }
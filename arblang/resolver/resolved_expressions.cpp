@@ -21,7 +21,7 @@ resolved_let::resolved_let(std::string iden, r_expr value, r_expr body, r_type t
 }
 
 r_expr resolved_let::id_value() const {
-    if (auto id = is_resolved_variable(identifier)) {
+    if (auto id = as_resolved_variable(identifier)) {
         return id->value;
     }
     throw std::runtime_error("internal compiler error: expected resolved_variable at " + to_string(loc));
@@ -36,7 +36,7 @@ void resolved_let::id_value(r_expr val) {
 }
 
 std::string resolved_let::id_name() const {
-    if (auto id = is_resolved_variable(identifier)) {
+    if (auto id = as_resolved_variable(identifier)) {
         return id->name;
     }
     throw std::runtime_error("internal compiler error: expected resolved_variable at " + to_string(loc));
@@ -59,7 +59,7 @@ resolved_object::resolved_object(std::vector<std::string> names,
 std::vector<r_expr> resolved_object::field_values() const {
     std::vector<r_expr> vals;
     for (const auto& field: record_fields) {
-        if (auto id = is_resolved_variable(field)) {
+        if (auto id = as_resolved_variable(field)) {
             vals.push_back(id->value);
         } else {
             throw std::runtime_error("internal compiler error: expected resolved_variable at " + to_string(loc));
@@ -82,7 +82,7 @@ void resolved_object::field_values(std::vector<r_expr> vals) {
 std::vector<std::string> resolved_object::field_names() const {
     std::vector<std::string> names;
     for (const auto& field: record_fields) {
-        if (auto id = is_resolved_variable(field)) {
+        if (auto id = as_resolved_variable(field)) {
             names.push_back(id->name);
         } else {
             throw std::runtime_error("internal compiler error: expected resolved_variable at " + to_string(loc));
@@ -159,7 +159,7 @@ resolved_binary::resolved_binary(binary_op op, r_expr l, r_expr r, const src_loc
                 type = make_rtype<resolved_quantity>(quantity::real, loc);
                 break;
             }
-            auto rhs_int = is_resolved_int(rhs);
+            auto rhs_int = as_resolved_int(rhs);
             if (!rhs_int) {
                 // TODO, we actually allow a^float if a has a real type.
                 throw std::runtime_error(fmt::format("Internal compiler error: operator {} rhs is not a resolved_int "
@@ -230,6 +230,9 @@ std::string to_string(const resolved_mechanism& e, bool include_type, bool expan
     for (const auto& p: e.on_events) {
         str += to_string(p, include_type, expand_var, indent+1) + "\n";
     }
+    for (const auto& p: e.post_events) {
+        str += to_string(p, include_type, expand_var, indent+1) + "\n";
+    }
     for (const auto& p: e.evolutions) {
         str += to_string(p, include_type, expand_var, indent+1) + "\n";
     }
@@ -538,7 +541,8 @@ bool operator==(const resolved_argument& lhs, const resolved_argument& rhs) {
 }
 
 bool operator==(const resolved_variable& lhs, const resolved_variable& rhs) {
-    return (lhs.name == rhs.name) && (*lhs.value == *rhs.value) && (*lhs.type == *rhs.type);
+    return (lhs.name == rhs.name) && (*lhs.type == *rhs.type) &&
+           (lhs.value == rhs.value || *lhs.value == *rhs.value);
 }
 
 bool operator==(const resolved_field_access& lhs, const resolved_field_access& rhs) {
@@ -735,6 +739,72 @@ std::optional<resolved_binary> is_resolved_binary(const r_expr& r) {
     if (!std::holds_alternative<resolved_binary>(*r)) return {};
     return std::get<resolved_binary>(*r);
 }
+const resolved_argument* as_resolved_argument(const r_expr& r) {
+    return std::get_if<resolved_argument>(r.get());
+}
+const resolved_variable* as_resolved_variable(const r_expr& r) {
+    return std::get_if<resolved_variable>(r.get());
+}
+const resolved_field_access* as_resolved_field_access(const r_expr& r) {
+    return std::get_if<resolved_field_access>(r.get());
+}
+const resolved_parameter* as_resolved_parameter(const r_expr& r) {
+    return std::get_if<resolved_parameter>(r.get());
+}
+const resolved_constant* as_resolved_constant(const r_expr& r) {
+    return std::get_if<resolved_constant>(r.get());
+}
+const resolved_state* as_resolved_state(const r_expr& r) {
+    return std::get_if<resolved_state>(r.get());
+}
+const resolved_record_alias* as_resolved_record_alias(const r_expr& r) {
+    return std::get_if<resolved_record_alias>(r.get());
+}
+const resolved_function* as_resolved_function(const r_expr& r) {
+    return std::get_if<resolved_function>(r.get());
+}
+const resolved_bind* as_resolved_bind(const r_expr& r) {
+    return std::get_if<resolved_bind>(r.get());
+}
+const resolved_initial* as_resolved_initial(const r_expr& r) {
+    return std::get_if<resolved_initial>(r.get());
+}
+const resolved_on_event* as_resolved_on_event(const r_expr& r) {
+    return std::get_if<resolved_on_event>(r.get());
+}
+const resolved_evolve* as_resolved_evolve(const r_expr& r) {
+    return std::get_if<resolved_evolve>(r.get());
+}
+const resolved_effect* as_resolved_effect(const r_expr& r) {
+    return std::get_if<resolved_effect>(r.get());
+}
+const resolved_export* as_resolved_export(const r_expr& r) {
+    return std::get_if<resolved_export>(r.get());
+}
+const resolved_call* as_resolved_call(const r_expr& r) {
+    return std::get_if<resolved_call>(r.get());
+}
+const resolved_object* as_resolved_object(const r_expr& r) {
+    return std::get_if<resolved_object>(r.get());
+}
+const resolved_let* as_resolved_let(const r_expr& r) {
+    return std::get_if<resolved_let>(r.get());
+}
+const resolved_conditional* as_resolved_conditional(const r_expr& r) {
+    return std::get_if<resolved_conditional>(r.get());
+}
+const resolved_float* as_resolved_float(const r_expr& r) {
+    return std::get_if<resolved_float>(r.get());
+}
+const resolved_int* as_resolved_int(const r_expr& r) {
+    return std::get_if<resolved_int>(r.get());
+}
+const resolved_unary* as_resolved_unary(const r_expr& r) {
+    return std::get_if<resolved_unary>(r.get());
+}
+const resolved_binary* as_resolved_binary(const r_expr& r) {
+    return std::get_if<resolved_binary>(r.get());
+}
 
 } // namespace al
 } // namespace resolved_ir
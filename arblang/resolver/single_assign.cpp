@@ -252,16 +252,16 @@ resolved_mechanism single_assign(const resolved_mechanism& e) {
 
     // Get all globally available symbols and mark them as reserved.
     for (const auto& c: e.constants) {
-        globals.insert(is_resolved_constant(c)->name);
+        globals.insert(as_resolved_constant(c)->name);
     }
     for (const auto& c: e.parameters) {
-        globals.insert(is_resolved_parameter(c)->name);
+        globals.insert(as_resolved_parameter(c)->name);
     }
     for (const auto& c: e.bindings) {
-        globals.insert(is_resolved_bind(c)->name);
+        globals.insert(as_resolved_bind(c)->name);
     }
     for (const auto& c: e.states) {
-        globals.insert(is_resolved_state(c)->name);
+        globals.insert(as_resolved_state(c)->name);
     }
 
     // Handle expressions
@@ -305,6 +305,14 @@ resolved_mechanism single_assign(const resolved_mechanism& e) {
         mech.on_events.push_back(single_assign(c, reserved, rewrites, pref));
     }
 
+    // All post_events share the same reserved_map because they share the
+    // same API call.
+    reserved = globals;
+    for (const auto& c: e.post_events) {
+        rewrites.clear();
+        mech.post_events.push_back(single_assign(c, reserved, rewrites, pref));
+    }
+
     // All evolutions share the same reserved_map because they share the
     // same API call.
     reserved = globals;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 
 #include <arblang/optimizer/optimizer.hpp>
@@ -20,6 +21,31 @@ resolved_effect form_ig_pair(const resolved_effect& e,
                             const std::string& i_name,
                             const std::string& g_name);
 
+void check_solver_options(const resolved_mechanism& e, const solver_options& opt) {
+    if (opt.newton_iterations == 0) {
+        throw std::runtime_error("The number of Newton iterations for non-linear ODEs has to be at least 1");
+    }
+    for (const auto& [name, scheme]: opt.state_schemes) {
+        auto dot = name.find('.');
+        auto state_name = name.substr(0, dot);
+        auto it = std::find_if(e.states.begin(), e.states.end(), [&](const auto& s) {
+            return as_resolved_state(s)->name == state_name;
+        });
+        if (it == e.states.end()) {
+            throw std::runtime_error(fmt::format("ODE scheme {} given for {}, which is not a state of the mechanism",
+                                                 to_string(scheme), name));
+        }
+        if (dot == std::string::npos) continue;
+
+        auto field = name.substr(dot+1);
+        auto rec = is_resolved_record_type(as_resolved_state(*it)->type);
+        if (!rec || std::none_of(rec->fields.begin(), rec->fields.end(), [&](const auto& f) {return f.first == field;})) {
+            throw std::runtime_error(fmt::format("ODE scheme {} given for {}, which is not a field of state {}",
+                                                 to_string(scheme), name, state_name));
+        }
+    }
+}
+
 // At this point in the compilation, ODEs have not yet been solved
 // And contributions to the current do not contain a contribution
 // to the conductance.
@@ -27,7 +53,12 @@ resolved_effect form_ig_pair(const resolved_effect& e,
 // from any current contributions.
 // A prefix for the current and conductance names needs to be passed
 // to the function. The same prefix is needed in the preprinting stage.
-resolved_mechanism solve(const resolved_mechanism& e, const std::string& i_name, const std::string& g_name) {
+// The integration scheme of each ODE is selected by `opt`.
+resolved_mechanism solve(const resolved_mechanism& e,
+                         const std::string& i_name,
+                         const std::string& g_name,
+                         const solver_options& opt)
+{
     resolved_mechanism mech;
     if (!e.constants.empty()) {
         throw std::runtime_error("Internal compiler error, unexpected constant at this stage of the compiler");
@@ -35,6 +66,7 @@ resolved_mechanism solve(const resolved_mechanism& e, const std::string& i_name,
     if (!e.functions.empty()) {
         throw std::runtime_error("Internal compiler error, unexpected function at this stage of the compiler");
     }
+    check_solver_options(e, opt);
     for (const auto& c: e.parameters) {
         mech.parameters.push_back(c);
     }
@@ -47,16 +79,20 @@ resolved_mechanism solve(const resolved_mechanism& e, const std::string& i_name,
     for (const auto& c: e.on_events) {
         mech.on_events.push_back(c);
     }
+    for (const auto& c: e.post_events) {
+        mech.post_events.push_back(c);
+    }
+    std::unordered_set<std::string> solver_temps;
     for (const auto& c: e.evolutions) {
         // Solve the ODE of a resolved_evolve
-        auto ev = is_resolved_evolve(c).value();
-        auto s = solver(ev);
+        const auto& ev = *as_resolved_evolve(c);
+        auto s = solver(ev, solver_temps, opt);
         mech.evolutions.push_back(make_rexpr<resolved_evolve>(s.solve()));
     }
     std::string v_sym = {};
     for (const auto& c: e.bindings) {
         mech.bindings.push_back(c);
-        auto b = is_resolved_bind(c).value();
+        const auto& b = *as_resolved_bind(c);
         if (b.bind == bindable::membrane_potential) {
             v_sym = b.name;
         }
@@ -71,7 +107,7 @@ resolved_mechanism solve(const resolved_mechanism& e, const std::string& i_name,
         // current_density_pair or current_pair containing the
         // {current_density, conductivity} and {current, conductance}
         // contributions respectively.
-        auto effect = is_resolved_effect(c).value();
+        const auto& effect = *as_resolved_effect(c);
         mech.effects.push_back(make_rexpr<resolved_effect>(form_ig_pair(effect, v_sym, temps, i_name, g_name)));
     }
     for (const auto& c: e.exports) {
@@ -103,8 +139,8 @@ resolved_effect form_ig_pair(const resolved_effect& e,
     bool has_let = false;
 
     r_expr i = e.value;
-    if (auto let_opt = is_resolved_let(e.value)) {
-        auto let = let_opt.value();
+    if (auto let_opt = as_resolved_let(e.value)) {
+        auto let = *let_opt;
         concat_let = let;
         i = get_innermost_body(&let);
         has_let = true;
@@ -3,10 +3,13 @@
 #include <unordered_map>
 
 #include <arblang/resolver/canonicalize.hpp>
+#include <arblang/resolver/single_assign.hpp>
 #include <arblang/optimizer/optimizer.hpp>
 #include <arblang/solver/solve_ode.hpp>
+#include <arblang/solver/sparse_elimination.hpp>
 #include <arblang/solver/symbolic_diff.hpp>
 #include <arblang/util/pretty_printer.hpp>
+#include <arblang/util/unique_name.hpp>
 
 #include <fmt/core.h>
 
@@ -15,15 +18,46 @@
 namespace al {
 namespace resolved_ir {
 
-solver::solver(const resolved_evolve& e):
+std::string to_string(ode_scheme s) {
+    switch (s) {
+        case ode_scheme::cnexp:          return "cnexp";
+        case ode_scheme::pade_11:        return "pade11";
+        case ode_scheme::pade_22:        return "pade22";
+        case ode_scheme::euler:          return "euler";
+        case ode_scheme::backward_euler: return "backward-euler";
+    }
+    return {};
+}
+
+std::optional<ode_scheme> parse_ode_scheme(const std::string& s) {
+    for (auto scheme: {ode_scheme::cnexp, ode_scheme::pade_11, ode_scheme::pade_22,
+                       ode_scheme::euler, ode_scheme::backward_euler}) {
+        if (s == to_string(scheme)) return scheme;
+    }
+    return {};
+}
+
+ode_scheme solver_options::scheme_of(const std::string& state, const std::string& field) const {
+    if (!field.empty() && state_schemes.count(state + "." + field)) {
+        return state_schemes.at(state + "." + field);
+    }
+    if (state_schemes.count(state)) {
+        return state_schemes.at(state);
+    }
+    return scheme;
+}
+
+solver::solver(const resolved_evolve& e, std::unordered_set<std::string>& temps, const solver_options& opt):
     evolve(e),
     state_id(e.identifier),
     state_type(type_of(state_id)),
-    state_loc(location_of(state_id))
+    state_loc(location_of(state_id)),
+    opt(opt),
+    temps(temps)
 {
     // The identifier of the evolve_expression is expected to be a
     // resolved_argument referring to a state variable.
-    auto arg = is_resolved_argument(state_id);
+    auto arg = as_resolved_argument(state_id);
     if (!arg) {
         throw std::runtime_error("Internal compiler error, expected a resolved_argument as the "
                                  "identifier of the resolved_evolve at " + to_string(state_loc));
@@ -33,8 +67,8 @@ solver::solver(const resolved_evolve& e):
     // The rhs of the ODE
     state_deriv = e.value;
     state_deriv_body = state_deriv;
-    if (auto let = is_resolved_let(state_deriv)) {
-        state_deriv_body = get_innermost_body(&let.value());
+    if (auto let = as_resolved_let(state_deriv)) {
+        state_deriv_body = get_innermost_body(let);
     }
 }
 
@@ -76,7 +110,7 @@ r_expr solver::get_a() {
     // The state is expected to be either a resolved_object or a resolved_variable
     auto record_state = is_resolved_record_type(state_type);
     if (record_state) {
-        auto obj = is_resolved_object(state_deriv_body);
+        auto obj = as_resolved_object(state_deriv_body);
         if (!obj) {
             throw std::runtime_error("Internal compiler error, expected a resolved_object as the "
                                      "result of the resolved_evolve at " + to_string(state_loc));
@@ -86,7 +120,7 @@ r_expr solver::get_a() {
         // each of the fields w.r.t the corresponding state field.
         std::vector<r_expr> field_symdiff;
         for (const auto& field: obj->record_fields) {
-            auto fld = is_resolved_variable(field);
+            auto fld = as_resolved_variable(field);
             if (!fld) {
                 throw std::runtime_error("Internal compiler error, expected a resolved_varialbe as the "
                                          "field of the resolved_object at " + to_string(obj->loc));
@@ -125,14 +159,51 @@ r_expr solver::get_a() {
     }
 
     // Recanonicalize the derivatives with a new prefix to avoid name collisions.
-    e_symdiff = canonicalize(e_symdiff, "d");
+    e_symdiff = canonicalize(e_symdiff, temps, "d");
 
     // Reoptimize the obtained expressions.
     auto opt_a = optimizer(e_symdiff);
     return opt_a.optimize();
 }
 
-r_expr solver::generate_solution(const r_expr& a, const r_expr& b, const r_expr& x) {
+// Approximation of exp(t) used by each scheme.
+r_expr exp_approximation(const r_expr& t, ode_scheme scheme) {
+    auto empty_loc = src_location{};
+    auto real_type = make_rtype<resolved_quantity>(quantity::real, empty_loc);
+
+    auto num = [&](double v) {
+        return make_rexpr<resolved_float>(v, real_type, empty_loc);
+    };
+    auto bin = [&](binary_op op, const r_expr& lhs, const r_expr& rhs) {
+        return make_rexpr<resolved_binary>(op, lhs, rhs, empty_loc);
+    };
+
+    switch (scheme) {
+        case ode_scheme::cnexp: {
+            return make_rexpr<resolved_unary>(unary_op::exp, t, empty_loc);
+        }
+        case ode_scheme::pade_11: {
+            // exp(t) = (1+0.5*t)/(1-0.5*t)
+            auto half_t = bin(binary_op::mul, num(0.5), t);
+            return bin(binary_op::div, bin(binary_op::add, num(1.), half_t), bin(binary_op::sub, num(1.), half_t));
+        }
+        case ode_scheme::pade_22: {
+            // exp(t) = (12+6*t+t^2)/(12-6*t+t^2) = (12+t*(t+6))/(12+t*(t-6))
+            auto p_term = bin(binary_op::mul, t, bin(binary_op::add, t, num(6.)));
+            auto q_term = bin(binary_op::mul, t, bin(binary_op::sub, t, num(6.)));
+            return bin(binary_op::div, bin(binary_op::add, num(12.), p_term), bin(binary_op::add, num(12.), q_term));
+        }
+        case ode_scheme::euler: {
+            return bin(binary_op::add, num(1.), t);
+        }
+        case ode_scheme::backward_euler: {
+            return bin(binary_op::div, num(1.), bin(binary_op::sub, num(1.), t));
+        }
+    }
+    throw std::runtime_error(fmt::format("Internal compiler error, unhandled ODE scheme {}", to_string(scheme)));
+}
+
+r_expr solver::generate_solution(const r_expr& a, const r_expr& b, const r_expr& x, ode_scheme scheme) {
     // Solving x' = x*a + b
 
     // TODO: check monolinearity! This is needed to make sure we don't attempt to
@@ -142,46 +213,550 @@ r_expr solver::generate_solution(const r_expr& a, const r_expr& b, const r_expr&
     auto b_opt = is_number(optimizer(b).optimize());
 
     auto empty_loc = src_location{};
+    auto real_type = make_rtype<resolved_quantity>(quantity::real, empty_loc);
     auto time_type = make_rtype<resolved_quantity>(normalized_type(quantity::time), empty_loc);
     auto dt = make_rexpr<resolved_argument>("dt", time_type, empty_loc);
 
+    auto num = [&](double v) {
+        return make_rexpr<resolved_float>(v, real_type, empty_loc);
+    };
+    auto bin = [&](binary_op op, const r_expr& lhs, const r_expr& rhs) {
+        return make_rexpr<resolved_binary>(op, lhs, rhs, empty_loc);
+    };
+
     if (a_opt && (a_opt.value() == 0)) {
-        // x' = b becomes x = x + b*dt;
-        auto b_dt = make_rexpr<resolved_binary>(binary_op::mul, b, dt, empty_loc);
-        return make_rexpr<resolved_binary>(binary_op::add, x, b_dt, empty_loc);
+        // x' = b becomes x = x + b*dt; for every scheme.
+        return bin(binary_op::add, x, bin(binary_op::mul, b, dt));
     }
+
+    auto a_dt = bin(binary_op::mul, a, dt);
+    switch (scheme) {
+        case ode_scheme::euler: {
+            // x = x + (a*x + b)*dt;
+            auto deriv = bin(binary_op::add, bin(binary_op::mul, a, x), b);
+            return bin(binary_op::add, x, bin(binary_op::mul, deriv, dt));
+        }
+        case ode_scheme::backward_euler: {
+            // x = (x + b*dt)/(1 - a*dt);
+            auto num_term = bin(binary_op::add, x, bin(binary_op::mul, b, dt));
+            return bin(binary_op::div, num_term, bin(binary_op::sub, num(1.), a_dt));
+        }
+        default: break;
+    }
+
+    // The remaining schemes differ in the approximation of exp(a*dt).
+    auto exp_term = exp_approximation(a_dt, scheme);
+
     if (b_opt && (b_opt.value() == 0)) {
         // x' = a*x becomes x = x*exp(a*dt);
-        auto a_dt = make_rexpr<resolved_binary>(binary_op::mul, a, dt, empty_loc);
-        auto exp_a_dt = make_rexpr<resolved_unary>(unary_op::exp, a_dt, empty_loc);
-        return make_rexpr<resolved_binary>(binary_op::add, x, exp_a_dt, empty_loc);
+        return bin(binary_op::mul, x, exp_term);
     }
+
     // x' = a*x + b becomes x = -b/a + (x+b/a)*exp(a*dt);
+    auto b_div_a  = bin(binary_op::div, b, a);
+    auto add_term = bin(binary_op::add, x, b_div_a);
+    auto mul_term = bin(binary_op::mul, add_term, exp_term);
+    auto neg_term = make_rexpr<resolved_unary>(unary_op::neg, b_div_a, empty_loc);
+    return bin(binary_op::add, neg_term, mul_term);
+}
 
-    auto b_div_a  = make_rexpr<resolved_binary>(binary_op::div, b, a, empty_loc);
-    auto a_mul_dt = make_rexpr<resolved_binary>(binary_op::mul, a, dt, empty_loc);
+// Follow resolved_variables to the expression they are bound to.
+r_expr deref(r_expr e) {
+    while (auto v = as_resolved_variable(e)) {
+        e = v->value;
+    }
+    return e;
+}
 
-    // instead of exp use the pade approximation: exp(t) = (1+0.5*t)/(1-0.5*t)
-    auto half           = make_rexpr<resolved_float>(0.5, make_rtype<resolved_quantity>(quantity::real, empty_loc), empty_loc);
-    auto half_a_mul_dt  = make_rexpr<resolved_binary>(binary_op::mul, half, a_mul_dt, empty_loc);
-    auto one            = make_rexpr<resolved_float>(1., type_of(half_a_mul_dt), empty_loc);
-    auto one_minus_term = make_rexpr<resolved_binary>(binary_op::sub, one, half_a_mul_dt, empty_loc);
-    auto one_plus_term  = make_rexpr<resolved_binary>(binary_op::add, one, half_a_mul_dt, empty_loc);
-    auto exp_term = make_rexpr<resolved_binary>(binary_op::div, one_plus_term, one_minus_term, empty_loc);
+bool solver::depends_on_state(const r_expr& e, const std::string& field) {
+    return depends_on_state(e, field, depends_memo);
+}
 
-    auto add_term = make_rexpr<resolved_binary>(binary_op::add, x, b_div_a, empty_loc);
-    auto mul_term = make_rexpr<resolved_binary>(binary_op::mul, add_term, exp_term, empty_loc);
-    auto neg_term = make_rexpr<resolved_unary>(unary_op::neg, b_div_a, empty_loc);
-    return make_rexpr<resolved_binary>(binary_op::add, neg_term, mul_term, empty_loc);
+// Whether `e` depends on the state, or only on the field `field` of the state if given.
+// `memo` caches the result per let-bound variable and field.
+bool solver::depends_on_state(const r_expr& e, const std::string& field, std::unordered_map<std::string, bool>& memo) {
+    auto dep = [&](const r_expr& x) {return depends_on_state(x, field, memo);};
+    if (auto v = as_resolved_variable(e)) {
+        auto key = v->name + "." + field;
+        if (!memo.count(key)) {
+            memo[key] = dep(v->value);
+        }
+        return memo.at(key);
+    }
+    if (auto a = as_resolved_argument(e)) {
+        return field.empty() && a->name == state_name;
+    }
+    if (auto f = as_resolved_field_access(e)) {
+        if (!field.empty() && f->field != field) return false;
+        if (auto a = as_resolved_argument(f->object)) return a->name == state_name;
+        return dep(f->object);
+    }
+    if (auto u = as_resolved_unary(e)) {
+        return dep(u->arg);
+    }
+    if (auto b = as_resolved_binary(e)) {
+        return dep(b->lhs) || dep(b->rhs);
+    }
+    if (auto c = as_resolved_conditional(e)) {
+        return dep(c->condition) || dep(c->value_true) || dep(c->value_false);
+    }
+    if (auto l = as_resolved_let(e)) {
+        return dep(l->id_value()) || dep(l->body);
+    }
+    if (auto o = as_resolved_object(e)) {
+        for (const auto& f: o->field_values()) {
+            if (dep(f)) return true;
+        }
+    }
+    return false;
+}
+
+// Whether `e` is the state, or the field `field` of the state.
+bool solver::is_state(const r_expr& e, const std::string& field) {
+    auto x = deref(e);
+    if (field.empty()) {
+        auto arg = as_resolved_argument(x);
+        return arg && arg->name == state_name;
+    }
+    auto access = as_resolved_field_access(x);
+    if (!access || access->field != field) return false;
+    auto arg = as_resolved_argument(deref(access->object));
+    return arg && arg->name == state_name;
+}
+
+// Recognize the relaxation x' = (x_inf - x)/tau, up to factors and divisors that
+// don't depend on the state, and the following forms of the numerator:
+//   -x; x; c - x; x - c; c - x*p; c - p*x
+std::optional<solver::relaxation> solver::match_relaxation(const r_expr& deriv, const std::string& field) {
+    auto empty_loc = src_location{};
+    auto time_type = make_rtype<resolved_quantity>(normalized_type(quantity::time), empty_loc);
+    auto dt = make_rexpr<resolved_argument>("dt", time_type, empty_loc);
+
+    // Peel off the factors and divisors.
+    std::vector<std::pair<binary_op, r_expr>> scale;
+    auto num = deref(deriv);
+    while (auto bin = as_resolved_binary(num)) {
+        if (bin->op == binary_op::div && !depends_on_state(bin->rhs)) {
+            scale.emplace_back(binary_op::div, bin->rhs);
+            num = deref(bin->lhs);
+        }
+        else if (bin->op == binary_op::mul && !depends_on_state(bin->rhs)) {
+            scale.emplace_back(binary_op::mul, bin->rhs);
+            num = deref(bin->lhs);
+        }
+        else if (bin->op == binary_op::mul && !depends_on_state(bin->lhs)) {
+            scale.emplace_back(binary_op::mul, bin->lhs);
+            num = deref(bin->rhs);
+        }
+        else {
+            break;
+        }
+    }
+
+    // Match the numerator: num = sign*p*(x - x_inf)
+    r_expr x_inf, p;
+    bool negate = false;
+    if (is_state(num, field)) {
+        x_inf = make_rexpr<resolved_int>(0, type_of(num), empty_loc);
+    }
+    else if (auto u = as_resolved_unary(num); u && u->op == unary_op::neg && is_state(u->arg, field)) {
+        x_inf = make_rexpr<resolved_int>(0, type_of(num), empty_loc);
+        negate = true;
+    }
+    else if (auto b = as_resolved_binary(num); b && b->op == binary_op::sub) {
+        if (is_state(b->lhs, field) && !depends_on_state(b->rhs)) {
+            x_inf = b->rhs;
+        }
+        else if (is_state(b->rhs, field) && !depends_on_state(b->lhs)) {
+            x_inf = b->lhs;
+            negate = true;
+        }
+        else if (auto m = as_resolved_binary(deref(b->rhs)); m && m->op == binary_op::mul && !depends_on_state(b->lhs)) {
+            if (is_state(m->lhs, field) && !depends_on_state(m->rhs)) {
+                p = m->rhs;
+            }
+            else if (is_state(m->rhs, field) && !depends_on_state(m->lhs)) {
+                p = m->lhs;
+            }
+            else {
+                return {};
+            }
+            x_inf = make_rexpr<resolved_binary>(binary_op::div, b->lhs, p, empty_loc);
+            negate = true;
+        }
+        else {
+            return {};
+        }
+    }
+    else {
+        return {};
+    }
+
+    // time_scale = sign*p*scale*dt
+    r_expr t = dt;
+    for (const auto& [op, f]: scale) {
+        t = make_rexpr<resolved_binary>(op, t, f, empty_loc);
+    }
+    if (p) {
+        t = make_rexpr<resolved_binary>(binary_op::mul, t, p, empty_loc);
+    }
+    if (negate) {
+        t = make_rexpr<resolved_unary>(unary_op::neg, t, empty_loc);
+    }
+    return relaxation{x_inf, t};
+}
+
+r_expr solver::generate_relaxation(const relaxation& r, const r_expr& x, ode_scheme scheme) {
+    // x' = (x - x_inf)*rate becomes x = x_inf + (x - x_inf)*exp(rate*dt);
+    // Every scheme can be written in this form: forward Euler uses 1+t and
+    // backward Euler 1/(1-t) as the approximation of exp(t).
+    auto empty_loc = src_location{};
+    auto exp_term = exp_approximation(r.time_scale, scheme);
+
+    auto x_inf = is_number(r.x_inf);
+    if (x_inf && x_inf.value() == 0) {
+        return make_rexpr<resolved_binary>(binary_op::mul, x, exp_term, empty_loc);
+    }
+    auto diff_term = make_rexpr<resolved_binary>(binary_op::sub, x, r.x_inf, empty_loc);
+    auto mul_term  = make_rexpr<resolved_binary>(binary_op::mul, diff_term, exp_term, empty_loc);
+    return make_rexpr<resolved_binary>(binary_op::add, r.x_inf, mul_term, empty_loc);
+}
+
+// The fields of the state and their derivatives.
+// A state that is not a record is a single field with an empty name.
+solver::ode_fields solver::state_fields() {
+    ode_fields sys;
+    auto obj = as_resolved_object(state_deriv_body);
+    if (!obj) {
+        sys.names.push_back({});
+        sys.types.push_back(state_type);
+        sys.values.push_back(state_deriv_body);
+        return sys;
+    }
+
+    auto state_rec = is_resolved_record_type(state_type).value();
+    for (const auto& field: obj->record_fields) {
+        auto fld = as_resolved_variable(field);
+        if (!fld || fld->name.back() != '\'') {
+            throw std::runtime_error(fmt::format("Internal compiler error, expected a \' at the end of the name of the "
+                                                 "state_field at {}", to_string(obj->loc)));
+        }
+        auto f_name = fld->name.substr(0, fld->name.size()-1);
+        for (const auto& [f_id, f_type]: state_rec.fields) {
+            if (f_id == f_name) sys.types.push_back(f_type);
+        }
+        sys.names.push_back(f_name);
+        sys.values.push_back(fld->value);
+    }
+    return sys;
+}
+
+// Sparsity pattern and entries of the Jacobian.
+void solver::differentiate(ode_fields& sys) {
+    auto n = (unsigned)sys.names.size();
+    sys.jacobian.assign(n, std::vector<r_expr>(n));
+    for (unsigned i = 0; i < n; ++i) {
+        for (unsigned j = 0; j < n; ++j) {
+            if (!depends_on_state(sys.values[i], sys.names[j])) continue;
+
+            auto J_ij = sym_diff(sys.values[i], {state_name, sys.names[j].empty()? std::nullopt: std::optional(sys.names[j]), sys.types[j]});
+            sys.jacobian[i][j] = J_ij;
+            sys.coupled |= (i != j);
+
+            // The system is linear if the Jacobian doesn't depend on the state.
+            std::unordered_map<std::string, bool> memo;
+            auto J_opt = optimizer(canonicalize(J_ij, "d")).optimize();
+            sys.linear &= !depends_on_state(J_opt, {}, memo);
+        }
+    }
+}
+
+// The field `i` of a state value.
+r_expr solver::field_of(const ode_fields& sys, const r_expr& state, unsigned i) {
+    if (sys.names[i].empty()) return state;
+    return make_rexpr<resolved_field_access>(state, sys.names[i], sys.types[i], state_loc);
+}
+
+// A state value with the given fields.
+r_expr solver::make_state(const ode_fields& sys, const std::vector<r_expr>& values) {
+    if (sys.names.size() == 1 && sys.names.front().empty()) return values.front();
+
+    std::vector<r_expr> fields;
+    for (unsigned i = 0; i < values.size(); ++i) {
+        fields.push_back(make_rexpr<resolved_variable>(sys.names[i], values[i], sys.types[i], state_loc));
+    }
+    return make_rexpr<resolved_object>(fields, state_type, state_loc);
+}
+
+// The step size h of the implicit scheme (I - h*J)*dx = ...
+r_expr solver::implicit_step(ode_scheme scheme, const std::string& kind) {
+    auto empty_loc = src_location{};
+    auto time_type = make_rtype<resolved_quantity>(normalized_type(quantity::time), empty_loc);
+    auto real_type = make_rtype<resolved_quantity>(quantity::real, empty_loc);
+    auto dt = make_rexpr<resolved_argument>("dt", time_type, empty_loc);
 
-    // TODO: Special case when x' = (b-x)/a; rather than
-    //       implement more general algebraic simplification, jump
-    //       straight to simplified update: x = b + (x-b)*exp(-dt/a).
+    switch (scheme) {
+        case ode_scheme::backward_euler: return dt;
+        case ode_scheme::pade_11: {
+            auto half = make_rexpr<resolved_float>(0.5, real_type, empty_loc);
+            return make_rexpr<resolved_binary>(binary_op::mul, half, dt, empty_loc);
+        }
+        default:
+            throw std::runtime_error(fmt::format("ODE scheme {} is not supported for the {} state {} "
+                                                 "at {}, use pade11, backward-euler or euler", to_string(scheme),
+                                                 kind, state_name, to_string(evolve.loc)));
+    }
+}
+
+// The system I - h*J as a sparse_system, without right hand side.
+sparse_system solver::implicit_matrix(const ode_fields& sys,
+                                      const std::vector<std::vector<r_expr>>& jacobian,
+                                      const r_expr& h)
+{
+    auto empty_loc = src_location{};
+    auto real_type = make_rtype<resolved_quantity>(quantity::real, empty_loc);
+    auto n = (unsigned)sys.names.size();
+
+    sparse_system A;
+    A.A.resize(n);
+    for (unsigned i = 0; i < n; ++i) {
+        for (unsigned j = 0; j < n; ++j) {
+            if (!jacobian[i][j]) {
+                if (i == j) A.A[i][j] = make_rexpr<resolved_float>(1., real_type, empty_loc);
+                continue;
+            }
+            auto h_J = make_rexpr<resolved_binary>(binary_op::mul, h, jacobian[i][j], empty_loc);
+            if (i == j) {
+                auto one = make_rexpr<resolved_float>(1., type_of(h_J), empty_loc);
+                A.A[i][j] = make_rexpr<resolved_binary>(binary_op::sub, one, h_J, empty_loc);
+            }
+            else {
+                A.A[i][j] = make_rexpr<resolved_unary>(unary_op::neg, h_J, empty_loc);
+            }
+        }
+    }
+    return A;
+}
+
+// Solve x' = f(x) for a state whose fields are coupled, with f linear in x.
+// With J the Jacobian of f, the update x + dx is found by solving
+//   (I - h*J)*dx = dt*f(x)
+// with h = dt for backward Euler, and h = dt/2 for Crank-Nicolson (the (1,1)
+// Pade approximant of the matrix exponential). The sparse system is solved by
+// symbolic Gaussian elimination in minimum degree order.
+r_expr solver::solve_coupled(const ode_fields& sys) {
+    auto empty_loc = src_location{};
+    auto time_type = make_rtype<resolved_quantity>(normalized_type(quantity::time), empty_loc);
+    auto dt = make_rexpr<resolved_argument>("dt", time_type, empty_loc);
+    auto n = (unsigned)sys.names.size();
+
+    auto scheme = uniform_scheme(sys, "coupled");
+    std::vector<r_expr> x_new;
+    if (scheme == ode_scheme::euler) {
+        // x = x + dt*f(x);
+        for (unsigned i = 0; i < n; ++i) {
+            auto dx = make_rexpr<resolved_binary>(binary_op::mul, dt, sys.values[i], empty_loc);
+            x_new.push_back(make_rexpr<resolved_binary>(binary_op::add, field_of(sys, state_id, i), dx, empty_loc));
+        }
+        return make_state(sys, x_new);
+    }
+
+    auto A = implicit_matrix(sys, sys.jacobian, implicit_step(scheme, "coupled"));
+    for (unsigned i = 0; i < n; ++i) {
+        A.b.push_back(make_rexpr<resolved_binary>(binary_op::mul, dt, sys.values[i], empty_loc));
+    }
+
+    std::vector<r_expr> defs;
+    auto dx = gaussian_elimination(A, min_degree_order(A), temps, "l", defs);
+    for (unsigned i = 0; i < n; ++i) {
+        x_new.push_back(make_rexpr<resolved_binary>(binary_op::add, field_of(sys, state_id, i), dx[i], empty_loc));
+    }
+    return let_wrap(defs, make_state(sys, x_new));
+}
+
+// Solve x' = f(x) for a state with f non-linear in x, using a fixed number of
+// Newton iterations on the residual of the implicit scheme:
+//   G(y) = y - x - dt*f(y)              (backward Euler)
+//   G(y) = y - x - dt/2*(f(x) + f(y))   (Crank-Nicolson)
+// starting from y = x. Each iteration solves (I - h*J(y))*dy = -G(y).
+// f and J are re-evaluated at every iterate, from a copy of the let-bindings
+// of the derivative; the elimination order is computed once and reused.
+r_expr solver::solve_newton(const ode_fields& sys) {
+    auto empty_loc = src_location{};
+    auto time_type = make_rtype<resolved_quantity>(normalized_type(quantity::time), empty_loc);
+    auto dt = make_rexpr<resolved_argument>("dt", time_type, empty_loc);
+    auto n = (unsigned)sys.names.size();
+
+    auto bin = [&](binary_op op, const r_expr& lhs, const r_expr& rhs) {
+        return make_rexpr<resolved_binary>(op, lhs, rhs, empty_loc);
+    };
+
+    auto scheme = uniform_scheme(sys, "non-linear");
+    if (scheme == ode_scheme::euler) {
+        // x = x + dt*f(x);
+        std::vector<r_expr> x_new;
+        for (unsigned i = 0; i < n; ++i) {
+            x_new.push_back(bin(binary_op::add, field_of(sys, state_id, i), bin(binary_op::mul, dt, sys.values[i])));
+        }
+        return make_state(sys, x_new);
+    }
+    auto h = implicit_step(scheme, "non-linear");
+    bool crank_nicolson = scheme == ode_scheme::pade_11;
+
+    // Template evaluating f and the non-zero entries of J in the let-bindings
+    // of the derivative, as the fields of an object.
+    std::vector<std::pair<std::string, r_type>> tmpl_types;
+    std::vector<r_expr> tmpl_fields;
+    auto add_field = [&](const r_expr& v) {
+        auto name = "f" + std::to_string(tmpl_fields.size());
+        tmpl_types.emplace_back(name, type_of(v));
+        tmpl_fields.push_back(make_rexpr<resolved_variable>(name, v, type_of(v), empty_loc));
+    };
+    for (unsigned i = 0; i < n; ++i) {
+        add_field(sys.values[i]);
+    }
+    for (unsigned i = 0; i < n; ++i) {
+        for (unsigned j = 0; j < n; ++j) {
+            if (sys.jacobian[i][j]) add_field(sys.jacobian[i][j]);
+        }
+    }
+    auto tmpl_type = make_rtype<resolved_record>(tmpl_types, empty_loc);
+    auto tmpl = canonicalize(make_rexpr<resolved_object>(tmpl_fields, tmpl_type, empty_loc), temps, "j");
+    if (auto let_opt = as_resolved_let(state_deriv)) {
+        auto let = *let_opt;
+        set_innermost_body(&let, tmpl);
+        tmpl = make_rexpr<resolved_let>(let);
+    }
+
+    // The let-bindings of the template are renamed in each copy.
+    for (auto e = tmpl; auto let = as_resolved_let(e); e = let->body) {
+        temps.insert(let->id_name());
+    }
+
+    std::vector<r_expr> defs;
+    auto bind = [&](const r_expr& val) {
+        auto var = make_rexpr<resolved_variable>(unique_local_name(temps, "l"), val, type_of(val), empty_loc);
+        defs.push_back(var);
+        return var;
+    };
+
+    std::vector<unsigned> order;
+    std::vector<r_expr> y;
+    for (unsigned i = 0; i < n; ++i) {
+        y.push_back(field_of(sys, state_id, i));
+    }
+    for (unsigned k = 0; k < opt.newton_iterations; ++k) {
+        // Evaluate f and J at y. At the first iterate, y = x, and the let-bindings
+        // of the derivative can be used directly.
+        std::vector<r_expr> f_y = sys.values;
+        std::vector<std::vector<r_expr>> J_y = sys.jacobian;
+        if (k > 0) {
+            std::unordered_map<std::string, r_expr> copies = {{state_name, make_state(sys, y)}}, rewrites;
+            auto e = copy_propagate(tmpl, copies).first;
+            e = single_assign(e, temps, rewrites, "n");
+            for (auto let = as_resolved_let(e); let; let = as_resolved_let(e)) {
+                defs.push_back(let->identifier);
+                e = let->body;
+            }
+            auto values = as_resolved_object(e)->field_values();
+            unsigned idx = 0;
+            for (unsigned i = 0; i < n; ++i) {
+                f_y[i] = values[idx++];
+            }
+            for (unsigned i = 0; i < n; ++i) {
+                for (unsigned j = 0; j < n; ++j) {
+                    if (sys.jacobian[i][j]) J_y[i][j] = values[idx++];
+                }
+            }
+        }
+
+        // -G(y) = x - y + h*(f(y) + f(x)) for Crank-Nicolson, x - y + dt*f(y) for backward Euler.
+        auto A = implicit_matrix(sys, J_y, h);
+        for (unsigned i = 0; i < n; ++i) {
+            auto x_i = field_of(sys, state_id, i);
+            auto f_sum = crank_nicolson? bin(binary_op::add, f_y[i], sys.values[i]): f_y[i];
+            auto rhs = bin(binary_op::mul, h, f_sum);
+            A.b.push_back(k == 0? rhs: bin(binary_op::add, bin(binary_op::sub, x_i, y[i]), rhs));
+        }
+        if (order.empty()) order = min_degree_order(A);
+
+        auto dy = gaussian_elimination(A, order, temps, "l", defs);
+        for (unsigned i = 0; i < n; ++i) {
+            y[i] = bind(bin(binary_op::add, y[i], dy[i]));
+        }
+    }
+    return let_wrap(defs, make_state(sys, y));
+}
+
+// The scheme of the state, which has to be the same for all of its fields.
+ode_scheme solver::uniform_scheme(const ode_fields& sys, const std::string& kind) {
+    auto scheme = opt.scheme_of(state_name);
+    for (const auto& f: sys.names) {
+        if (opt.scheme_of(state_name, f) != scheme) {
+            throw std::runtime_error(fmt::format("The fields of the {} state {} have to be solved with the "
+                                                 "same scheme at {}", kind, state_name, to_string(evolve.loc)));
+        }
+    }
+    return scheme;
 }
 
 resolved_evolve solver::solve() {
     // resolved_evolve statement is expected to be and ODE of the form x' = x*a + b
 
+    // Relaxations x' = (x_inf - x)/tau are solved directly from the derivative,
+    // without forming a and b, if all the fields of the state have that form.
+    r_expr relaxed;
+    if (auto obj = as_resolved_object(state_deriv_body)) {
+        auto state_rec = is_resolved_record_type(state_type).value();
+        std::vector<r_expr> fields;
+        for (const auto& field: obj->record_fields) {
+            auto fld = as_resolved_variable(field);
+            if (!fld || fld->name.back() != '\'') break;
+
+            auto f_name = fld->name.substr(0, fld->name.size()-1);
+            auto r = match_relaxation(fld->value, f_name);
+            if (!r) break;
+
+            auto f_type = type_of(fld->value);
+            for (const auto& [f_id, f_t]: state_rec.fields) {
+                if (f_id == f_name) f_type = f_t;
+            }
+            auto s_val = make_rexpr<resolved_field_access>(state_id, f_name, f_type, state_loc);
+            auto f_val = generate_relaxation(r.value(), s_val, opt.scheme_of(state_name, f_name));
+            fields.push_back(make_rexpr<resolved_variable>(f_name, f_val, f_type, fld->loc));
+        }
+        if (fields.size() == obj->record_fields.size()) {
+            relaxed = make_rexpr<resolved_object>(fields, state_type, state_loc);
+        }
+    }
+    else if (auto r = match_relaxation(state_deriv_body, {})) {
+        relaxed = generate_relaxation(r.value(), state_id, opt.scheme_of(state_name));
+    }
+
+    // States with a non-linear derivative are solved with Newton's method,
+    // records with coupled fields are solved as a linear system.
+    if (!relaxed) {
+        auto sys = state_fields();
+        differentiate(sys);
+        if (!sys.linear) {
+            relaxed = solve_newton(sys);
+        }
+        else if (sys.coupled) {
+            relaxed = solve_coupled(sys);
+        }
+    }
+
+    if (relaxed) {
+        // The solution refers to the let-bindings of the derivative.
+        relaxed = canonicalize(relaxed, temps, "s");
+        if (auto let_opt = as_resolved_let(state_deriv)) {
+            auto let = *let_opt;
+            set_innermost_body(&let, relaxed);
+            relaxed = make_rexpr<resolved_let>(let);
+        }
+        return resolved_evolve(state_id, optimizer(relaxed).optimize(), state_type, evolve.loc);
+    }
+
     auto b_expr = get_b();
     auto a_expr = get_a();
 
@@ -193,14 +768,14 @@ resolved_evolve solver::solve() {
 
     r_expr b_inner = b_expr;
     r_expr a_inner = a_expr;
-    if (auto let_opt = is_resolved_let(b_expr)) {
-        auto let = let_opt.value();
+    if (auto let_opt = as_resolved_let(b_expr)) {
+        auto let = *let_opt;
         concat_let = let;
         b_inner = get_innermost_body(&let);
         has_let = true;
     }
-    if (auto let_opt = is_resolved_let(a_expr)) {
-        auto let = let_opt.value();
+    if (auto let_opt = as_resolved_let(a_expr)) {
+        auto let = *let_opt;
         if (!has_let) {
             concat_let = let;
         } else {
@@ -213,18 +788,18 @@ resolved_evolve solver::solve() {
     // Form solution
     r_expr solution;
     // if the state variable is a record type, a and b will be record types.
-    auto a_obj = is_resolved_object(a_inner);
-    auto b_obj = is_resolved_object(b_inner);
-    auto b_var = is_resolved_variable(b_inner);
-    auto a_var = is_resolved_variable(a_inner);
+    auto a_obj = as_resolved_object(a_inner);
+    auto b_obj = as_resolved_object(b_inner);
+    auto b_var = as_resolved_variable(b_inner);
+    auto a_var = as_resolved_variable(a_inner);
 
     if (a_obj && b_obj) {
         assert(a_obj->record_fields.size() == b_obj->record_fields.size());
 
         std::vector<r_expr> fields;
         for (unsigned i = 0; i < a_obj->record_fields.size(); ++i) {
-            auto a_field = is_resolved_variable(a_obj->record_fields[i]);
-            auto b_field = is_resolved_variable(b_obj->record_fields[i]);
+            auto a_field = as_resolved_variable(a_obj->record_fields[i]);
+            auto b_field = as_resolved_variable(b_obj->record_fields[i]);
 
             if (!a_field || !b_field) {
                 throw std::runtime_error("Internal compiler error, expected a resolved_variable as the "
@@ -249,7 +824,7 @@ resolved_evolve solver::solve() {
             for (const auto& [f_id, f_type]: stype.fields) {
                 if (f_id == a_name) {
                     auto s_val = make_rexpr<resolved_field_access>(state_id, a_name, f_type, state_loc);
-                    fields.push_back(make_rexpr<resolved_variable>(a_name, generate_solution(a_val, b_val, s_val), f_type, a_field->loc));
+                    fields.push_back(make_rexpr<resolved_variable>(a_name, generate_solution(a_val, b_val, s_val, opt.scheme_of(state_name, a_name)), f_type, a_field->loc));
                     found = true;
                     break;
                 }
@@ -261,14 +836,15 @@ resolved_evolve solver::solve() {
         }
         solution = make_rexpr<resolved_object>(fields, state_type, state_loc);
     }
-    else if (a_var && b_var) {
-        auto a_val  = a_var->value;
-        auto b_val  = b_var->value;
-        solution = generate_solution(a_val, b_val, state_id);
+    else {
+        // a or b may have been optimized to a constant.
+        auto a_val  = a_var? a_var->value: a_inner;
+        auto b_val  = b_var? b_var->value: b_inner;
+        solution = generate_solution(a_val, b_val, state_id, opt.scheme_of(state_name));
     }
 
     // Recanonicalize the derivatives with a new prefix to avoid name collisions.
-    solution = canonicalize(solution, "s");
+    solution = canonicalize(solution, temps, "s");
 
     // Optimize the obtained expressions before returning.
     if (!has_let) return resolved_evolve(state_id, optimizer(solution).optimize(), state_type, evolve.loc);
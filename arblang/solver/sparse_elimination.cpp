@@ -0,0 +1,118 @@
+#include <set>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <arblang/solver/sparse_elimination.hpp>
+#include <arblang/util/unique_name.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+std::vector<unsigned> min_degree_order(const sparse_system& sys) {
+    auto n = sys.size();
+
+    std::vector<std::set<unsigned>> adj(n);
+    for (unsigned i = 0; i < n; ++i) {
+        for (const auto& [j, a]: sys.A[i]) {
+            if (i == j) continue;
+            adj[i].insert(j);
+            adj[j].insert(i);
+        }
+    }
+
+    std::vector<unsigned> order;
+    std::vector<bool> done(n, false);
+    while (order.size() < n) {
+        // Pick the remaining unknown with the fewest neighbours.
+        unsigned k = n;
+        for (unsigned i = 0; i < n; ++i) {
+            if (!done[i] && (k == n || adj[i].size() < adj[k].size())) k = i;
+        }
+
+        // Eliminating k connects all of its neighbours (fill-in).
+        for (auto i: adj[k]) {
+            adj[i].erase(k);
+            for (auto j: adj[k]) {
+                if (i != j) adj[i].insert(j);
+            }
+        }
+        adj[k].clear();
+        done[k] = true;
+        order.push_back(k);
+    }
+    return order;
+}
+
+std::vector<r_expr> gaussian_elimination(sparse_system sys,
+                                         const std::vector<unsigned>& order,
+                                         std::unordered_set<std::string>& reserved,
+                                         const std::string& prefix,
+                                         std::vector<r_expr>& defs)
+{
+    auto n = sys.size();
+    auto loc = src_location{};
+
+    auto bind = [&](const r_expr& val) {
+        auto var = make_rexpr<resolved_variable>(unique_local_name(reserved, prefix), val, type_of(val), loc);
+        defs.push_back(var);
+        return var;
+    };
+    auto bin = [&](binary_op op, const r_expr& lhs, const r_expr& rhs) {
+        return make_rexpr<resolved_binary>(op, lhs, rhs, loc);
+    };
+
+    // Forward elimination: afterwards, row k only refers to unknowns
+    // eliminated after k.
+    std::vector<bool> done(n, false);
+    for (auto k: order) {
+        if (!sys.A[k].count(k)) {
+            throw std::runtime_error(fmt::format("Internal compiler error, zero pivot in row {} of the "
+                                                 "linear system", k));
+        }
+        auto pivot = sys.A[k].at(k);
+        for (unsigned i = 0; i < n; ++i) {
+            if (done[i] || i == k || !sys.A[i].count(k)) continue;
+
+            auto factor = bind(bin(binary_op::div, sys.A[i].at(k), pivot));
+            for (const auto& [j, a_kj]: sys.A[k]) {
+                if (j == k || done[j]) continue;
+                auto update = bin(binary_op::mul, factor, a_kj);
+                if (sys.A[i].count(j)) {
+                    sys.A[i][j] = bind(bin(binary_op::sub, sys.A[i].at(j), update));
+                }
+                else {
+                    sys.A[i][j] = bind(make_rexpr<resolved_unary>(unary_op::neg, update, loc));
+                }
+            }
+            sys.b[i] = bind(bin(binary_op::sub, sys.b[i], bin(binary_op::mul, factor, sys.b[k])));
+            sys.A[i].erase(k);
+        }
+        done[k] = true;
+    }
+
+    // Back substitution.
+    std::vector<r_expr> x(n);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        auto k = *it;
+        auto sum = sys.b[k];
+        for (const auto& [j, a_kj]: sys.A[k]) {
+            if (j == k) continue;
+            sum = bin(binary_op::sub, sum, bin(binary_op::mul, a_kj, x[j]));
+        }
+        x[k] = bind(bin(binary_op::div, sum, sys.A[k].at(k)));
+    }
+    return x;
+}
+
+r_expr let_wrap(const std::vector<r_expr>& defs, const r_expr& body) {
+    auto result = body;
+    for (auto it = defs.rbegin(); it != defs.rend(); ++it) {
+        result = make_rexpr<resolved_let>(*it, result, type_of(result), location_of(*it));
+    }
+    return result;
+}
+
+} // namespace resolved_ir
+} // namespace al
@@ -32,9 +32,18 @@ r_expr sym_diff(const resolved_function& e, const diff_var& state) {
                              "this stage in the compilation (after inlining).");
 }
 
+// The derivative of a tabulated function is unknown: calls can only be
+// differentiated if their arguments don't depend on the derived value.
 r_expr sym_diff(const resolved_call& e, const diff_var& state) {
-    throw std::runtime_error("Internal compiler error, didn't expect a resolved_function at "
-                             "this stage in the compilation (after inlining).");
+    for (const auto& a: e.call_args) {
+        auto a_num = is_number(constant_fold(sym_diff(a, state)).first);
+        if (!a_num || a_num.value() != 0) {
+            throw std::runtime_error(fmt::format("Cannot differentiate tabulated function {} with respect to {} at {}. "
+                                                 "Tabulated functions can't depend on states.",
+                                                 e.f_identifier, state.sym, to_string(e.loc)));
+        }
+    }
+    return make_rexpr<resolved_int>(0, diff_type(e.type, state.type, e.loc), e.loc);
 }
 
 r_expr sym_diff(const resolved_constant& e, const diff_var& state) {
@@ -211,7 +220,7 @@ r_expr sym_diff(const resolved_field_access& e, const diff_var& state) {
     if (!state.sub_field) {
         return make_rexpr<resolved_int>(0, dtype, e.loc);
     }
-    if (auto arg = is_resolved_argument(e.object)) {
+    if (auto arg = as_resolved_argument(e.object)) {
         if (arg->name == state.sym && e.field == state.sub_field.value()) {
             return make_rexpr<resolved_int>(1, dtype, e.loc);
         }
@@ -0,0 +1,99 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <arblang/util/arena.hpp>
+
+namespace al {
+
+// Chunks are aligned to their size, so the chunk of a node is found by masking its address.
+static constexpr std::size_t chunk_size = 1 << 16;
+
+struct arena_chunk {
+    // Live allocations, plus one while the chunk is the current chunk of its thread.
+    std::atomic<std::size_t> live;
+    char* top;
+    char* end;
+};
+
+static void release(arena_chunk* c) noexcept {
+    if (c->live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        c->~arena_chunk();
+        std::free(c);
+    }
+}
+
+// The chunk currently allocated from by a thread, released when the thread exits.
+struct thread_arena {
+    arena_chunk* current = nullptr;
+    allocation_count count;
+
+    ~thread_arena() {
+        if (current) release(current);
+    }
+};
+
+static thread_local thread_arena arena;
+
+allocation_count operator-(const allocation_count& lhs, const allocation_count& rhs) {
+    return {lhs.nodes - rhs.nodes, lhs.bytes - rhs.bytes};
+}
+
+std::string to_string(const allocation_count& c) {
+    return std::to_string(c.nodes) + " nodes, " + std::to_string(c.bytes) + " bytes";
+}
+
+allocation_count ir_allocations() {
+    return arena.count;
+}
+
+static std::size_t chunk_offset() {
+    return (sizeof(arena_chunk) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+}
+
+static bool fits_chunk(std::size_t bytes, std::size_t align) {
+    return align <= alignof(std::max_align_t) && bytes <= chunk_size - chunk_offset();
+}
+
+void* arena_allocate(std::size_t bytes, std::size_t align) {
+    arena.count.nodes++;
+    arena.count.bytes += bytes;
+
+    // Too large for a chunk: fall back on the system allocator.
+    if (!fits_chunk(bytes, align)) {
+        return ::operator new(bytes, std::align_val_t(align));
+    }
+
+    auto aligned = [&](char* p) {
+        return (char*)(((std::uintptr_t)p + align - 1) & ~(std::uintptr_t)(align - 1));
+    };
+
+    auto c = arena.current;
+    if (!c || aligned(c->top) + bytes > c->end) {
+        auto mem = std::aligned_alloc(chunk_size, chunk_size);
+        if (!mem) throw std::bad_alloc();
+        auto fresh = new (mem) arena_chunk;
+        fresh->live.store(1, std::memory_order_relaxed);
+        fresh->top = (char*)mem + chunk_offset();
+        fresh->end = (char*)mem + chunk_size;
+        if (c) release(c);
+        arena.current = c = fresh;
+    }
+
+    auto p = aligned(c->top);
+    c->top = p + bytes;
+    c->live.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+void arena_deallocate(void* p, std::size_t bytes, std::size_t align) noexcept {
+    if (!fits_chunk(bytes, align)) {
+        ::operator delete(p, std::align_val_t(align));
+        return;
+    }
+    release((arena_chunk*)((std::uintptr_t)p & ~(std::uintptr_t)(chunk_size - 1)));
+}
+
+} // namespace al
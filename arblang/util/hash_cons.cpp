@@ -0,0 +1,77 @@
+#include <string>
+#include <vector>
+
+#include <arblang/util/custom_hash.hpp>
+#include <arblang/util/hash_cons.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+bool hash_cons::node::operator==(const node& other) const {
+    return hash == other.hash && kind == other.kind && op == other.op &&
+           (value == other.value || (value != value && other.value != other.value)) &&
+           name == other.name && operands == other.operands && *type == *other.type;
+}
+
+std::optional<hash_cons::id> hash_cons::intern(const r_expr& e) {
+    node n = {e->index(), 0, 0., {}, type_of(e), {}, 0};
+    std::vector<r_expr> operands;
+    if (auto v = as_resolved_variable(e)) {
+        auto it = bound_.find(v->name);
+        if (it != bound_.end()) return it->second;
+        // Names are unique after single assignment: a free variable is identified by its name.
+        n.name = v->name;
+    }
+    else if (auto a = as_resolved_argument(e)) {
+        n.name = a->name;
+    }
+    else if (auto f = as_resolved_float(e)) {
+        n.value = f->value;
+    }
+    else if (auto i = as_resolved_int(e)) {
+        n.value = i->value;
+    }
+    else if (auto u = as_resolved_unary(e)) {
+        n.op = (int)u->op;
+        operands = {u->arg};
+    }
+    else if (auto b = as_resolved_binary(e)) {
+        n.op = (int)b->op;
+        operands = {b->lhs, b->rhs};
+    }
+    else if (auto c = as_resolved_call(e)) {
+        n.name = c->f_identifier;
+        operands = c->call_args;
+    }
+    else if (auto c = as_resolved_conditional(e)) {
+        operands = {c->condition, c->value_true, c->value_false};
+    }
+    else if (auto f = as_resolved_field_access(e)) {
+        n.name = f->field;
+        operands = {f->object};
+    }
+    else {
+        return {};
+    }
+
+    for (const auto& o: operands) {
+        auto o_id = intern(o);
+        if (!o_id) return {};
+        n.operands.push_back(o_id.value());
+    }
+
+    hash_combine(n.hash, n.kind);
+    hash_combine(n.hash, n.op);
+    hash_combine(n.hash, n.value);
+    hash_combine(n.hash, n.name);
+    hash_combine(n.hash, *n.type);
+    for (auto o: n.operands) {
+        hash_combine(n.hash, o);
+    }
+
+    id next = nodes_.size();
+    return nodes_.insert({std::move(n), next}).first->second;
+}
+
+} // namespace resolved_ir
+} // namespace al
@@ -0,0 +1,125 @@
+#include <string>
+
+#include <fmt/core.h>
+
+#include <arblang/util/op_count.hpp>
+
+namespace al {
+namespace resolved_ir {
+
+op_count& op_count::operator+=(const op_count& other) {
+    add += other.add;
+    mul += other.mul;
+    div += other.div;
+    fn  += other.fn;
+    cmp += other.cmp;
+    return *this;
+}
+
+void count_ops(const r_expr&, op_count&);
+
+void count_ops(const resolved_parameter& e, op_count& c) {
+    count_ops(e.value, c);
+}
+
+void count_ops(const resolved_constant& e, op_count& c) {
+    count_ops(e.value, c);
+}
+
+void count_ops(const resolved_initial& e, op_count& c) {
+    count_ops(e.value, c);
+}
+
+void count_ops(const resolved_on_event& e, op_count& c) {
+    count_ops(e.value, c);
+}
+
+void count_ops(const resolved_evolve& e, op_count& c) {
+    count_ops(e.value, c);
+}
+
+void count_ops(const resolved_effect& e, op_count& c) {
+    count_ops(e.value, c);
+}
+
+void count_ops(const resolved_call& e, op_count& c) {
+    for (const auto& a: e.call_args) {
+        count_ops(a, c);
+    }
+}
+
+void count_ops(const resolved_object& e, op_count& c) {
+    for (const auto& a: e.field_values()) {
+        count_ops(a, c);
+    }
+}
+
+void count_ops(const resolved_let& e, op_count& c) {
+    count_ops(e.id_value(), c);
+    count_ops(e.body, c);
+}
+
+void count_ops(const resolved_conditional& e, op_count& c) {
+    count_ops(e.condition, c);
+    count_ops(e.value_true, c);
+    count_ops(e.value_false, c);
+}
+
+void count_ops(const resolved_unary& e, op_count& c) {
+    switch (e.op) {
+        case unary_op::neg:
+        case unary_op::abs:  c.add++; break;
+        case unary_op::lnot: c.cmp++; break;
+        default:             c.fn++;  break;
+    }
+    count_ops(e.arg, c);
+}
+
+void count_ops(const resolved_binary& e, op_count& c) {
+    switch (e.op) {
+        case binary_op::add:
+        case binary_op::sub:
+        case binary_op::min:
+        case binary_op::max: c.add++; break;
+        case binary_op::mul: c.mul++; break;
+        case binary_op::div: c.div++; break;
+        case binary_op::pow: c.fn++;  break;
+        default:             c.cmp++; break;
+    }
+    count_ops(e.lhs, c);
+    count_ops(e.rhs, c);
+}
+
+void count_ops(const resolved_field_access& e, op_count& c) {
+    count_ops(e.object, c);
+}
+
+// Variables refer to let-bound values, which are counted at their definition.
+void count_ops(const resolved_variable& e, op_count& c) {}
+
+void count_ops(const resolved_argument& e, op_count& c) {}
+void count_ops(const resolved_float& e, op_count& c) {}
+void count_ops(const resolved_int& e, op_count& c) {}
+
+void count_ops(const resolved_function& e, op_count& c) {}
+void count_ops(const resolved_state& e, op_count& c) {}
+void count_ops(const resolved_record_alias& e, op_count& c) {}
+void count_ops(const resolved_bind& e, op_count& c) {}
+void count_ops(const resolved_export& e, op_count& c) {}
+
+void count_ops(const r_expr& e, op_count& c) {
+    std::visit([&](auto&& n){count_ops(n, c);}, *e);
+}
+
+op_count count_ops(const r_expr& e) {
+    op_count c;
+    count_ops(e, c);
+    return c;
+}
+
+std::string to_string(const op_count& c) {
+    return fmt::format("{} add, {} mul, {} div, {} fn, {} cmp", c.add, c.mul, c.div, c.fn, c.cmp);
+}
+
+} // namespace resolved_ir
+} // namespace al
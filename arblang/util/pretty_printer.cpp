@@ -31,6 +31,10 @@ std::string pretty_print(const resolved_mechanism& e) {
     for (const auto& p: e.on_events) {
         str += pretty_print(p) + "\n";
     }
+    for (const auto& p: e.post_events) {
+        // Post events share the representation of on_events.
+        str += "on_post" + pretty_print(p).substr(std::string("on_event").size()) + "\n";
+    }
     for (const auto& p: e.evolutions) {
         str += pretty_print(p) + "\n";
     }
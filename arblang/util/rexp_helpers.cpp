@@ -2,8 +2,8 @@
 
 namespace al {
 namespace resolved_ir {
-r_expr get_innermost_body(resolved_let* const let) {
-    resolved_let* let_last = let;
+r_expr get_innermost_body(const resolved_let* const let) {
+    const resolved_let* let_last = let;
     while (auto let_next = std::get_if<resolved_let>(let_last->body.get())) {
         let_last = let_next;
     }
@@ -22,10 +22,10 @@ void set_innermost_body(resolved_let* const let, const r_expr& body) {
 }
 
 std::optional<double> is_number(const r_expr& e) {
-    if (auto v = is_resolved_float(e)) {
+    if (auto v = as_resolved_float(e)) {
         return v->value;
     }
-    if (auto v = is_resolved_int(e)) {
+    if (auto v = as_resolved_int(e)) {
         return v->value;
     }
     return {};
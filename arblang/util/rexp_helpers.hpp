@@ -4,7 +4,7 @@
 
 namespace al {
 namespace resolved_ir {
-r_expr get_innermost_body(resolved_let* let);
+r_expr get_innermost_body(const resolved_let* let);
 void set_innermost_body(resolved_let* let, const r_expr& body);
 
 std::optional<double> is_number(const r_expr& e);
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+#include <arblang/resolver/resolved_types.hpp>
+
+// Compares the cost of walking a let-chain with the copying is_resolved_* accessors
+// and with the pointer-returning as_resolved_* accessors.
+// The chain binds objects, as in the canonicalized `evolve` and `effect` blocks:
+//   let _ll0_ = {f0 = 0.0; f1 = 1.0; ...}; let _ll1_ = {...}; ...; 0.0
+
+static std::size_t heap_allocations = 0;
+
+void* operator new(std::size_t n) {
+    heap_allocations++;
+    if (auto p = std::malloc(n? n: 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+using namespace al::resolved_ir;
+
+r_expr make_chain(unsigned n_lets, unsigned n_fields) {
+    auto loc = al::src_location{};
+    auto real = make_rtype<resolved_quantity>(quantity::real, loc);
+
+    r_expr chain = make_rexpr<resolved_float>(0., real, loc);
+    for (unsigned i = n_lets; i-- > 0;) {
+        std::vector<std::string> names;
+        std::vector<r_expr> values;
+        for (unsigned j = 0; j < n_fields; ++j) {
+            names.push_back("f" + std::to_string(j));
+            values.push_back(make_rexpr<resolved_float>(double(j), real, loc));
+        }
+        auto obj = make_rexpr<resolved_object>(names, values, real, loc);
+        chain = make_rexpr<resolved_let>("_ll" + std::to_string(i) + "_", obj, chain, real, loc);
+    }
+    return chain;
+}
+
+// Each accessor copies the node: `shared_copies` counts the shared_ptrs copied
+// with it, i.e. the pairs of atomic reference count updates.
+double walk_copy(const r_expr& e, std::size_t& shared_copies) {
+    double sum = 0;
+    r_expr cur = e;
+    while (auto let = is_resolved_let(cur)) {
+        shared_copies += 3;
+        auto var = is_resolved_variable(let->identifier);
+        shared_copies += 2;
+        if (auto obj = is_resolved_object(var->value)) {
+            shared_copies += obj->record_fields.size() + 1;
+            for (const auto& f: obj->record_fields) {
+                auto field = is_resolved_variable(f);
+                shared_copies += 2;
+                if (auto x = is_resolved_float(field->value)) {
+                    shared_copies += 1;
+                    sum += x->value;
+                }
+            }
+        }
+        cur = let->body;
+        shared_copies += 1;
+    }
+    return sum;
+}
+
+double walk_ptr(const r_expr& e) {
+    double sum = 0;
+    const r_expr* cur = &e;
+    while (auto let = as_resolved_let(*cur)) {
+        auto var = as_resolved_variable(let->identifier);
+        if (auto obj = as_resolved_object(var->value)) {
+            for (const auto& f: obj->record_fields) {
+                auto field = as_resolved_variable(f);
+                if (auto x = as_resolved_float(field->value)) {
+                    sum += x->value;
+                }
+            }
+        }
+        cur = &let->body;
+    }
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    unsigned n_lets   = argc > 1? std::stoul(argv[1]): 1000;
+    unsigned n_fields = argc > 2? std::stoul(argv[2]): 8;
+    unsigned n_reps   = argc > 3? std::stoul(argv[3]): 1000;
+
+    auto chain = make_chain(n_lets, n_fields);
+
+    auto run = [&](const char* name, auto&& walk) {
+        std::size_t shared_copies = 0;
+        double sum = 0;
+        auto allocs = heap_allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < n_reps; ++i) {
+            sum += walk(shared_copies);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        allocs = heap_allocations - allocs;
+
+        auto ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        std::cout << name << ": " << ms/n_reps << " ms/walk, "
+                  << double(allocs)/n_reps << " heap allocations/walk, "
+                  << double(shared_copies)/n_reps << " shared_ptr copies/walk"
+                  << " (checksum " << sum << ")\n";
+    };
+
+    std::cout << n_lets << " lets of " << n_fields << " fields, " << n_reps << " walks\n";
+    run("is_resolved_*", [&](std::size_t& c) { return walk_copy(chain, c); });
+    run("as_resolved_*", [&](std::size_t&)   { return walk_ptr(chain); });
+}
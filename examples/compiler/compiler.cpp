@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -6,6 +7,7 @@
 
 #include <arblang/optimizer/optimizer.hpp>
 #include <arblang/optimizer/inline_func.hpp>
+#include <arblang/optimizer/tabulate.hpp>
 #include <arblang/parser/parser.hpp>
 #include <arblang/parser/normalizer.hpp>
 #include <arblang/pre_printer/printable_mechanism.hpp>
@@ -15,11 +17,27 @@
 #include <arblang/resolver/resolve.hpp>
 #include <arblang/resolver/single_assign.hpp>
 #include <arblang/solver/solve.hpp>
+#include <arblang/util/arena.hpp>
+#include <arblang/util/op_count.hpp>
 
 const char* usage_str =
         "\n"
         "-o|--output            [Prefix for output file names]\n"
         "-N|--namespace         [Namespace for generated code]\n"
+        "--simd                 [Generate explicitly vectorized kernels]\n"
+        "--vectorize-hints      [Annotate scalar kernels for auto-vectorization]\n"
+        "--prefetch             [Prefetch distance of node-indexed data in scalar loops (default 0: none)]\n"
+        "--segmented-writes     [Sum the contributions of point mechanism instances per node before writing them]\n"
+        "--fast-math            [Use inline approximations of exp, log and exprelr in scalar kernels]\n"
+        "--uniform              [Parameter or binding with the same value for all instances]\n"
+        "--global               [Parameter stored once per mechanism rather than per instance]\n"
+        "--ode-scheme           [ODE scheme, for all states or as state[.field]=scheme:\n"
+        "                        cnexp, pade11 (default), pade22, euler, backward-euler]\n"
+        "--newton-iterations    [Newton iterations for non-linear ODEs (default 3)]\n"
+        "--table                [Tabulate a function of one argument as function=lo:hi:intervals,\n"
+        "                        with the range of the argument in SI units]\n"
+        "--alloc-stats          [Report the IR nodes and bytes allocated by each pass]\n"
+        "--op-stats             [Report the operations of the state updates, per instance and time step]\n"
         "<filename>             [File to be compiled]\n";
 
 int main(int argc, char **argv) {
@@ -28,6 +46,12 @@ int main(int argc, char **argv) {
     using namespace to;
 
     std::string opt_namespace, opt_input, opt_output;
+    std::vector<std::string> opt_uniform, opt_global, opt_scheme, opt_table;
+    std::unordered_map<std::string, table_spec> table_specs;
+    solver_options opt_solver;
+    printer_options opt_printer;
+    bool opt_alloc_stats = false;
+    bool opt_op_stats = false;
     try {
         std::vector<std::string> targets;
 
@@ -39,9 +63,45 @@ int main(int argc, char **argv) {
                 { opt_input,  to::mandatory},
                 { opt_output, "-o", "--output" },
                 { opt_namespace, "-N", "--namespace" },
+                { to::set(opt_printer.simd), to::flag, "--simd" },
+                { to::set(opt_printer.vectorize_hints), to::flag, "--vectorize-hints" },
+                { opt_printer.prefetch_distance, "--prefetch" },
+                { to::set(opt_printer.segmented_writes), to::flag, "--segmented-writes" },
+                { to::set(opt_printer.fast_math), to::flag, "--fast-math" },
+                { to::push_back(opt_uniform), "--uniform" },
+                { to::push_back(opt_global), "--global" },
+                { to::push_back(opt_scheme), "--ode-scheme" },
+                { opt_solver.newton_iterations, "--newton-iterations" },
+                { to::push_back(opt_table), "--table" },
+                { to::set(opt_alloc_stats), to::flag, "--alloc-stats" },
+                { to::set(opt_op_stats), to::flag, "--op-stats" },
         };
 
         if (!to::run(options, argc, argv+1)) return 0;
+
+        for (const auto& s: opt_scheme) {
+            auto eq = s.find('=');
+            auto scheme = parse_ode_scheme(eq == std::string::npos? s: s.substr(eq+1));
+            if (!scheme) {
+                throw to::option_error("unknown ODE scheme", s);
+            }
+            if (eq == std::string::npos) {
+                opt_solver.scheme = scheme.value();
+            }
+            else {
+                opt_solver.state_schemes[s.substr(0, eq)] = scheme.value();
+            }
+        }
+        for (const auto& s: opt_table) {
+            auto eq = s.find('=');
+            table_spec spec;
+            char trailing;
+            if (eq == std::string::npos ||
+                std::sscanf(s.c_str() + eq + 1, "%lf:%lf:%u%c", &spec.lo, &spec.hi, &spec.intervals, &trailing) != 3) {
+                throw to::option_error("expected function=lo:hi:intervals", s);
+            }
+            table_specs[s.substr(0, eq)] = spec;
+        }
     }
     catch (to::option_error& e) {
         to::usage_error(argv[0], usage_str, e.what());
@@ -60,25 +120,39 @@ int main(int argc, char **argv) {
         throw std::runtime_error("Failure opening " + opt_input);
     }
 
+    // Report the allocations of each pass.
+    allocation_counter pass_allocations;
+    auto report_allocations = [&](const char* pass) {
+        if (opt_alloc_stats) std::cout << pass << ": " << to_string(pass_allocations.count()) << "\n";
+        pass_allocations.reset();
+    };
+
     // Parse the mechanism.
     // Produces `parsed_expressions`.
     auto p = parser(mech);
     auto m_parsed = p.parse_mechanism();
+    report_allocations("parse");
     // Normalize any units used: 1 mV -> 0.001 V.
     // Units can only appear after integer or float expressions.
     // Produces `parsed_expressions`.
     auto m_normal = normalize(m_parsed);
+    report_allocations("normalize");
 
     // Resolve the mechanism.
     // Produces `resolved_expressions`, the main IR.
     // Performs type checking and name resolution.
     auto m_resolved = resolve(m_normal);
+    report_allocations("resolve");
+
+    // Check that the states given integration schemes exist.
+    check_solver_options(m_resolved, opt_solver);
 
     // Canonicalize the mechanism.
     // Required before we can perform start optimization.
     // Ensures that the rhs of an assignment `=` is a single, un-nested, expression.
     // Produces `resolved_expressions`.
     auto m_canon = canonicalize(m_resolved);
+    report_allocations("canonicalize");
 
     // Make sure that all variables are assigned only once.
     // There is no restriction on the user code to bind the same variable twice
@@ -88,6 +162,7 @@ int main(int argc, char **argv) {
     //   binding on variables this can be removed.
     // Produces `resolved_expressions`.
     auto m_ssa = single_assign(m_canon);
+    report_allocations("single_assign");
 
     // Optimize the mechanism.
     // Performs CSE, constant folding, copy propagation and dead-code elimination
@@ -95,31 +170,71 @@ int main(int argc, char **argv) {
     // Produces `resolved_expressions`.
     auto opt_0 = optimizer(m_ssa);
     auto m_opt = opt_0.optimize();
+    report_allocations("optimize");
+
+    // Collect the tabulated functions.
+    // Their calls are kept during inlining, and printed as
+    //   lookups in tables filled when the mechanism is loaded.
+    auto tables = tabulate(m_opt, table_specs);
+    std::unordered_set<std::string> tabulated;
+    for (const auto& t: tables) {
+        tabulated.insert(t.name);
+    }
+    report_allocations("tabulate");
 
     // Inline functions.
     // Produces `resolved_expressions`.
-    auto m_inlined = inline_func(m_opt);
+    auto m_inlined = inline_func(m_opt, tabulated);
+    report_allocations("inline_func");
 
     // Reoptimize after inlining.
     // Produces `resolved_expressions`.
     auto opt_1 = optimizer(m_inlined);
     auto m_fin = opt_1.optimize();
+    report_allocations("optimize");
 
     // Solve the mechanism.
     // Entails solving any ODEs and finding the conductance.
-    // Only simple diagonal systems of ODEs are supported.
+    // Only linear systems of ODEs are supported; coupled
+    //   systems are solved implicitly.
     // Requires a prefix for the current and conductance
     //   variables that will also be used during the printing
     //   stage.
+    // The integration scheme can be chosen per state.
     // Produces `resolved_expressions`.
     std::string i_name = "i";
     std::string g_name = "g";
-    m_fin = solve(m_fin, i_name, g_name);
+    m_fin = solve(m_fin, i_name, g_name, opt_solver);
+    report_allocations("solve");
+
+    // Report the cost of the state updates, per instance and time step.
+    for (const auto& c: m_fin.evolutions) {
+        if (!opt_op_stats) break;
+        auto evolve = is_resolved_evolve(c).value();
+        auto state = is_resolved_argument(evolve.identifier)->name;
+        std::string schemes = to_string(opt_solver.scheme_of(state));
+        if (auto rec = is_resolved_record_type(evolve.type)) {
+            schemes.clear();
+            for (const auto& [field, type]: rec->fields) {
+                schemes += (schemes.empty()? "": ", ") + field + ": " + to_string(opt_solver.scheme_of(state, field));
+            }
+        }
+        std::cout << "evolve " << state << " [" << schemes << "]: " << to_string(count_ops(evolve.value)) << "\n";
+    }
+
+    pass_allocations.reset();
 
     // Prepare the mechanism for printing.
     // Gathers information about which variables are read/written
     //   in each kernel and their kinds.
-    auto m_printable = printable_mechanism(m_fin, i_name, g_name);
+    // Hoists values that only depend on uniform parameters and
+    //   bindings out of the per-instance loops.
+    // Global parameters are uniform, and are stored once per
+    //   mechanism rather than once per instance.
+    std::unordered_set<std::string> uniform(opt_uniform.begin(), opt_uniform.end());
+    std::unordered_set<std::string> global(opt_global.begin(), opt_global.end());
+    auto m_printable = printable_mechanism(m_fin, i_name, g_name, uniform, global, tables);
+    report_allocations("printable_mechanism");
 
     // Print the mechanism.
     // Generate C++ code written against arbor's mechanism ABI.
@@ -129,6 +244,7 @@ int main(int argc, char **argv) {
     fo_hpp.close();
 
     fo_cpp.open(opt_output+"_cpu.cpp");
-    fo_cpp << print_mechanism(m_printable, opt_namespace).str();
+    fo_cpp << print_mechanism(m_printable, opt_namespace, opt_printer).str();
     fo_cpp.close();
+    report_allocations("print");
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+mechanism point "expsyn_stdp" {
+    # parameters
+    parameter tau      = 2.0  [ms];
+    parameter taupre   = 10   [ms];
+    parameter taupost  = 10   [ms];
+    parameter Apre     = 0.01 [uS];
+    parameter Apost    = -0.01 [uS];
+    parameter e        = 0    [mV];
+    parameter max_weight = 10 [nS];
+
+    # states
+    record state_rec {
+        g: conductance,
+        apre: conductance,
+        apost: conductance,
+        weight_plastic: conductance,
+    };
+    state s: state_rec;
+
+    # bindings
+    bind v = membrane_potential;
+
+    # initial
+    initial s = state_rec { g = 0 [uS]; apre = 0 [uS]; apost = 0 [uS]; weight_plastic = 0 [uS]; };
+
+    # effects
+    effect current = s.g*(v-e);
+
+    # evolutions
+    evolve s' = state_rec' {
+        g' = -s.g/tau;
+        apre' = -s.apre/taupre;
+        apost' = -s.apost/taupost;
+        weight_plastic' = 0 [uS/ms];
+    };
+
+    # events from the pre-synaptic cell
+    on_event(w: conductance) s = state_rec {
+        g = max(0 [uS], min(s.g + w + s.weight_plastic, max_weight));
+        apre = s.apre + Apre;
+        apost = s.apost;
+        weight_plastic = s.weight_plastic + s.apost;
+    };
+
+    # spikes of the post-synaptic cell
+    on_post(t: time) s = state_rec {
+        g = s.g;
+        apre = s.apre;
+        apost = s.apost + Apost;
+        weight_plastic = s.weight_plastic + s.apre;
+    };
+
+    # parameter exports
+    export tau;
+    export taupre;
+    export taupost;
+    export Apre;
+    export Apost;
+    export e;
+    export max_weight;
+}
@@ -0,0 +1,42 @@
+mechanism density "markov" {
+    # parameters
+    parameter gbar = 0.01 [S/cm^2];
+    parameter ek   = -77  [mV];
+
+    # bindings
+    bind v = membrane_potential;
+
+    # state: closed, open and inactivated occupancies of a three-state kinetic scheme
+    record state_rec {
+        c: real,
+        o: real,
+        i: real,
+    };
+    state s: state_rec;
+
+    # rates
+    function alpha(v: voltage): real {
+        0.5*exp((v + 40 [mV])/20 [mV]);
+    };
+    function beta(v: voltage): real {
+        0.2*exp(-(v + 40 [mV])/25 [mV]);
+    };
+
+    # kinetic scheme: c <-> o <-> i
+    function rate(s: state_rec, v: voltage): state_rec' {
+        let c = s.c;
+        let o = s.o;
+        let i = s.i;
+        state_rec'{
+            c <-> o (alpha(v)/1 [ms], beta(v)/1 [ms]);
+            o <-> i (0.1/1 [ms], 0.02/1 [ms]);
+        };
+    }
+
+    initial s = state_rec { c = 1; o = 0; i = 0; };
+    evolve s' = rate(s, v);
+    effect current_density("k") = gbar*s.o*(v - ek);
+
+    export gbar;
+    export ek;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// The functions of arbor's arbor/math.hpp used by the generated code.
+
+#include <cmath>
+#include <limits>
+
+namespace arb {
+namespace math {
+
+// x/(exp(x)-1), 1 at x = 0.
+template <typename T>
+inline T exprelr(T x) {
+    if (T(1) + x == T(1)) return T(1);
+    return x/std::expm1(x);
+}
+
+// 1/x, with 1/0 replaced by a large value.
+template <typename T>
+inline T safeinv(T x) {
+    if (T(1) + x == T(1)) x = std::numeric_limits<T>::epsilon();
+    return T(1)/x;
+}
+
+} // namespace math
+} // namespace arb
@@ -0,0 +1,138 @@
+#pragma once
+
+// The subset of arbor's mechanism ABI (arbor/mechanism_abi.h) that the
+// generated code is written against, so that it can be compiled and run
+// without an arbor installation.
+
+#include <cstddef>
+#include <cstdint>
+
+#define ARB_MECH_ABI_VERSION_MAJOR 0
+#define ARB_MECH_ABI_VERSION_MINOR 1
+#define ARB_MECH_ABI_VERSION_PATCH 0
+#define ARB_MECH_ABI_VERSION ((ARB_MECH_ABI_VERSION_MAJOR*10000L*10000L) + (ARB_MECH_ABI_VERSION_MINOR*10000L) + ARB_MECH_ABI_VERSION_PATCH)
+
+typedef double   arb_value_type;
+typedef float    arb_weight_type;
+typedef int      arb_index_type;
+typedef uint32_t arb_size_type;
+
+typedef uint32_t arb_mechanism_kind;
+#define arb_mechanism_kind_nil 0
+#define arb_mechanism_kind_point 1
+#define arb_mechanism_kind_density 2
+#define arb_mechanism_kind_reversal_potential 3
+#define arb_mechanism_kind_gap_junction 4
+
+typedef uint32_t arb_backend_kind;
+#define arb_backend_kind_nil 0
+#define arb_backend_kind_cpu 1
+#define arb_backend_kind_gpu 2
+
+// Events of all cells, each cell's events delimited by `begin` and `end`.
+typedef struct arb_deliverable_event_data {
+    arb_size_type   mech_id;
+    arb_size_type   mech_index;
+    arb_weight_type weight;
+} arb_deliverable_event_data;
+
+typedef struct arb_deliverable_event_stream {
+    arb_size_type                     n_streams;
+    const arb_deliverable_event_data* events;
+    const arb_index_type*             begin;
+    const arb_index_type*             end;
+} arb_deliverable_event_stream;
+
+typedef struct arb_constraint_partition {
+    arb_size_type   n_contiguous;
+    arb_size_type   n_constant;
+    arb_size_type   n_independent;
+    arb_size_type   n_none;
+    arb_index_type* contiguous;
+    arb_index_type* constant;
+    arb_index_type* independent;
+    arb_index_type* none;
+} arb_constraint_partition;
+
+typedef struct arb_ion_state {
+    arb_value_type* current_density;
+    arb_value_type* reversal_potential;
+    arb_value_type* internal_concentration;
+    arb_value_type* external_concentration;
+    arb_value_type* ionic_charge;
+    arb_index_type* index;
+} arb_ion_state;
+
+typedef struct arb_mechanism_ppack {
+    arb_size_type   width;
+    arb_size_type   n_detectors;
+    arb_index_type* vec_ci;
+    arb_value_type* vec_dt;
+    arb_value_type* vec_v;
+    arb_value_type* vec_i;
+    arb_value_type* vec_g;
+    arb_value_type* temperature_degC;
+    arb_value_type* diam_um;
+    arb_value_type* time_since_spike;
+    arb_index_type* node_index;
+    arb_index_type* multiplicity;
+    arb_value_type* weight;
+    arb_size_type   mechanism_id;
+    arb_value_type** parameters;
+    arb_value_type** state_vars;
+    arb_value_type*  globals;
+    arb_ion_state*   ion_states;
+    arb_constraint_partition index_constraints;
+} arb_mechanism_ppack;
+
+typedef void (*arb_mechanism_method)(arb_mechanism_ppack*);
+typedef void (*arb_mechanism_method_events)(arb_mechanism_ppack*, arb_deliverable_event_stream*);
+
+typedef struct arb_mechanism_interface {
+    arb_backend_kind backend;
+    arb_size_type partition_width;
+    arb_size_type alignment;
+    arb_mechanism_method init_mechanism;
+    arb_mechanism_method compute_currents;
+    arb_mechanism_method_events apply_events;
+    arb_mechanism_method advance_state;
+    arb_mechanism_method write_ions;
+    arb_mechanism_method post_event;
+} arb_mechanism_interface;
+
+typedef struct arb_field_info {
+    const char* name;
+    const char* unit;
+    arb_value_type default_value;
+    arb_value_type range_low;
+    arb_value_type range_high;
+} arb_field_info;
+
+typedef struct arb_ion_info {
+    const char* name;
+    bool write_int_concentration;
+    bool write_ext_concentration;
+    bool use_diff_concentration;
+    bool write_rev_potential;
+    bool read_rev_potential;
+    bool read_valence;
+    bool verify_valence;
+    int  expected_valence;
+} arb_ion_info;
+
+typedef struct arb_mechanism_type {
+    unsigned long abi_version;
+    const char* fingerprint;
+    const char* name;
+    arb_mechanism_kind kind;
+    bool is_linear;
+    bool has_post_events;
+    arb_field_info* globals;
+    arb_size_type   n_globals;
+    arb_field_info* state_vars;
+    arb_size_type   n_state_vars;
+    arb_field_info* parameters;
+    arb_size_type   n_parameters;
+    arb_ion_info*   ions;
+    arb_size_type   n_ions;
+} arb_mechanism_type;
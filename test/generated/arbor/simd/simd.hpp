@@ -0,0 +1,210 @@
+#pragma once
+
+// The subset of arbor's SIMD library (arbor/simd/simd.hpp) that the generated
+// SIMD kernels are written against, emulated lane by lane, so that they can be
+// compiled and run without an arbor installation. The lanes of a batch are
+// processed in order, as arbor's fallback implementation does.
+
+#include <cmath>
+
+#include <arbor/math.hpp>
+
+namespace arb {
+namespace simd {
+
+enum class index_constraint {
+    none = 0,
+    independent,
+    contiguous,
+    constant
+};
+
+namespace simd_abi {
+
+// Narrower than most native widths, but wide enough for batches to mix
+// node indices.
+template <typename T>
+struct native_width {
+    static constexpr unsigned value = 4;
+};
+
+template <typename T, unsigned N>
+struct default_abi {};
+
+} // namespace simd_abi
+
+template <typename T, unsigned N, template <typename, unsigned> class Abi>
+struct simd_mask {
+    bool m[N];
+
+    simd_mask() = default;
+    simd_mask(bool b) {
+        for (unsigned k = 0; k < N; ++k) m[k] = b;
+    }
+
+    friend simd_mask operator&&(const simd_mask& a, const simd_mask& b) {
+        simd_mask r;
+        for (unsigned k = 0; k < N; ++k) r.m[k] = a.m[k] && b.m[k];
+        return r;
+    }
+    friend simd_mask operator||(const simd_mask& a, const simd_mask& b) {
+        simd_mask r;
+        for (unsigned k = 0; k < N; ++k) r.m[k] = a.m[k] || b.m[k];
+        return r;
+    }
+    friend simd_mask operator!(const simd_mask& a) {
+        simd_mask r;
+        for (unsigned k = 0; k < N; ++k) r.m[k] = !a.m[k];
+        return r;
+    }
+};
+
+template <typename T, unsigned N, template <typename, unsigned> class Abi>
+struct simd {
+    using mask = simd_mask<T, N, Abi>;
+    static constexpr unsigned width = N;
+    T v[N];
+
+    simd() = default;
+    simd(T x) {
+        for (unsigned k = 0; k < N; ++k) v[k] = x;
+    }
+
+    template <typename F>
+    static simd map(const simd& a, const simd& b, F f) {
+        simd r;
+        for (unsigned k = 0; k < N; ++k) r.v[k] = f(a.v[k], b.v[k]);
+        return r;
+    }
+    template <typename F>
+    static mask compare(const simd& a, const simd& b, F f) {
+        mask r;
+        for (unsigned k = 0; k < N; ++k) r.m[k] = f(a.v[k], b.v[k]);
+        return r;
+    }
+
+    friend simd operator+(const simd& a, const simd& b) { return map(a, b, [](T x, T y) {return x+y;}); }
+    friend simd operator-(const simd& a, const simd& b) { return map(a, b, [](T x, T y) {return x-y;}); }
+    friend simd operator*(const simd& a, const simd& b) { return map(a, b, [](T x, T y) {return x*y;}); }
+    friend simd operator/(const simd& a, const simd& b) { return map(a, b, [](T x, T y) {return x/y;}); }
+    friend simd operator-(const simd& a) { return map(a, a, [](T x, T) {return -x;}); }
+
+    friend mask operator==(const simd& a, const simd& b) { return compare(a, b, [](T x, T y) {return x==y;}); }
+    friend mask operator!=(const simd& a, const simd& b) { return compare(a, b, [](T x, T y) {return x!=y;}); }
+    friend mask operator<(const simd& a, const simd& b)  { return compare(a, b, [](T x, T y) {return x<y;}); }
+    friend mask operator<=(const simd& a, const simd& b) { return compare(a, b, [](T x, T y) {return x<=y;}); }
+    friend mask operator>(const simd& a, const simd& b)  { return compare(a, b, [](T x, T y) {return x>y;}); }
+    friend mask operator>=(const simd& a, const simd& b) { return compare(a, b, [](T x, T y) {return x>=y;}); }
+};
+
+// Contiguous memory at `p`, or the memory at `p` indexed by `index`.
+template <typename P>
+struct indirect_expression {
+    P p;
+    unsigned width;
+
+    template <typename T, unsigned N, template <typename, unsigned> class Abi>
+    indirect_expression& operator=(const simd<T, N, Abi>& s) {
+        for (unsigned k = 0; k < N; ++k) p[k] = s.v[k];
+        return *this;
+    }
+    template <typename T, unsigned N, template <typename, unsigned> class Abi>
+    indirect_expression& operator+=(const simd<T, N, Abi>& s) {
+        for (unsigned k = 0; k < N; ++k) p[k] += s.v[k];
+        return *this;
+    }
+};
+
+template <typename P, typename I, unsigned N, template <typename, unsigned> class Abi>
+struct indirect_indirect_expression {
+    P p;
+    simd<I, N, Abi> index;
+    index_constraint constraint;
+
+    template <typename T>
+    indirect_indirect_expression& operator=(const simd<T, N, Abi>& s) {
+        for (unsigned k = 0; k < N; ++k) p[index.v[k]] = s.v[k];
+        return *this;
+    }
+    // Lanes with the same index are accumulated in order.
+    template <typename T>
+    indirect_indirect_expression& operator+=(const simd<T, N, Abi>& s) {
+        for (unsigned k = 0; k < N; ++k) p[index.v[k]] += s.v[k];
+        return *this;
+    }
+};
+
+template <typename T>
+indirect_expression<T*> indirect(T* p, unsigned width) {
+    return {p, width};
+}
+
+template <typename T, typename I, unsigned N, template <typename, unsigned> class Abi>
+indirect_indirect_expression<T*, I, N, Abi> indirect(T* p, const simd<I, N, Abi>& index, unsigned width,
+                                                     index_constraint constraint = index_constraint::none) {
+    return {p, index, constraint};
+}
+
+template <typename T, unsigned N, template <typename, unsigned> class Abi, typename P>
+void assign(simd<T, N, Abi>& s, const indirect_expression<P>& e) {
+    for (unsigned k = 0; k < N; ++k) s.v[k] = e.p[k];
+}
+
+template <typename T, unsigned N, template <typename, unsigned> class Abi, typename P, typename I>
+void assign(simd<T, N, Abi>& s, const indirect_indirect_expression<P, I, N, Abi>& e) {
+    for (unsigned k = 0; k < N; ++k) s.v[k] = e.p[e.index.v[k]];
+}
+
+// Assignment to the lanes of `s` selected by `m`.
+template <typename T, unsigned N, template <typename, unsigned> class Abi>
+struct where_expression {
+    simd_mask<T, N, Abi> m;
+    simd<T, N, Abi>& s;
+
+    where_expression& operator=(const simd<T, N, Abi>& x) {
+        for (unsigned k = 0; k < N; ++k) {
+            if (m.m[k]) s.v[k] = x.v[k];
+        }
+        return *this;
+    }
+};
+
+template <typename T, unsigned N, template <typename, unsigned> class Abi>
+where_expression<T, N, Abi> where(const simd_mask<T, N, Abi>& m, simd<T, N, Abi>& s) {
+    return {m, s};
+}
+
+template <typename T, unsigned N, template <typename, unsigned> class Abi>
+T reduce(const simd<T, N, Abi>& s) {
+    T r = 0;
+    for (unsigned k = 0; k < N; ++k) r += s.v[k];
+    return r;
+}
+
+#define ARB_SIMD_UNARY_(name, f) \
+template <typename T, unsigned N, template <typename, unsigned> class Abi> \
+simd<T, N, Abi> name(const simd<T, N, Abi>& a) { \
+    return simd<T, N, Abi>::map(a, a, [](T x, T) {return f(x);}); \
+}
+#define ARB_SIMD_BINARY_(name, f) \
+template <typename T, unsigned N, template <typename, unsigned> class Abi> \
+simd<T, N, Abi> name(const simd<T, N, Abi>& a, const simd<T, N, Abi>& b) { \
+    return simd<T, N, Abi>::map(a, b, [](T x, T y) {return f(x, y);}); \
+}
+
+ARB_SIMD_UNARY_(exp, std::exp)
+ARB_SIMD_UNARY_(log, std::log)
+ARB_SIMD_UNARY_(abs, std::abs)
+ARB_SIMD_UNARY_(sin, std::sin)
+ARB_SIMD_UNARY_(cos, std::cos)
+ARB_SIMD_UNARY_(exprelr, ::arb::math::exprelr)
+ARB_SIMD_UNARY_(safeinv, ::arb::math::safeinv)
+ARB_SIMD_BINARY_(pow, std::pow)
+ARB_SIMD_BINARY_(min, std::fmin)
+ARB_SIMD_BINARY_(max, std::fmax)
+
+#undef ARB_SIMD_UNARY_
+#undef ARB_SIMD_BINARY_
+
+} // namespace simd
+} // namespace arb
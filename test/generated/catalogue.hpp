@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <arbor/mechanism_abi.h>
+
+// The mechanisms generated from the examples of the compiler, listed in the
+// catalogue source written by CMake.
+struct catalogue_entry {
+    std::string name;
+    arb_mechanism_type (*type)();
+    arb_mechanism_interface* (*interface)();
+};
+
+extern const std::vector<catalogue_entry> catalogue;
+
+const catalogue_entry& find_mechanism(const std::string& name);
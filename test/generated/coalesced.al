@@ -0,0 +1,30 @@
+mechanism point "coalesced" {
+    # parameters
+    parameter tau = 2     [ms];
+    parameter g0  = 0.5   [uS];
+    parameter e   = 0     [mV];
+
+    # states
+    state g: conductance;
+
+    # bindings
+    bind v = membrane_potential;
+
+    # initializations
+    # (non-zero: the state of a coalesced instance is scaled by its multiplicity)
+    initial g = g0;
+
+    # effects
+    effect current = g*(v-e);
+
+    # evolutions
+    evolve g' = -g/tau;
+
+    # events
+    on_event(w:conductance) g = g + w;
+
+    # parameter exports
+    export tau;
+    export g0;
+    export e;
+}
@@ -0,0 +1,25 @@
+mechanism density "fast_math" {
+    # parameters
+    parameter x = 0;
+    parameter y = 1;
+
+    # states
+    state exp_x: real;
+    state log_y: real;
+    state exprelr_x: real;
+
+    # initializations
+    # (the approximations are evaluated by init, the states don't evolve in the tests)
+    initial exp_x = exp(x);
+    initial log_y = log(y);
+    initial exprelr_x = exprelr(x);
+
+    # evolutions
+    evolve exp_x' = -exp_x/1[ms];
+    evolve log_y' = -log_y/1[ms];
+    evolve exprelr_x' = -exprelr_x/1[ms];
+
+    # parameter exports
+    export x;
+    export y;
+}
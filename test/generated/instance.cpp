@@ -0,0 +1,109 @@
+#include <stdexcept>
+
+#include "instance.hpp"
+
+const catalogue_entry& find_mechanism(const std::string& name) {
+    for (const auto& e: catalogue) {
+        if (e.name == name) return e;
+    }
+    throw std::runtime_error("no generated mechanism " + name);
+}
+
+static arb_size_type field_index(const arb_field_info* fields, arb_size_type n, const std::string& name) {
+    for (arb_size_type k = 0; k < n; ++k) {
+        if (name == fields[k].name) return k;
+    }
+    throw std::runtime_error("no field " + name);
+}
+
+mechanism_instance::mechanism_instance(const std::string& name, std::vector<arb_index_type> nodes, arb_size_type n_nodes):
+    node_index(std::move(nodes))
+{
+    const auto& entry = find_mechanism(name);
+    type = entry.type();
+    iface = entry.interface();
+
+    // Padding instances are placed on the last node, with a weight of zero.
+    arb_size_type width = node_index.size();
+    arb_size_type block = iface->partition_width;
+    arb_size_type padded = (width + block - 1)/block*block;
+    node_index.resize(padded, node_index.empty()? 0: node_index.back());
+    multiplicity.assign(padded, 1);
+    weight.assign(width, 1);
+    weight.resize(padded, 0);
+
+    for (arb_size_type b = 0; b < padded; b += block) {
+        bool is_contiguous = true, is_constant = true, is_independent = true;
+        for (arb_size_type k = b+1; k < b+block; ++k) {
+            is_contiguous  &= node_index[k] == node_index[k-1] + 1;
+            is_constant    &= node_index[k] == node_index[k-1];
+            is_independent &= node_index[k] > node_index[k-1];
+        }
+        if (is_contiguous)       contiguous.push_back(b);
+        else if (is_constant)    constant.push_back(b);
+        else if (is_independent) independent.push_back(b);
+        else                     none.push_back(b);
+    }
+    cell_index.assign(n_nodes, 0);
+    v.assign(n_nodes, -0.065);
+    i.assign(n_nodes, 0);
+    g.assign(n_nodes, 0);
+    dt.assign(n_nodes, 2.5e-5);
+    temperature.assign(n_nodes, 6.3);
+    time_since_spike.assign(1, -1);
+
+    for (arb_size_type k = 0; k < type.n_parameters; ++k) {
+        parameters.emplace_back(padded, type.parameters[k].default_value);
+    }
+    for (arb_size_type k = 0; k < type.n_state_vars; ++k) {
+        states.emplace_back(padded, 0);
+    }
+    for (auto& p: parameters) parameter_ptrs.push_back(p.data());
+    for (auto& s: states) state_ptrs.push_back(s.data());
+    for (arb_size_type k = 0; k < type.n_globals; ++k) {
+        globals.push_back(type.globals[k].default_value);
+    }
+
+    ions.resize(type.n_ions);
+    for (auto& ion: ions) {
+        ion.current_density.assign(n_nodes, 0);
+        ion.reversal_potential.assign(n_nodes, 0);
+        ion.internal_concentration.assign(n_nodes, 1);
+        ion.external_concentration.assign(n_nodes, 1);
+        ion.ionic_charge.assign(n_nodes, 1);
+        ion.index = node_index;
+        ion_states.push_back({ion.current_density.data(), ion.reversal_potential.data(),
+                              ion.internal_concentration.data(), ion.external_concentration.data(),
+                              ion.ionic_charge.data(), ion.index.data()});
+    }
+
+    pp = {};
+    pp.width = width;
+    pp.n_detectors = 1;
+    pp.vec_ci = cell_index.data();
+    pp.vec_dt = dt.data();
+    pp.vec_v = v.data();
+    pp.vec_i = i.data();
+    pp.vec_g = g.data();
+    pp.temperature_degC = temperature.data();
+    pp.time_since_spike = time_since_spike.data();
+    pp.node_index = node_index.data();
+    pp.multiplicity = multiplicity.data();
+    pp.weight = weight.data();
+    pp.mechanism_id = 0;
+    pp.parameters = parameter_ptrs.data();
+    pp.state_vars = state_ptrs.data();
+    pp.globals = globals.data();
+    pp.ion_states = ion_states.data();
+    pp.index_constraints = {arb_size_type(contiguous.size()), arb_size_type(constant.size()),
+                            arb_size_type(independent.size()), arb_size_type(none.size()),
+                            contiguous.data(), constant.data(), independent.data(), none.data()};
+}
+
+arb_value_type& mechanism_instance::parameter(const std::string& name, arb_size_type i) {
+    return parameters[field_index(type.parameters, type.n_parameters, name)][i];
+}
+
+arb_value_type& mechanism_instance::state(const std::string& name, arb_size_type i) {
+    return states[field_index(type.state_vars, type.n_state_vars, name)][i];
+}
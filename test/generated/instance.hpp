@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <arbor/mechanism_abi.h>
+
+#include "catalogue.hpp"
+
+// The storage of the instances of a generated mechanism on the given nodes of
+// a cell with `n_nodes` nodes, and the parameter pack that points to it. The
+// storage is padded to a multiple of the partition width of the mechanism,
+// and the index constraint partition is computed as arbor does. Parameters
+// are set to their default values, states and node-indexed values to zero.
+struct mechanism_instance {
+    arb_mechanism_type type;
+    arb_mechanism_interface* iface;
+    arb_mechanism_ppack pp;
+
+    std::vector<arb_index_type> node_index, multiplicity, cell_index;
+    std::vector<arb_index_type> contiguous, constant, independent, none;
+    std::vector<arb_value_type> weight;
+    std::vector<arb_value_type> v, i, g, dt, temperature, time_since_spike;
+    std::vector<std::vector<arb_value_type>> parameters, states;
+    std::vector<arb_value_type*> parameter_ptrs, state_ptrs;
+    std::vector<arb_value_type> globals;
+
+    struct ion_storage {
+        std::vector<arb_value_type> current_density, reversal_potential, internal_concentration, external_concentration, ionic_charge;
+        std::vector<arb_index_type> index;
+    };
+    std::vector<ion_storage> ions;
+    std::vector<arb_ion_state> ion_states;
+
+    mechanism_instance(const std::string& name, std::vector<arb_index_type> nodes, arb_size_type n_nodes);
+
+    arb_value_type& parameter(const std::string& name, arb_size_type i);
+    arb_value_type& state(const std::string& name, arb_size_type i);
+
+    void init() { iface->init_mechanism(&pp); }
+    void advance_state() { iface->advance_state(&pp); }
+    void compute_currents() { iface->compute_currents(&pp); }
+    void apply_events(arb_deliverable_event_stream& stream) { iface->apply_events(&pp, &stream); }
+    void post_event() { iface->post_event(&pp); }
+};
@@ -0,0 +1,27 @@
+mechanism density "rectifier" {
+    # parameters
+    parameter g = 0.001 [S/cm^2];
+    parameter e = -65   [mV];
+    parameter tau = 2   [ms];
+
+    # states
+    state s: real;
+
+    # bindings
+    bind v = membrane_potential;
+
+    # initializations
+    # (a conditional: a masked assignment in the SIMD kernels)
+    initial s = if v > e then 1 else 0.1;
+
+    # evolutions
+    evolve s' = (1 - s)/tau;
+
+    # effects
+    effect current_density = g*s*(v-e);
+
+    # parameter exports
+    export g;
+    export e;
+    export tau;
+}
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../gtest.h"
+
+#include "instance.hpp"
+
+// Every example is compiled; run each for a few time steps.
+TEST(generated, examples) {
+    ASSERT_FALSE(catalogue.empty());
+    for (const auto& entry: catalogue) {
+        SCOPED_TRACE(entry.name);
+        mechanism_instance m(entry.name, {0, 1, 1, 2}, 3);
+        arb_deliverable_event_data events[] = {{0, 0, 0.5f}, {0, 2, 0.25f}};
+        arb_index_type begin[] = {0}, end[] = {2};
+        arb_deliverable_event_stream stream = {1, events, begin, end};
+
+        m.init();
+        for (int step = 0; step < 4; ++step) {
+            m.apply_events(stream);
+            m.compute_currents();
+            m.advance_state();
+            m.post_event();
+        }
+        for (const auto& s: m.states) {
+            for (auto x: s) EXPECT_TRUE(std::isfinite(x));
+        }
+        for (auto x: m.i) EXPECT_TRUE(std::isfinite(x));
+    }
+}
+
+// Run the scalar and SIMD kernels of a mechanism on instances on `nodes`,
+// and compare the states and the contributions to the nodes.
+static void expect_simd_matches_scalar(const std::string& name, const std::vector<arb_index_type>& nodes, arb_size_type n_nodes) {
+    mechanism_instance scalar(name, nodes, n_nodes), simd(name + "_simd", nodes, n_nodes);
+
+    std::vector<arb_deliverable_event_data> events;
+    for (arb_size_type k = 0; k < nodes.size(); k += 3) {
+        events.push_back({0, k, 0.25f + k});
+    }
+    arb_index_type begin[] = {0}, end[] = {arb_index_type(events.size())};
+    arb_deliverable_event_stream stream = {1, events.data(), begin, end};
+
+    for (auto* m: {&scalar, &simd}) {
+        for (arb_size_type n = 0; n < n_nodes; ++n) {
+            m->v[n] = -0.08 + 0.005*n;
+        }
+        m->init();
+        for (int step = 0; step < 4; ++step) {
+            m->apply_events(stream);
+            m->compute_currents();
+            m->advance_state();
+            m->post_event();
+        }
+    }
+
+    auto expect_near = [](double x, double y) {
+        EXPECT_NEAR(x, y, 1e-12*std::max(1.0, std::abs(x)));
+    };
+    for (arb_size_type s = 0; s < scalar.states.size(); ++s) {
+        for (arb_size_type k = 0; k < nodes.size(); ++k) {
+            expect_near(scalar.states[s][k], simd.states[s][k]);
+        }
+    }
+    for (arb_size_type n = 0; n < n_nodes; ++n) {
+        expect_near(scalar.i[n], simd.i[n]);
+        expect_near(scalar.g[n], simd.g[n]);
+        for (arb_size_type ion = 0; ion < scalar.ions.size(); ++ion) {
+            expect_near(scalar.ions[ion].current_density[n], simd.ions[ion].current_density[n]);
+        }
+    }
+}
+
+// The mechanisms compiled with both scalar and SIMD kernels, by the name of the former.
+static std::vector<std::string> simd_mechanisms() {
+    const std::string suffix = "_simd";
+    std::vector<std::string> names;
+    for (const auto& entry: catalogue) {
+        auto n = entry.name.size();
+        if (n <= suffix.size() || entry.name.compare(n - suffix.size(), suffix.size(), suffix)) continue;
+        names.push_back(entry.name.substr(0, n - suffix.size()));
+    }
+    return names;
+}
+
+// The SIMD kernels compute what the scalar kernels do.
+TEST(generated, simd_matches_scalar) {
+    for (const auto& name: simd_mechanisms()) {
+        SCOPED_TRACE(name);
+        expect_simd_matches_scalar(name, {0, 1, 1, 2, 3, 5}, 6);
+    }
+}
+
+// The SIMD kernels iterate over the batches of each class of the index
+// constraint partition with a specialized loop. The first layouts have
+// batches of a single class for SIMD widths of 4 and 8, the last mixes
+// the classes and is padded.
+TEST(generated, index_constraint_partitions) {
+    struct layout {
+        std::vector<arb_index_type> nodes;
+        arb_size_type n_nodes;
+        arb_size_type arb_constraint_partition::* n_class;
+    };
+    std::vector<layout> layouts = {
+        {{0, 1, 2, 3, 4, 5, 6, 7},  8, &arb_constraint_partition::n_contiguous},
+        {{2, 2, 2, 2, 2, 2, 2, 2},  3, &arb_constraint_partition::n_constant},
+        {{0, 2, 3, 5, 6, 8, 9, 10}, 11, &arb_constraint_partition::n_independent},
+        {{0, 0, 1, 3, 3, 4, 4, 4},  5, &arb_constraint_partition::n_none},
+        {{0, 1, 2, 3, 4, 4, 4, 4, 5, 7, 8, 10, 11, 11, 12, 12, 13}, 14, nullptr},
+    };
+    for (const auto& [nodes, n_nodes, n_class]: layouts) {
+        mechanism_instance m("pas_simd", nodes, n_nodes);
+        auto width = m.iface->partition_width;
+        const auto& ic = m.pp.index_constraints;
+        EXPECT_EQ(m.node_index.size()/width, ic.n_contiguous + ic.n_constant + ic.n_independent + ic.n_none);
+        if (n_class && width >= 4 && 8%width == 0) {
+            EXPECT_EQ(8/width, ic.*n_class);
+        }
+    }
+
+    for (const auto& name: simd_mechanisms()) {
+        for (const auto& [nodes, n_nodes, n_class]: layouts) {
+            SCOPED_TRACE(name + " on nodes " + std::to_string(nodes.front()) + "..." + std::to_string(nodes.back()));
+            expect_simd_matches_scalar(name, nodes, n_nodes);
+        }
+    }
+}
+
+TEST(generated, is_linear) {
+    EXPECT_TRUE(find_mechanism("expsyn").type().is_linear);
+    EXPECT_TRUE(find_mechanism("exp2syn").type().is_linear);
+    EXPECT_FALSE(find_mechanism("expsyn_stdp").type().is_linear);
+    EXPECT_FALSE(find_mechanism("hh").type().is_linear);
+}
+
+TEST(generated, coalesced_instances) {
+    // An instance of multiplicity 3 receives the events of the 3 instances
+    // it stands for, and behaves as their sum.
+    ASSERT_TRUE(find_mechanism("coalesced").type().is_linear);
+    for (std::string name: {"coalesced", "coalesced_simd"}) {
+        SCOPED_TRACE(name);
+        mechanism_instance coalesced(name, {1}, 2), separate(name, {1, 1, 1}, 2);
+        coalesced.multiplicity[0] = 3;
+
+        arb_deliverable_event_data coalesced_events[] = {{0, 0, 0.25f}, {0, 0, 0.5f}};
+        arb_deliverable_event_data separate_events[] = {{0, 0, 0.25f}, {0, 2, 0.5f}};
+        arb_index_type begin[] = {0}, end[] = {2};
+        arb_deliverable_event_stream coalesced_stream = {1, coalesced_events, begin, end};
+        arb_deliverable_event_stream separate_stream = {1, separate_events, begin, end};
+
+        for (auto* m: {&coalesced, &separate}) {
+            m->v[1] = -0.07;
+            m->init();
+        }
+        EXPECT_DOUBLE_EQ(3*separate.state("g", 0), coalesced.state("g", 0));
+        for (int step = 0; step < 4; ++step) {
+            coalesced.apply_events(coalesced_stream);
+            separate.apply_events(separate_stream);
+            for (auto* m: {&coalesced, &separate}) {
+                m->compute_currents();
+                m->advance_state();
+            }
+        }
+        double sum = 0;
+        for (arb_size_type k = 0; k < 3; ++k) sum += separate.state("g", k);
+        EXPECT_DOUBLE_EQ(sum, coalesced.state("g", 0));
+        EXPECT_DOUBLE_EQ(separate.i[1], coalesced.i[1]);
+        EXPECT_DOUBLE_EQ(separate.g[1], coalesced.g[1]);
+        EXPECT_NE(0.0, coalesced.i[1]);
+    }
+}
+
+TEST(generated, expsyn_stdp_on_event) {
+    // The conductance is clamped to [0, max_weight].
+    mechanism_instance m("expsyn_stdp", {0, 0}, 1);
+    m.init();
+    arb_deliverable_event_data events[] = {{0, 0, -1.0f}, {0, 1, 1.0f}};
+    arb_index_type begin[] = {0}, end[] = {2};
+    arb_deliverable_event_stream stream = {1, events, begin, end};
+    m.apply_events(stream);
+
+    EXPECT_EQ(0.0, m.state("_s_g", 0));
+    EXPECT_DOUBLE_EQ(m.parameter("max_weight", 1), m.state("_s_g", 1));
+}
+
+TEST(generated, interleaved_events) {
+    // The events of a stream are ordered by time, not by mechanism: the events
+    // of the mechanism are interleaved with those of others. The second stream
+    // has a run of events with distinct targets, applied at once by the SIMD
+    // kernels, and the third repeats a target.
+    for (const auto& entry: catalogue) {
+        if (entry.name != "expsyn" && entry.name != "expsyn_simd") continue;
+        SCOPED_TRACE(entry.name);
+
+        const arb_size_type n = 8;
+        mechanism_instance m(entry.name, {0, 1, 2, 3, 4, 5, 6, 7}, n);
+        m.pp.mechanism_id = 3;
+        m.init();
+
+        std::vector<arb_deliverable_event_data> events;
+        for (arb_size_type k = 0; k < n; ++k) {
+            events.push_back({1, k, 100.0f});
+            events.push_back({3, k, float(k+1)});
+            events.push_back({5, n-1-k, 1000.0f});
+        }
+        arb_index_type second = events.size();
+        for (arb_size_type k = 0; k < n; ++k) {
+            events.push_back({3, k, 0.5f});
+        }
+        arb_index_type third = events.size();
+        events.push_back({3, 2, 0.25f});
+        events.push_back({2, 2, 1000.0f});
+        events.push_back({3, 2, 0.25f});
+        arb_index_type last = events.size();
+
+        arb_index_type begin[] = {0, second, third}, end[] = {second, third, last};
+        arb_deliverable_event_stream stream = {3, events.data(), begin, end};
+        m.apply_events(stream);
+
+        for (arb_size_type k = 0; k < n; ++k) {
+            EXPECT_DOUBLE_EQ(k + 1.5 + (k == 2? 0.5: 0.0), m.state("g", k));
+        }
+    }
+}
+
+TEST(generated, segmented_writes) {
+    // The contributions of instances on the same node are summed before
+    // being written, whether the node indices repeat or not.
+    std::vector<std::vector<arb_index_type>> layouts = {
+        {0, 0, 0, 1, 2, 2},
+        {0, 1, 2, 3, 4, 5},
+        {0, 0, 1, 1, 0, 0},
+    };
+    for (const auto& nodes: layouts) {
+        mechanism_instance plain("expsyn", nodes, 6);
+        mechanism_instance segmented("expsyn_segmented", nodes, 6);
+        for (auto* m: {&plain, &segmented}) {
+            m->init();
+            for (arb_size_type k = 0; k < nodes.size(); ++k) {
+                m->state("g", k) = 0.5 + k;
+                m->weight[k] = 1.0 + 0.25*k;
+            }
+            for (arb_size_type n = 0; n < 6; ++n) {
+                m->v[n] = -0.06 + 0.01*n;
+            }
+            m->compute_currents();
+        }
+        for (arb_size_type n = 0; n < 6; ++n) {
+            EXPECT_DOUBLE_EQ(plain.i[n], segmented.i[n]);
+            EXPECT_DOUBLE_EQ(plain.g[n], segmented.g[n]);
+        }
+        EXPECT_NE(0.0, segmented.i[0]);
+    }
+}
+
+TEST(generated, uniform_hoisting) {
+    // The values depending only on the temperature are computed once per
+    // kernel call when it is declared uniform, with the same results.
+    std::vector<arb_index_type> nodes = {0, 1, 1, 2, 3};
+    mechanism_instance plain("hh", nodes, 4), uniform("hh_uniform", nodes, 4);
+    for (auto* m: {&plain, &uniform}) {
+        for (arb_size_type n = 0; n < 4; ++n) {
+            m->temperature[n] = 20.0;
+            m->v[n] = -0.07 + 0.01*n;
+        }
+        m->init();
+        for (int step = 0; step < 4; ++step) {
+            m->compute_currents();
+            m->advance_state();
+        }
+    }
+    for (arb_size_type s = 0; s < plain.states.size(); ++s) {
+        for (arb_size_type k = 0; k < nodes.size(); ++k) {
+            EXPECT_DOUBLE_EQ(plain.states[s][k], uniform.states[s][k]);
+        }
+    }
+    for (arb_size_type n = 0; n < 4; ++n) {
+        EXPECT_DOUBLE_EQ(plain.i[n], uniform.i[n]);
+    }
+}
+
+TEST(generated, vectorize_hints) {
+    // The kernels annotated for the auto-vectorizer compute the same values.
+    std::vector<arb_index_type> nodes = {0, 1, 1, 2, 3, 4, 5, 5};
+    for (std::string name: {"expsyn", "hh"}) {
+        SCOPED_TRACE(name);
+        mechanism_instance plain(name, nodes, 6), hints(name + "_hints", nodes, 6);
+        arb_deliverable_event_data events[] = {{0, 0, 0.5f}, {0, 3, 0.25f}};
+        arb_index_type begin[] = {0}, end[] = {2};
+        arb_deliverable_event_stream stream = {1, events, begin, end};
+        for (auto* m: {&plain, &hints}) {
+            for (arb_size_type n = 0; n < 6; ++n) {
+                m->v[n] = -0.075 + 0.005*n;
+            }
+            m->init();
+            for (int step = 0; step < 4; ++step) {
+                m->apply_events(stream);
+                m->compute_currents();
+                m->advance_state();
+            }
+        }
+        for (arb_size_type s = 0; s < plain.states.size(); ++s) {
+            for (arb_size_type k = 0; k < nodes.size(); ++k) {
+                EXPECT_DOUBLE_EQ(plain.states[s][k], hints.states[s][k]);
+            }
+        }
+        for (arb_size_type n = 0; n < 6; ++n) {
+            EXPECT_DOUBLE_EQ(plain.i[n], hints.i[n]);
+            EXPECT_DOUBLE_EQ(plain.g[n], hints.g[n]);
+        }
+    }
+}
+
+TEST(generated, global_parameters) {
+    // A global parameter is read from the globals of the mechanism, in
+    // place of the per-instance values.
+    auto type = find_mechanism("pas_global").type();
+    ASSERT_EQ(1u, type.n_globals);
+    EXPECT_EQ(std::string("g"), type.globals[0].name);
+    ASSERT_EQ(1u, type.n_parameters);
+    EXPECT_EQ(std::string("e"), type.parameters[0].name);
+
+    std::vector<arb_index_type> nodes = {0, 1, 1, 2, 3};
+    mechanism_instance plain("pas", nodes, 4), global("pas_global", nodes, 4);
+    EXPECT_EQ(plain.parameter("g", 0), global.globals[0]);
+    global.globals[0] = 25;
+    for (arb_size_type k = 0; k < nodes.size(); ++k) {
+        plain.parameter("g", k) = 25;
+    }
+    for (auto* m: {&plain, &global}) {
+        for (arb_size_type n = 0; n < 4; ++n) {
+            m->v[n] = -0.08 + 0.01*n;
+        }
+        m->init();
+        m->compute_currents();
+    }
+    for (arb_size_type n = 0; n < 4; ++n) {
+        EXPECT_DOUBLE_EQ(plain.i[n], global.i[n]);
+        EXPECT_DOUBLE_EQ(plain.g[n], global.g[n]);
+    }
+    EXPECT_NE(0.0, global.i[3]);
+}
+
+TEST(generated, fast_math) {
+    // The errors of the approximations of exp, log and exprelr are within the
+    // bounds stated in printer_options.hpp, measured against long double.
+    std::mt19937_64 gen(42);
+    auto uniform = [&](double lo, double hi) {return std::uniform_real_distribution<double>(lo, hi)(gen);};
+
+    std::vector<double> xs = {0.0, -0.0, 1e-300, -1e-300, 1e-8, -1e-8, -708.39, 709.78};
+    std::vector<double> ys = {1.0, std::numeric_limits<double>::denorm_min(), 1e-310,
+                              std::numeric_limits<double>::min(), std::numeric_limits<double>::max()};
+    for (int k = 0; k < 20000; ++k) {
+        xs.push_back(uniform(-708.39, 709.78));
+        xs.push_back(uniform(-1, 1));
+        xs.push_back(std::copysign(std::pow(10.0, uniform(-300, 0)), uniform(-1, 1)));
+        ys.push_back(std::pow(10.0, uniform(-307, 308)));
+        ys.push_back(uniform(0.5, 2));
+    }
+    ys.resize(xs.size(), 1.0);
+
+    mechanism_instance m("fast_math", std::vector<arb_index_type>(xs.size(), 0), 1);
+    for (arb_size_type k = 0; k < xs.size(); ++k) {
+        m.parameter("x", k) = xs[k];
+        m.parameter("y", k) = ys[k];
+    }
+    m.init();
+
+    // Error in units of the last place of the correctly rounded result.
+    auto ulp_error = [](double approx, long double exact) {
+        double rounded = std::abs(double(exact));
+        double ulp = std::nextafter(rounded, std::numeric_limits<double>::infinity()) - rounded;
+        if (rounded == 0) ulp = std::numeric_limits<double>::denorm_min();
+        return double(std::abs(approx - exact)/ulp);
+    };
+    double exp_error = 0, log_error = 0, exprelr_error = 0;
+    for (arb_size_type k = 0; k < xs.size(); ++k) {
+        long double x = xs[k], y = ys[k];
+        exp_error     = std::max(exp_error, ulp_error(m.state("exp_x", k), std::exp(x)));
+        log_error     = std::max(log_error, ulp_error(m.state("log_y", k), std::log(y)));
+        exprelr_error = std::max(exprelr_error, ulp_error(m.state("exprelr_x", k), x == 0? 1.0L: x/std::expm1(x)));
+    }
+    EXPECT_LE(exp_error, 1.2);
+    EXPECT_LE(log_error, 0.9);
+    EXPECT_LE(exprelr_error, 2.4);
+
+    // Outside of the range of exp, the results saturate.
+    m.parameter("x", 0) = -800;
+    m.parameter("x", 1) = 800;
+    m.init();
+    EXPECT_EQ(0.0, m.state("exp_x", 0));
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), m.state("exp_x", 1));
+}
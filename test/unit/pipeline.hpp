@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+
+#include <arblang/optimizer/inline_func.hpp>
+#include <arblang/optimizer/optimizer.hpp>
+#include <arblang/parser/normalizer.hpp>
+#include <arblang/parser/parser.hpp>
+#include <arblang/pre_printer/printable_mechanism.hpp>
+#include <arblang/resolver/canonicalize.hpp>
+#include <arblang/resolver/resolve.hpp>
+#include <arblang/resolver/single_assign.hpp>
+#include <arblang/solver/solve.hpp>
+
+// Compile a mechanism up to printing, as the compiler does.
+inline al::resolved_ir::resolved_mechanism solve_mechanism(const std::string& mech,
+                                                           const al::resolved_ir::solver_options& opt = {}) {
+    using namespace al;
+    using namespace resolved_ir;
+    auto p = parser(mech);
+    auto m_ssa = single_assign(canonicalize(resolve(normalize(p.parse_mechanism()))));
+    auto m_opt = optimizer(m_ssa).optimize();
+    auto m_fin = optimizer(inline_func(m_opt)).optimize();
+    return solve(m_fin, "i", "g", opt);
+}
+
+inline al::resolved_ir::printable_mechanism make_printable(const std::string& mech,
+                                                           const std::unordered_set<std::string>& uniform = {},
+                                                           const std::unordered_set<std::string>& global = {}) {
+    return al::resolved_ir::printable_mechanism(solve_mechanism(mech), "i", "g", uniform, global);
+}
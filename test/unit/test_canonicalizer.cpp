@@ -1358,4 +1358,4 @@ TEST(optimizer, mechanism) {
         std::cout << "/**********************************************/" << std::endl;
         std::cout << print_mechanism(m_printable, "namespace").str() << std::endl;
     }
-}
\ No newline at end of file
+}
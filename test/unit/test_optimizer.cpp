@@ -0,0 +1,192 @@
+#include <string>
+
+#include <arblang/optimizer/inline_func.hpp>
+#include <arblang/optimizer/optimizer.hpp>
+#include <arblang/optimizer/ssa_block.hpp>
+#include <arblang/optimizer/strength_reduce.hpp>
+#include <arblang/optimizer/tabulate.hpp>
+#include <arblang/parser/parser.hpp>
+#include <arblang/parser/normalizer.hpp>
+#include <arblang/pre_printer/printable_mechanism.hpp>
+#include <arblang/printer/print_mechanism.hpp>
+#include <arblang/resolver/canonicalize.hpp>
+#include <arblang/resolver/resolve.hpp>
+#include <arblang/resolver/resolved_expressions.hpp>
+#include <arblang/resolver/resolved_types.hpp>
+#include <arblang/resolver/single_assign.hpp>
+#include <arblang/solver/solve.hpp>
+#include <arblang/util/pretty_printer.hpp>
+
+#include "../gtest.h"
+
+using namespace al;
+using namespace resolved_ir;
+using namespace resolved_type_ir;
+
+TEST(ssa_block, let) {
+    auto loc = src_location{};
+    auto voltage_type = make_rtype<resolved_quantity>(normalized_type(quantity::voltage), loc);
+    auto conductance_type = make_rtype<resolved_quantity>(normalized_type(quantity::conductance), loc);
+
+    in_scope_map scope_map;
+    scope_map.local_map.insert({"a", make_rexpr<resolved_argument>("a", voltage_type, loc)});
+    scope_map.local_map.insert({"s", make_rexpr<resolved_argument>("s", conductance_type, loc)});
+
+    std::string p_expr = "let b:voltage = a*5; let c:voltage = a*5; let d:voltage = c; let f:voltage = a*7; let e:current = (b+d)*s; e)";
+    auto p = parser(p_expr);
+    auto let = p.parse_let();
+    auto let_ssa = single_assign(canonicalize(resolve(normalize(let), scope_map), "t"), "r");
+
+    auto block = lower_to_ssa(let_ssa);
+    ASSERT_TRUE(block);
+    EXPECT_EQ(10u, block->bindings.size());
+    EXPECT_EQ(pretty_print(let_ssa), pretty_print(raise_from_ssa(block.value())));
+
+    EXPECT_TRUE(copy_propagate(block.value()));
+    EXPECT_EQ("let _t0:m^2*Kg^1*s^-3*A^-1 = a*5:real;\n"
+              "let _t1:m^2*Kg^1*s^-3*A^-1 = a*5:real;\n"
+              "let _t2:m^2*Kg^1*s^-3*A^-1 = a*7:real;\n"
+              "let _t3:m^2*Kg^1*s^-3*A^-1 = _t0+_t1;\n"
+              "let _t4:A^1 = _t3*s;\n"
+              "_t4;", pretty_print(raise_from_ssa(block.value())));
+
+    EXPECT_TRUE(cse(block.value()));
+    EXPECT_TRUE(eliminate_dead_code(block.value()));
+    EXPECT_FALSE(cse(block.value()));
+    EXPECT_FALSE(copy_propagate(block.value()));
+    EXPECT_FALSE(eliminate_dead_code(block.value()));
+
+    auto let_opt = raise_from_ssa(block.value());
+    EXPECT_EQ("let _t0:m^2*Kg^1*s^-3*A^-1 = a*5:real;\n"
+              "let _t3:m^2*Kg^1*s^-3*A^-1 = _t0+_t0;\n"
+              "let _t4:A^1 = _t3*s;\n"
+              "_t4;", pretty_print(let_opt));
+    EXPECT_EQ(pretty_print(optimizer(let_ssa).optimize()), pretty_print(let_opt));
+
+    // Optimized expressions are returned as is, not copied.
+    auto folded = constant_fold(let_opt);
+    EXPECT_FALSE(folded.second);
+    EXPECT_EQ(let_opt, folded.first);
+    EXPECT_EQ(let_opt, optimize_let_chains(let_opt).first);
+    EXPECT_EQ(let_opt, optimizer(let_opt).optimize());
+
+    // Values with nested let-expressions can't be lowered.
+    auto nested = make_rexpr<resolved_let>("x", let_ssa, let_ssa, type_of(let_ssa), loc);
+    EXPECT_FALSE(lower_to_ssa(nested));
+}
+
+TEST(strength_reduce, let) {
+    auto loc = src_location{};
+    auto real_type    = make_rtype<resolved_quantity>(normalized_type(quantity::real), loc);
+    auto voltage_type = make_rtype<resolved_quantity>(normalized_type(quantity::voltage), loc);
+    {
+        in_scope_map scope_map;
+        scope_map.local_map.insert({"a", make_rexpr<resolved_argument>("a", voltage_type, loc)});
+        scope_map.local_map.insert({"d", make_rexpr<resolved_argument>("d", real_type, loc)});
+
+        std::string p_expr = "let x = a^5; let y = x/d; let z = a^2/d; y*z;";
+        auto p = parser(p_expr);
+        auto let = p.parse_let();
+
+        auto let_normal = normalize(let);
+        auto let_resolved = resolve(let_normal, scope_map);
+        auto let_canon = canonicalize(let_resolved, "t");
+        auto let_ssa = single_assign(let_canon, "r");
+
+        auto opt = optimizer(let_ssa);
+        auto let_opt = opt.optimize();
+
+        auto let_reduced = strength_reduce(let_opt);
+        EXPECT_TRUE(let_reduced.second);
+
+        auto opt_reduced = optimizer(let_reduced.first);
+        let_opt = opt_reduced.optimize();
+
+        std::string expected_opt = "let _pw0:m^4*Kg^2*s^-6*A^-2 = a*a;\n"
+                                   "let _pw1:m^8*Kg^4*s^-12*A^-4 = _pw0*_pw0;\n"
+                                   "let _pw2:m^10*Kg^5*s^-15*A^-5 = a*_pw1;\n"
+                                   "let _rcp0:real = 1:real/d;\n"
+                                   "let _t1:m^10*Kg^5*s^-15*A^-5 = _pw2*_rcp0;\n"
+                                   "let _t3:m^4*Kg^2*s^-6*A^-2 = _pw0*_rcp0;\n"
+                                   "let _t4:m^14*Kg^7*s^-21*A^-7 = _t1*_t3;\n"
+                                   "_t4;";
+        EXPECT_EQ(expected_opt, pretty_print(let_opt));
+        EXPECT_FALSE(strength_reduce(let_opt).second);
+    }
+    {
+        in_scope_map scope_map;
+        scope_map.local_map.insert({"a", make_rexpr<resolved_argument>("a", real_type, loc)});
+        scope_map.local_map.insert({"b", make_rexpr<resolved_argument>("b", real_type, loc)});
+
+        std::string p_expr = "let x = a^b; let y = x/a; y;";
+        auto p = parser(p_expr);
+        auto let = p.parse_let();
+
+        auto let_normal = normalize(let);
+        auto let_resolved = resolve(let_normal, scope_map);
+        auto let_canon = canonicalize(let_resolved, "t");
+        auto let_ssa = single_assign(let_canon, "r");
+
+        auto opt = optimizer(let_ssa);
+        auto let_opt = opt.optimize();
+
+        EXPECT_FALSE(strength_reduce(let_opt).second);
+    }
+}
+
+TEST(tabulate, mechanism) {
+    std::string mech =
+        "mechanism density \"tab\" {\n"
+        "    parameter gbar = 0.1 [S/cm^2];\n"
+        "    bind v = membrane_potential;\n"
+        "    state s: real;\n"
+        "    function rate(v: voltage): real {\n"
+        "        exp(-v/10[mV]);\n"
+        "    }\n"
+        "    function scaled(x: voltage): real {\n"
+        "        gbar*1[m^2/S]*rate(x);\n"
+        "    }\n"
+        "    initial s = 0;\n"
+        "    evolve s' = (rate(v) - s)/1[s];\n"
+        "    effect current_density = gbar*s*v;\n"
+        "    export gbar;\n"
+        "}";
+
+    auto p = parser(mech);
+    auto m = p.parse_mechanism();
+    auto m_normal = normalize(m);
+    auto m_resolved = resolve(m_normal);
+    auto m_canon = canonicalize(m_resolved);
+    auto m_ssa = single_assign(m_canon);
+
+    auto opt_0 = optimizer(m_ssa);
+    auto m_opt = opt_0.optimize();
+
+    {
+        auto tables = tabulate(m_opt, {{"rate", {-0.1, 0.1, 100}}});
+        EXPECT_EQ(1u, tables.size());
+        EXPECT_EQ("rate", tables.front().name);
+
+        auto m_inlined = inline_func(m_opt, {"rate"});
+        auto opt_1 = optimizer(m_inlined);
+        auto m_fin = opt_1.optimize();
+
+        std::string expected_evolve = "evolve s:s^-1 =\n"
+                                      "let _t0:real = rate(v);\n"
+                                      "let _t1:real = _t0-s;\n"
+                                      "let _t2:s^-1 = _t1/1:s^1;\n"
+                                      "_t2;";
+        EXPECT_EQ(expected_evolve, pretty_print(m_fin.evolutions.front()));
+
+        auto m_solved = solve(m_fin, "i", "g");
+        auto m_printable = printable_mechanism(m_solved, "i", "g", {}, {}, tables);
+        auto printed = print_mechanism(m_printable, "namespace").str();
+        EXPECT_NE(std::string::npos, printed.find("static arb_value_type _table_rate(arb_value_type v_)"));
+        EXPECT_NE(std::string::npos, printed.find("= _table_rate(v);"));
+    }
+    {
+        // Functions reading exported parameters, and unknown functions can't be tabulated.
+        EXPECT_THROW(tabulate(m_opt, {{"scaled", {-0.1, 0.1, 100}}}), std::runtime_error);
+        EXPECT_THROW(tabulate(m_opt, {{"foo", {-0.1, 0.1, 100}}}), std::runtime_error);
+    }
+}
@@ -6,6 +6,7 @@
 #include <arblang/parser/token.hpp>
 #include <arblang/parser/parser.hpp>
 #include <arblang/parser/normalizer.hpp>
+#include <arblang/resolver/resolve.hpp>
 #include <arblang/resolver/resolved_expressions.hpp>
 
 #include "../gtest.h"
@@ -706,6 +707,117 @@ TEST(parser, object) {
     }
 }
 
+TEST(parser, reaction) {
+    {
+        std::string obj = "{x' = 1; 2a + b + c -> 2b (x); \\0 -> c (3);}";
+        auto p = parser(obj);
+
+        // let _prod0 = a*a*b*c; let _flux0 = x*_prod0; let _flux1 = 3; {...}
+        auto l0 = std::get<parsed_let>(*p.parse_object());
+        EXPECT_EQ("_prod0", std::get<parsed_identifier>(*l0.identifier).name);
+        auto l1 = std::get<parsed_let>(*l0.body);
+        EXPECT_EQ("_flux0", std::get<parsed_identifier>(*l1.identifier).name);
+        auto l2 = std::get<parsed_let>(*l1.body);
+        EXPECT_EQ("_flux1", std::get<parsed_identifier>(*l2.identifier).name);
+
+        auto flux0 = std::get<parsed_binary>(*l1.value);
+        EXPECT_EQ(binary_op::mul, flux0.op);
+        EXPECT_EQ("x", std::get<parsed_identifier>(*flux0.lhs).name);
+        EXPECT_EQ("_prod0", std::get<parsed_identifier>(*flux0.rhs).name);
+
+        auto c = std::get<parsed_object>(*l2.body);
+        std::vector<std::string> fields = {"x'", "a'", "b'", "c'"};
+        ASSERT_EQ(fields.size(), c.record_fields.size());
+        for (unsigned i = 0; i < fields.size(); ++i) {
+            EXPECT_EQ(fields[i], std::get<parsed_identifier>(*c.record_fields[i]).name);
+        }
+
+        // a' = -2*_flux0
+        auto a = std::get<parsed_unary>(*c.record_values[1]);
+        EXPECT_EQ(unary_op::neg, a.op);
+        auto a_term = std::get<parsed_binary>(*a.value);
+        EXPECT_EQ(2, std::get<parsed_int>(*a_term.lhs).value);
+        EXPECT_EQ("_flux0", std::get<parsed_identifier>(*a_term.rhs).name);
+
+        // b' = _flux0
+        EXPECT_EQ("_flux0", std::get<parsed_identifier>(*c.record_values[2]).name);
+
+        // c' = -_flux0 + _flux1
+        auto c_val = std::get<parsed_binary>(*c.record_values[3]);
+        EXPECT_EQ(binary_op::add, c_val.op);
+        EXPECT_EQ("_flux1", std::get<parsed_identifier>(*c_val.rhs).name);
+    }
+    {
+        std::string obj = "{a <-> 2b (kf, kb); c <- 2b (kc);}";
+        auto p = parser(obj);
+
+        // The product b*b is shared between both reactions consuming 2b.
+        auto l0 = std::get<parsed_let>(*p.parse_object());
+        EXPECT_EQ("_flux0", std::get<parsed_identifier>(*l0.identifier).name);
+        auto l1 = std::get<parsed_let>(*l0.body);
+        EXPECT_EQ("_prod0", std::get<parsed_identifier>(*l1.identifier).name);
+        auto l2 = std::get<parsed_let>(*l1.body);
+        auto l3 = std::get<parsed_let>(*l2.body);
+        EXPECT_EQ("_flux2", std::get<parsed_identifier>(*l3.identifier).name);
+        auto flux2 = std::get<parsed_binary>(*l3.value);
+        EXPECT_EQ("_prod0", std::get<parsed_identifier>(*flux2.rhs).name);
+
+        auto c = std::get<parsed_object>(*l3.body);
+        EXPECT_EQ(3u, c.record_fields.size());
+    }
+    {
+        std::vector<std::string> incorrect_objs = {
+            "{a -> b;}",
+            "{a <-> b (k);}",
+            "{0a -> b (k);}",
+            "{a -> b (k); a' = 1;}",
+        };
+        for (const auto& s: incorrect_objs) {
+            auto p = parser(s);
+            EXPECT_THROW(p.parse_object(), std::runtime_error);
+        }
+    }
+}
+
+TEST(parser, reaction_mechanism) {
+    using namespace resolved_ir;
+    using namespace resolved_type_ir;
+    // The lowered reactions are resolved with the types of the derivatives of
+    // the species, including that of the catalyst `o` whose net change is zero.
+    std::string mech =
+        "mechanism density \"scheme\" {\n"
+        "    parameter kf = 2 [ms^-1];\n"
+        "    parameter kb = 1 [ms^-1];\n"
+        "    record state_rec { c: real, o: real, };\n"
+        "    state s: state_rec;\n"
+        "    initial s = state_rec { c = 1; o = 0; };\n"
+        "    evolve s' = let c = s.c; let o = s.o; state_rec' {\n"
+        "        c + o -> o (kf);\n"
+        "        \\0 <-> c (kb, kb);\n"
+        "    };\n"
+        "}";
+
+    auto p = parser(mech);
+    auto m_resolved = resolve(normalize(p.parse_mechanism()));
+    ASSERT_EQ(1u, m_resolved.evolutions.size());
+
+    auto evolve = std::get<resolved_evolve>(*m_resolved.evolutions.front());
+    auto state = std::get<resolved_argument>(*evolve.identifier);
+    EXPECT_EQ("s", state.name);
+    auto rec = std::get<resolved_record>(*evolve.type);
+    ASSERT_EQ(2u, rec.fields.size());
+    for (const auto& [name, type]: rec.fields) {
+        auto q = std::get<resolved_quantity>(*type);
+        EXPECT_EQ(normalized_type(quantity::real)/normalized_type(quantity::time), q.type);
+    }
+
+    // A species of unknown type doesn't resolve.
+    std::string bad = mech;
+    bad.replace(bad.find("c + o"), 5, "c + x");
+    auto q = parser(bad);
+    EXPECT_THROW(resolve(normalize(q.parse_mechanism())), std::runtime_error);
+}
+
 TEST(parser, let) {
     {
         std::string let = "let foo = 9; 12.62";
@@ -1449,6 +1561,26 @@ TEST(parser, conditional) {
         EXPECT_EQ(1, e_false.value);
         EXPECT_TRUE(std::get_if<parsed_no_unit>(e_false.unit.get()));
     }
+    {
+        // `<-` is a comparison with a negative value outside of reactions.
+        std::string cond = "if v<-0.05[V] then a<-b else 1";
+        auto p = parser(cond);
+        auto e = std::get<parsed_conditional>(*p.parse_conditional());
+
+        auto e_cond = std::get<parsed_binary>(*e.condition);
+        EXPECT_EQ(binary_op::lt, e_cond.op);
+        EXPECT_EQ("v", std::get<parsed_identifier>(*e_cond.lhs).name);
+        auto e_cond_rhs = std::get<parsed_unary>(*e_cond.rhs);
+        EXPECT_EQ(unary_op::neg, e_cond_rhs.op);
+        EXPECT_EQ(0.05, std::get<parsed_float>(*e_cond_rhs.value).value);
+
+        auto e_true = std::get<parsed_binary>(*e.value_true);
+        EXPECT_EQ(binary_op::lt, e_true.op);
+        EXPECT_EQ("a", std::get<parsed_identifier>(*e_true.lhs).name);
+        auto e_true_rhs = std::get<parsed_unary>(*e_true.rhs);
+        EXPECT_EQ(unary_op::neg, e_true_rhs.op);
+        EXPECT_EQ("b", std::get<parsed_identifier>(*e_true_rhs.value).name);
+    }
 }
 
 // exp, exprelr, log, cos, sin, abs, !, -, +, max, min
@@ -2204,9 +2336,24 @@ TEST(parser, mechanism) {
             "    };\n"
             "\n"
             "    effect current = expsyn.g*(v - e);\n"
+            "\n"
+            "    on_event(w: real) expsyn = external_spike(expsyn, w);\n"
+            "\n"
+            "    on_post(dt: time) expsyn = state_rec {\n"
+            "        g = expsyn.g;\n"
+            "        apre = expsyn.apre;\n"
+            "        apost = expsyn.apost + Apost;\n"
+            "        w_plastic = expsyn.w_plastic + expsyn.apre;\n"
+            "    };\n"
             "}";
         auto p = parser(mech);
-        EXPECT_NO_THROW(p.parse_mechanism());
+        auto m = p.parse_mechanism();
+        EXPECT_EQ(1u, m.on_events.size());
+        EXPECT_EQ(1u, m.post_events.size());
+
+        auto post = std::get<parsed_on_event>(*m.post_events.front());
+        EXPECT_EQ("dt", std::get<parsed_identifier>(*post.argument).name);
+        EXPECT_EQ("expsyn", std::get<parsed_identifier>(*post.identifier).name);
     }
     {
         std::string mech =
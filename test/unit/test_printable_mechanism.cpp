@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <arblang/pre_printer/linearity.hpp>
+#include <arblang/pre_printer/printable_mechanism.hpp>
+#include <arblang/pre_printer/uniformity.hpp>
+#include <arblang/util/pretty_printer.hpp>
+
+#include "../gtest.h"
+#include "pipeline.hpp"
+
+using namespace al;
+using namespace resolved_ir;
+
+// The rate of the relaxation only depends on the temperature.
+static const char* q10 =
+    "mechanism density \"q10\" {\n"
+    "    parameter gbar = 0.1 [S/cm^2];\n"
+    "    parameter e = -65 [mV];\n"
+    "    bind v = membrane_potential;\n"
+    "    bind temp = temperature;\n"
+    "    state m: real;\n"
+    "    initial m = 0;\n"
+    "    evolve m' = (exp(v/10[mV]) - m)*3^((temp - 6.3[K])/10[K])/1[ms];\n"
+    "    effect current_density = gbar*m*(v - e);\n"
+    "    export gbar;\n"
+    "}";
+
+TEST(printable_mechanism, shared_values) {
+    std::string mech =
+        "mechanism density \"shared\" {\n"
+        "    parameter gbar = 0.1 [S/cm^2];\n"
+        "    bind v = membrane_potential;\n"
+        "    state h: real;\n"
+        "    function minf(v: voltage): real {\n"
+        "        1/(1 + exp(-(v + 40[mV])/8[mV]));\n"
+        "    }\n"
+        "    initial h = 1;\n"
+        "    evolve h' = (minf(v) - h)/1[ms];\n"
+        "    effect current_density = gbar*minf(v)*h*v;\n"
+        "    export gbar;\n"
+        "}";
+
+    auto m_printable = make_printable(mech);
+
+    // The exponential is computed by advance_state and init, and loaded by compute_currents.
+    EXPECT_EQ(std::vector<std::string>{"_cache0"}, m_printable.field_pack.cache_sources);
+    EXPECT_EQ(2u, m_printable.procedure_pack.initializations.size());
+    auto stored = std::count_if(m_printable.evolve_write_map.begin(), m_printable.evolve_write_map.end(),
+                                [](const auto& w) {return w.second.pointer_name == "_pp__cache0";});
+    EXPECT_EQ(1, stored);
+    EXPECT_EQ(1u, m_printable.effect_read_map.count("_cache0"));
+    for (const auto& e: m_printable.procedure_pack.effects) {
+        EXPECT_EQ(std::string::npos, pretty_print(e).find("exp"));
+    }
+}
+
+TEST(printable_mechanism, constant_record_parameters) {
+    std::string mech =
+        "mechanism density \"folded\" {\n"
+        "    parameter gbar = 0.1 [S/cm^2];\n"
+        "    parameter r = { a = 1 [mV]; b = 2 [mV]; };\n"
+        "    bind v = membrane_potential;\n"
+        "    effect current_density = gbar*(v - r.a - r.b);\n"
+        "    export gbar;\n"
+        "}";
+
+    // The fields of a constant record parameter that isn't exported fold to
+    // literals: it has no storage and isn't read by the kernels.
+    auto m = make_printable(mech);
+    ASSERT_EQ(1u, m.field_pack.param_sources.size());
+    EXPECT_EQ("gbar", std::get<0>(m.field_pack.param_sources.front()));
+    for (const auto& [name, storage]: m.pointer_map) {
+        EXPECT_EQ(std::string::npos, name.find("_r_")) << name;
+    }
+    for (const auto& e: m.procedure_pack.effects) {
+        EXPECT_EQ(std::string::npos, pretty_print(e).find("_r_"));
+    }
+
+    // Exported, it is stored per instance, field by field.
+    auto exported = make_printable(std::string(mech).insert(mech.rfind('}'), "    export r;\n"));
+    EXPECT_EQ(3u, exported.field_pack.param_sources.size());
+    EXPECT_EQ(1u, exported.pointer_map.count("_r_a"));
+}
+
+TEST(printable_mechanism, global_parameters) {
+    std::string mech =
+        "mechanism density \"global\" {\n"
+        "    parameter gbar = 0.1 [S/cm^2];\n"
+        "    parameter g2 = 2*gbar;\n"
+        "    parameter r = { a = 1 [mV]; b = 2 [mV]; };\n"
+        "    bind v = membrane_potential;\n"
+        "    effect current_density = g2*(v - r.a - r.b);\n"
+        "    export gbar;\n"
+        "    export r;\n"
+        "}";
+
+    // A global parameter is stored once, and is uniform.
+    auto m = make_printable(mech, {}, {"gbar"});
+    ASSERT_EQ(1u, m.field_pack.global_sources.size());
+    EXPECT_EQ("gbar", std::get<0>(m.field_pack.global_sources.front()));
+    EXPECT_DOUBLE_EQ(1000, std::get<1>(m.field_pack.global_sources.front()));
+    for (const auto& p: m.field_pack.param_sources) {
+        EXPECT_NE("gbar", std::get<0>(p));
+    }
+    EXPECT_EQ(printable_mechanism::storage_class::global, m.pointer_map.at("gbar").pointer_kind);
+    EXPECT_TRUE(m.uniform_sources.count("gbar"));
+
+    // Parameters computed from others, records and unknown names can't be global.
+    EXPECT_THROW(make_printable(mech, {}, {"g2"}), std::runtime_error);
+    EXPECT_THROW(make_printable(mech, {}, {"r"}), std::runtime_error);
+    EXPECT_THROW(make_printable(mech, {}, {"v"}), std::runtime_error);
+    EXPECT_THROW(make_printable(mech, {}, {"gbar2"}), std::runtime_error);
+}
+
+TEST(uniformity, classify_variability) {
+    auto m = solve_mechanism(q10);
+    auto evolve = m.evolutions.front();
+
+    variability_map vars = {{"temp", variability::uniform}, {"v", variability::per_node}};
+    EXPECT_EQ(variability::per_instance, classify_variability(evolve, vars));
+
+    // q10 is uniform, the steady state depends on the node, the update on the state.
+    bool found_pow = false, found_exp = false;
+    for (auto e = as_resolved_evolve(evolve)->value; auto let = as_resolved_let(e); e = let->body) {
+        auto value = let->id_value();
+        if (auto b = as_resolved_binary(value); b && b->op == binary_op::pow) {
+            EXPECT_EQ(variability::uniform, vars.at(let->id_name()));
+            found_pow = true;
+        }
+        if (auto u = as_resolved_unary(value); u && u->op == unary_op::exp) {
+            EXPECT_EQ(variability::per_node, vars.at(let->id_name()));
+            found_exp = true;
+        }
+    }
+    EXPECT_TRUE(found_pow);
+    EXPECT_TRUE(found_exp);
+
+    // Without annotation, the temperature is assumed to vary per instance.
+    vars = {};
+    classify_variability(evolve, vars);
+    for (const auto& [name, v]: vars) {
+        EXPECT_EQ(variability::per_instance, v) << name;
+    }
+}
+
+TEST(uniformity, hoist_uniform) {
+    auto contains_pow = [](const r_expr& e) {
+        for (auto x = e; auto let = as_resolved_let(x); x = let->body) {
+            auto b = as_resolved_binary(let->id_value());
+            if (b && b->op == binary_op::pow) return true;
+        }
+        return false;
+    };
+    {
+        auto m = make_printable(q10);
+        EXPECT_TRUE(m.uniform_sources.empty());
+        EXPECT_TRUE(m.prologue_pack.evolutions.empty());
+        EXPECT_TRUE(contains_pow(as_resolved_evolve(m.procedure_pack.evolutions.front())->value));
+    }
+    {
+        // q10 is computed once, ahead of the loop over the instances.
+        auto m = make_printable(q10, {"temp", "gbar"});
+        EXPECT_EQ((std::unordered_set<std::string>{"temp", "gbar"}), m.uniform_sources);
+        ASSERT_EQ(3u, m.prologue_pack.evolutions.size());
+        EXPECT_TRUE(contains_pow(m.prologue_pack.evolutions.back()));
+        EXPECT_FALSE(contains_pow(as_resolved_evolve(m.procedure_pack.evolutions.front())->value));
+
+        // Nothing in the effect is shared by all instances: gbar multiplies the state.
+        EXPECT_TRUE(m.prologue_pack.effects.empty());
+    }
+}
+
+TEST(linearity, classify_linearity) {
+    auto loc = src_location{};
+    auto real = make_rtype<resolved_quantity>(quantity::real, loc);
+    auto x = make_rexpr<resolved_argument>("x", real, loc);
+    auto y = make_rexpr<resolved_argument>("y", real, loc);
+    auto c = make_rexpr<resolved_argument>("c", real, loc);
+    auto num = [&](double v) {return make_rexpr<resolved_float>(v, real, loc);};
+    auto bin = [&](binary_op op, const r_expr& lhs, const r_expr& rhs) {
+        return make_rexpr<resolved_binary>(op, lhs, rhs, loc);
+    };
+    auto classify = [](const r_expr& e) {
+        linearity_map vars = {{"x", linearity::linear}, {"y", linearity::linear}};
+        return classify_linearity(e, vars);
+    };
+
+    EXPECT_EQ(linearity::constant,  classify(bin(binary_op::mul, c, num(2))));
+    EXPECT_EQ(linearity::linear,    classify(bin(binary_op::add, bin(binary_op::mul, x, c), bin(binary_op::div, y, num(2)))));
+    EXPECT_EQ(linearity::linear,    classify(make_rexpr<resolved_unary>(unary_op::neg, x, loc)));
+    EXPECT_EQ(linearity::nonlinear, classify(bin(binary_op::add, x, num(1))));
+    EXPECT_EQ(linearity::nonlinear, classify(bin(binary_op::mul, x, y)));
+    EXPECT_EQ(linearity::nonlinear, classify(bin(binary_op::div, c, x)));
+    EXPECT_EQ(linearity::nonlinear, classify(make_rexpr<resolved_unary>(unary_op::exp, x, loc)));
+
+    auto cond = bin(binary_op::lt, x, num(0));
+    EXPECT_EQ(linearity::nonlinear, classify(make_rexpr<resolved_conditional>(cond, x, y, real, loc)));
+
+    // Let-bound values are classified once, and recorded.
+    auto x2 = make_rexpr<resolved_variable>("x2", bin(binary_op::mul, x, num(2)), real, loc);
+    auto let = make_rexpr<resolved_let>(x2, bin(binary_op::sub, x2, y), real, loc);
+    linearity_map vars = {{"x", linearity::linear}, {"y", linearity::linear}};
+    EXPECT_EQ(linearity::linear, classify_linearity(let, vars));
+    EXPECT_EQ(linearity::linear, vars.at("x2"));
+}
+
+TEST(linearity, is_linear) {
+    auto mech = [](const std::string& evolve, const std::string& on_event) {
+        return
+            "mechanism point \"syn\" {\n"
+            "    parameter tau = 2.0 [ms];\n"
+            "    state g: conductance;\n"
+            "    bind v = membrane_potential;\n"
+            "    initial g = 0 [S];\n"
+            "    effect current = g*(v - 10[mV]);\n"
+            "    evolve g' = " + evolve + ";\n"
+            "    on_event(w:conductance) g = " + on_event + ";\n"
+            "}";
+    };
+    // expsyn: linear and homogeneous in the state and the weight.
+    EXPECT_TRUE(make_printable(mech("-g/tau", "g + w")).is_linear);
+    EXPECT_TRUE(make_printable(mech("-g/tau", "g + 2*w")).is_linear);
+
+    // Affine updates, products of states or weights, and non-linear functions aren't.
+    EXPECT_FALSE(make_printable(mech("(1[S] - g)/tau", "g + w")).is_linear);
+    EXPECT_FALSE(make_printable(mech("-g/tau", "g + 1[S]")).is_linear);
+    EXPECT_FALSE(make_printable(mech("-g/tau", "g + w*w/1[S]")).is_linear);
+    EXPECT_FALSE(make_printable(mech("-g/tau", "max(g + w, 1[S])")).is_linear);
+    EXPECT_FALSE(make_printable(mech("-g*g/(tau*1[S])", "g + w")).is_linear);
+}
@@ -0,0 +1,254 @@
+#include <limits>
+#include <string>
+
+#include <arblang/printer/print_expressions.hpp>
+#include <arblang/printer/print_header.hpp>
+#include <arblang/printer/print_mechanism.hpp>
+#include <arblang/printer/printer_options.hpp>
+
+#include "../gtest.h"
+#include "pipeline.hpp"
+
+using namespace al;
+using namespace resolved_ir;
+
+static bool contains(const std::string& s, const std::string& sub) {
+    return s.find(sub) != std::string::npos;
+}
+
+static const char* expsyn =
+    "mechanism point \"expsyn\" {\n"
+    "    parameter tau = 2.0 [ms];\n"
+    "    parameter e   = 0   [mV];\n"
+    "    state g: conductance;\n"
+    "    bind v = membrane_potential;\n"
+    "    initial g = 0 [S];\n"
+    "    effect current = g*(v-e);\n"
+    "    evolve g' = -g/tau;\n"
+    "    on_event(w:conductance) g = g + w;\n"
+    "    export tau;\n"
+    "    export e;\n"
+    "}";
+
+TEST(printer, apply_events) {
+    auto m = make_printable(expsyn);
+    {
+        // The events of the mechanism are found among those of other
+        // mechanisms by testing the id of each event.
+        auto printed = print_mechanism(m, "ns").str();
+        EXPECT_TRUE(contains(printed, "if (p->mech_id != _pp_sim_mechanism_id) {"));
+        EXPECT_FALSE(contains(printed, "equal_range"));
+        EXPECT_FALSE(contains(printed, "independent_targets_"));
+    }
+    {
+        // Batches of events are applied at once only if they all are events
+        // of the mechanism with distinct targets.
+        printer_options opt;
+        opt.simd = true;
+        auto printed = print_mechanism(m, "ns", opt).str();
+        EXPECT_TRUE(contains(printed, "independent_targets_(p, _pp_sim_mechanism_id)"));
+        EXPECT_TRUE(contains(printed, "if (p[k_].mech_id != id || p[k_].mech_index <= p[k_-1].mech_index) return false;"));
+        EXPECT_TRUE(contains(printed, "if (p->mech_id != _pp_sim_mechanism_id) {"));
+        EXPECT_FALSE(contains(printed, "equal_range"));
+    }
+}
+
+TEST(printer, header_is_linear) {
+    auto printed = print_header(make_printable(expsyn), "ns").str();
+    EXPECT_TRUE(contains(printed, "result.is_linear=true;"));
+
+    std::string saturating = expsyn;
+    saturating.replace(saturating.find("g = g + w;"), 10, "g = min(g + w, 1[uS]);");
+    printed = print_header(make_printable(saturating), "ns").str();
+    EXPECT_TRUE(contains(printed, "result.is_linear=false;"));
+}
+
+TEST(printer, header_parameter_defaults) {
+    // A parameter computed from others has no default value.
+    std::string mech =
+        "mechanism density \"defaults\" {\n"
+        "    parameter gbar = 0.001 [S/cm^2];\n"
+        "    parameter g2 = 2*gbar;\n"
+        "    bind v = membrane_potential;\n"
+        "    effect current_density = g2*v;\n"
+        "    export gbar;\n"
+        "}";
+    auto printed = print_header(make_printable(mech), "ns").str();
+    EXPECT_TRUE(contains(printed, "{\"gbar\", \"m^-4*Kg^-1*s^3*A^2\", 10, 1e-9, 1e9}"));
+    EXPECT_TRUE(contains(printed, "{\"g2\", \"m^-4*Kg^-1*s^3*A^2\", NAN, 1e-9, 1e9}"));
+    EXPECT_FALSE(contains(printed, "nan"));
+}
+
+TEST(printer, header_cached_values) {
+    // The values cached by advance_state are listed after the states, marked
+    // internal, under a name that no state can have.
+    std::string mech =
+        "mechanism density \"shared\" {\n"
+        "    parameter gbar = 0.1 [S/cm^2];\n"
+        "    bind v = membrane_potential;\n"
+        "    state h: real;\n"
+        "    function minf(v: voltage): real {\n"
+        "        1/(1 + exp(-(v + 40[mV])/8[mV]));\n"
+        "    }\n"
+        "    initial h = 1;\n"
+        "    evolve h' = (minf(v) - h)/1[ms];\n"
+        "    effect current_density = gbar*minf(v)*h*v;\n"
+        "    export gbar;\n"
+        "}";
+    auto printed = print_header(make_printable(mech), "ns").str();
+    EXPECT_TRUE(contains(printed, "        {\"h\", \"\", NAN, 1e-9, 1e9}, \n"
+                                  "        // Internal: values stored by advance_state for compute_currents, not to be probed.\n"
+                                  "        {\"_cache0\", \"\", NAN, 1e-9, 1e9}, \n"
+                                  "    };\n"
+                                  "    static arb_size_type n_state_vars = 2;\n"));
+
+    printed = print_header(make_printable(expsyn), "ns").str();
+    EXPECT_FALSE(contains(printed, "Internal"));
+}
+
+TEST(printer, segmented_writes) {
+    auto m = make_printable(expsyn);
+    {
+        // By default, every instance updates its node.
+        auto printed = print_mechanism(m, "ns").str();
+        EXPECT_FALSE(contains(printed, "_acc"));
+        EXPECT_TRUE(contains(printed, "_pp__effect_i[_nidx] = fma(1000000000*_pp_sim_weight[i_], "));
+    }
+    {
+        // The contributions are summed while the next instance is on the same node.
+        printer_options opt;
+        opt.segmented_writes = true;
+        auto printed = print_mechanism(m, "ns", opt).str();
+        EXPECT_TRUE(contains(printed, "arb_value_type _pp__effect_i_acc = 0;"));
+        EXPECT_TRUE(contains(printed, "if (i_+1 == _pp_sim_width || _pp_sim_node_index[i_+1] != _nidx) {"));
+        EXPECT_TRUE(contains(printed, "_pp__effect_i[_nidx] += _pp__effect_i_acc;"));
+    }
+}
+
+TEST(printer, vectorize_hints) {
+    auto m = make_printable(expsyn);
+    {
+        auto printed = print_mechanism(m, "ns").str();
+        EXPECT_TRUE(contains(printed, "[[maybe_unused]] auto* _pp_tau = pp->parameters[0];\\\n"));
+        EXPECT_FALSE(contains(printed, "__restrict__"));
+        EXPECT_FALSE(contains(printed, "#pragma omp simd"));
+    }
+    {
+        // The parameters and states are unaliased and aligned, and the loops
+        // of the kernels that don't write to the nodes are marked independent.
+        printer_options opt;
+        opt.vectorize_hints = true;
+        auto printed = print_mechanism(m, "ns", opt).str();
+        EXPECT_TRUE(contains(printed, "[[maybe_unused]] auto* __restrict__ _pp_tau = "
+                                      "static_cast<arb_value_type*>(__builtin_assume_aligned(pp->parameters[0], min_align_));\\\n"));
+        EXPECT_TRUE(contains(printed, "[[maybe_unused]] auto* __restrict__ _pp_g = "
+                                      "static_cast<arb_value_type*>(__builtin_assume_aligned(pp->state_vars[0], min_align_));\\\n"));
+        EXPECT_TRUE(contains(printed, "    #pragma omp simd\n"
+                                      "    for (arb_size_type i_ = 0; i_ < _pp_sim_width; ++i_) {\n"));
+        EXPECT_TRUE(contains(printed, "static constexpr unsigned min_align_ = "));
+    }
+}
+
+TEST(printer, simd) {
+    std::string mech =
+        "mechanism density \"rect\" {\n"
+        "    parameter e = -65 [mV];\n"
+        "    state s: real;\n"
+        "    bind v = membrane_potential;\n"
+        "    initial s = if v > e then exp(v/1[mV]) else 0.1;\n"
+        "    evolve s' = (1 - s)/2[ms];\n"
+        "    effect current_density = 0.1[S/cm^2]*s*(v-e);\n"
+        "}";
+    printer_options opt;
+    opt.simd = true;
+    auto printed = print_mechanism(make_printable(mech), "ns", opt).str();
+
+    EXPECT_TRUE(contains(printed, "#include <arbor/simd/simd.hpp>"));
+    EXPECT_TRUE(contains(printed, "static constexpr unsigned simd_width_ = S::simd_abi::native_width<arb_value_type>::value;"));
+
+    // Conditionals are masked assignments, math functions are those of the SIMD library.
+    EXPECT_TRUE(contains(printed, "S::where(simd_mask("));
+    EXPECT_TRUE(contains(printed, "S::exp(simd_value("));
+    EXPECT_FALSE(contains(printed, " ? "));
+
+    // Node-indexed values are gathered and scattered, instance values are loaded and stored.
+    EXPECT_TRUE(contains(printed, "simd_value v; assign(v, indirect(_pp_v, _nidx, simd_width_, index_constraint::none));"));
+    EXPECT_TRUE(contains(printed, "simd_value s; assign(s, indirect(_pp_s + i_, simd_width_));"));
+    EXPECT_TRUE(contains(printed, "indirect(_pp_s + i_, simd_width_) = simd_value("));
+}
+
+TEST(printer, index_constraint_partitions) {
+    printer_options opt;
+    opt.simd = true;
+    auto printed = print_mechanism(make_printable(expsyn), "ns", opt).str();
+
+    // Kernels touching node-indexed values have a loop per class of the partition.
+    for (std::string c: {"contiguous", "constant", "independent", "none"}) {
+        EXPECT_TRUE(contains(printed, "for (arb_size_type p_ = 0; p_ < _pp_sim_index_constraints.n_" + c + "; ++p_) {\n"
+                                      "       arb_size_type i_ = _pp_sim_index_constraints." + c + "[p_];\n"));
+    }
+    // Contiguous batches are loaded and stored directly, constant batches access
+    // a single node, and the others are gathered and scattered.
+    EXPECT_TRUE(contains(printed, "simd_value v; assign(v, indirect(_pp_v + _nidx, simd_width_));"));
+    EXPECT_TRUE(contains(printed, "simd_value v(_pp_v[_nidx]);"));
+    EXPECT_TRUE(contains(printed, "simd_value v; assign(v, indirect(_pp_v, _nidx, simd_width_, index_constraint::independent));"));
+    EXPECT_TRUE(contains(printed, "simd_value v; assign(v, indirect(_pp_v, _nidx, simd_width_, index_constraint::none));"));
+    EXPECT_TRUE(contains(printed, "_pp__effect_i[_nidx] += S::reduce("));
+    EXPECT_TRUE(contains(printed, "indirect(_pp__effect_i, _nidx, simd_width_, index_constraint::none) += "));
+
+    // The other kernels run over the instances, with a scalar loop for the remainder.
+    EXPECT_TRUE(contains(printed, "arb_size_type _simd_end = _pp_sim_width - _pp_sim_width%simd_width_;"));
+}
+
+TEST(printer, uniform_prologue) {
+    std::string mech =
+        "mechanism density \"q10\" {\n"
+        "    bind v = membrane_potential;\n"
+        "    bind temp = temperature;\n"
+        "    state m: real;\n"
+        "    initial m = 0;\n"
+        "    evolve m' = (exp(v/10[mV]) - m)*3^((temp - 6.3[K])/10[K])/1[ms];\n"
+        "    effect current_density = 0.1[S/cm^2]*m*(v + 65[mV]);\n"
+        "}";
+    {
+        auto printed = print_mechanism(make_printable(mech), "ns").str();
+        EXPECT_FALSE(contains(printed, "// Compute values shared by all instances"));
+    }
+    {
+        // The temperature is read from the node of the first instance, and q10
+        // computed from it, before the loop over the instances.
+        auto printed = print_mechanism(make_printable(mech, {"temp"}), "ns").str();
+        auto prologue = printed.find("    if (!_pp_sim_width) return;\n"
+                                     "    // Compute values shared by all instances\n"
+                                     "    auto temp = _pp_temp[_pp_sim_node_index[0]];\n");
+        auto q10 = printed.find("    auto _t5 = pow(3.0, _t4);\n");
+        auto loop = printed.find("for (arb_size_type i_ = 0; i_ < _pp_sim_width; ++i_)", prologue);
+        ASSERT_NE(std::string::npos, prologue);
+        ASSERT_NE(std::string::npos, q10);
+        EXPECT_LT(prologue, q10);
+        EXPECT_LT(q10, loop);
+        EXPECT_FALSE(contains(printed, "auto temp = _pp_temp[_nidx]"));
+    }
+}
+
+TEST(printer, double_literals) {
+    // Folded constants are printed with all the digits needed to read back
+    // the same double, in the kernels and in the initial values.
+    std::string mech =
+        "mechanism density \"lit\" {\n"
+        "    state s: real;\n"
+        "    initial s = 1/0.018;\n"
+        "    evolve s' = -s*(1/0.018)/1[ms];\n"
+        "}";
+    auto printed = print_mechanism(make_printable(mech), "ns").str();
+    EXPECT_TRUE(contains(printed, "_pp_s[i_] = 55.55555555555556;"));
+    EXPECT_TRUE(contains(printed, " * 55.55555555555556;"));
+    EXPECT_FALSE(contains(printed, "55.5556;"));
+
+    EXPECT_EQ(1/0.018, std::stod(double_literal(1/0.018)));
+    EXPECT_EQ("2.0", double_literal(2));
+    EXPECT_EQ("1e+300", double_literal(1e300));
+    EXPECT_EQ("std::numeric_limits<double>::infinity()", double_literal(std::numeric_limits<double>::infinity()));
+    EXPECT_EQ("(-std::numeric_limits<double>::infinity())", double_literal(-std::numeric_limits<double>::infinity()));
+    EXPECT_EQ("std::numeric_limits<double>::quiet_NaN()", double_literal(std::numeric_limits<double>::quiet_NaN()));
+}
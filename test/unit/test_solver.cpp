@@ -0,0 +1,258 @@
+#include <cmath>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <arblang/solver/solve.hpp>
+#include <arblang/solver/solve_ode.hpp>
+#include <arblang/util/pretty_printer.hpp>
+
+#include "../gtest.h"
+#include "pipeline.hpp"
+
+using namespace al;
+using namespace resolved_ir;
+
+// The value of a scalar or record expression, by field name.
+// A scalar value has a single, empty, field name.
+using value = std::map<std::string, double>;
+
+// Evaluates the update of a state, given the values of the arguments: `dt`,
+// and the state or the fields of the state as `state.field`.
+struct evaluator {
+    std::unordered_map<std::string, double> args;
+    std::unordered_map<r_expr, value> memo;
+
+    double scalar(const r_expr& e) {
+        return (*this)(e).at("");
+    }
+
+    value operator()(const r_expr& e) {
+        if (memo.count(e)) return memo.at(e);
+        auto v = eval(e);
+        memo[e] = v;
+        return v;
+    }
+
+    value eval(const r_expr& e) {
+        if (auto f = as_resolved_float(e)) return {{"", f->value}};
+        if (auto i = as_resolved_int(e)) return {{"", double(i->value)}};
+        if (auto v = as_resolved_variable(e)) return (*this)(v->value);
+        if (auto l = as_resolved_let(e)) return (*this)(l->body);
+        if (auto f = as_resolved_field_access(e)) return {{"", (*this)(f->object).at(f->field)}};
+        if (auto a = as_resolved_argument(e)) {
+            if (args.count(a->name)) return {{"", args.at(a->name)}};
+            value rec;
+            for (const auto& [name, v]: args) {
+                if (name.rfind(a->name + ".", 0) == 0) rec[name.substr(a->name.size()+1)] = v;
+            }
+            return rec;
+        }
+        if (auto o = as_resolved_object(e)) {
+            value rec;
+            for (const auto& f: o->record_fields) {
+                auto v = as_resolved_variable(f);
+                rec[v->name] = scalar(v->value);
+            }
+            return rec;
+        }
+        if (auto c = as_resolved_conditional(e)) {
+            return scalar(c->condition)? (*this)(c->value_true): (*this)(c->value_false);
+        }
+        if (auto u = as_resolved_unary(e)) {
+            auto x = scalar(u->arg);
+            switch (u->op) {
+                case unary_op::exp: return {{"", std::exp(x)}};
+                case unary_op::log: return {{"", std::log(x)}};
+                case unary_op::neg: return {{"", -x}};
+                default: break;
+            }
+        }
+        if (auto b = as_resolved_binary(e)) {
+            auto x = scalar(b->lhs), y = scalar(b->rhs);
+            switch (b->op) {
+                case binary_op::add: return {{"", x + y}};
+                case binary_op::sub: return {{"", x - y}};
+                case binary_op::mul: return {{"", x * y}};
+                case binary_op::div: return {{"", x / y}};
+                case binary_op::pow: return {{"", std::pow(x, y)}};
+                default: break;
+            }
+        }
+        throw std::runtime_error("unexpected expression in state update: " + pretty_print(e));
+    }
+};
+
+// The solved update of `state`.
+static r_expr solved_update(const std::string& mech, const std::string& state, const solver_options& opt = {}) {
+    auto m = solve_mechanism(mech, opt);
+    for (const auto& e: m.evolutions) {
+        auto evolve = as_resolved_evolve(e);
+        if (as_resolved_argument(evolve->identifier)->name == state) return evolve->value;
+    }
+    throw std::runtime_error("no evolution of " + state);
+}
+
+TEST(solver, check_options) {
+    std::string mech =
+        "mechanism density \"schemes\" {\n"
+        "    record state_rec { m: real, h: real, };\n"
+        "    state s: state_rec;\n"
+        "    state x: real;\n"
+        "    initial s = state_rec { m = 0; h = 1; };\n"
+        "    initial x = 0;\n"
+        "    evolve s' = state_rec' { m' = -s.m/1[ms]; h' = -s.h/1[ms]; };\n"
+        "    evolve x' = -x/1[ms];\n"
+        "}";
+    auto p = parser(mech);
+    auto m = resolve(normalize(p.parse_mechanism()));
+
+    solver_options opt;
+    opt.state_schemes = {{"s", ode_scheme::cnexp}, {"s.h", ode_scheme::euler}, {"x", ode_scheme::pade_22}};
+    EXPECT_NO_THROW(check_solver_options(m, opt));
+
+    for (std::string name: {"y", "s.n", "x.m"}) {
+        opt.state_schemes = {{name, ode_scheme::euler}};
+        EXPECT_THROW(check_solver_options(m, opt), std::runtime_error);
+    }
+
+    opt.state_schemes = {};
+    opt.newton_iterations = 0;
+    EXPECT_THROW(check_solver_options(m, opt), std::runtime_error);
+}
+
+TEST(solver, relaxation) {
+    // With E(t) the approximation of exp(t) of each scheme, the updates are:
+    //   x' = (2 - x)/tau: x = 2 + (x - 2)*E(-dt/tau)   (relaxation)
+    //   y' = (y + y)/tau: y = y*E(2*dt/tau)            (x' = a*x)
+    //   z' = (1 + z)/tau: z = -1 + (z + 1)*E(dt/tau)   (x' = a*x + b)
+    std::string mech =
+        "mechanism density \"relax\" {\n"
+        "    state x: real;\n"
+        "    state y: real;\n"
+        "    state z: real;\n"
+        "    initial x = 0;\n"
+        "    initial y = 0;\n"
+        "    initial z = 0;\n"
+        "    evolve x' = (2 - x)/4[ms];\n"
+        "    evolve y' = (y + y)/4[ms];\n"
+        "    evolve z' = (1 + z)/4[ms];\n"
+        "}";
+
+    const double dt = 1e-4, tau = 4e-3;
+    auto E = [](ode_scheme scheme, double t) {
+        switch (scheme) {
+            case ode_scheme::cnexp:          return std::exp(t);
+            case ode_scheme::pade_11:        return (1 + t/2)/(1 - t/2);
+            case ode_scheme::pade_22:        return (12 + 6*t + t*t)/(12 - 6*t + t*t);
+            case ode_scheme::euler:          return 1 + t;
+            case ode_scheme::backward_euler: return 1/(1 - t);
+        }
+        return 0.;
+    };
+
+    for (auto scheme: {ode_scheme::cnexp, ode_scheme::pade_11, ode_scheme::pade_22, ode_scheme::euler, ode_scheme::backward_euler}) {
+        SCOPED_TRACE(to_string(scheme));
+        solver_options opt;
+        opt.scheme = scheme;
+
+        evaluator eval;
+        eval.args = {{"dt", dt}, {"x", 0.5}, {"y", 0.3}, {"z", 0.7}};
+        EXPECT_NEAR(2 + (0.5 - 2)*E(scheme, -dt/tau), eval.scalar(solved_update(mech, "x", opt)), 1e-14);
+        EXPECT_NEAR(0.3*E(scheme, 2*dt/tau),          eval.scalar(solved_update(mech, "y", opt)), 1e-14);
+        EXPECT_NEAR(-1 + (0.7 + 1)*E(scheme, dt/tau), eval.scalar(solved_update(mech, "z", opt)), 1e-14);
+    }
+}
+
+TEST(solver, coupled) {
+    // s' = J*s, with J = [[-3, 2], [3, -2]]/1[ms]
+    std::string mech =
+        "mechanism density \"coupled\" {\n"
+        "    record state_rec { c: real, o: real, };\n"
+        "    state s: state_rec;\n"
+        "    initial s = state_rec { c = 1; o = 0; };\n"
+        "    evolve s' = state_rec' {\n"
+        "        c' = (2*s.o - 3*s.c)/1[ms];\n"
+        "        o' = (3*s.c - 2*s.o)/1[ms];\n"
+        "    };\n"
+        "}";
+
+    const double dt = 1e-4, c = 0.8, o = 0.2;
+    const double J[2][2] = {{-3e3, 2e3}, {3e3, -2e3}};
+    const double f[2] = {J[0][0]*c + J[0][1]*o, J[1][0]*c + J[1][1]*o};
+
+    // The update x + dx, with dx the solution of (I - h*J)*dx = dt*f(x).
+    auto implicit = [&](double h) {
+        double a = 1 - h*J[0][0], b = -h*J[0][1], d = -h*J[1][0], e = 1 - h*J[1][1];
+        double det = a*e - b*d;
+        return value{{"c", c + dt*(e*f[0] - b*f[1])/det}, {"o", o + dt*(a*f[1] - d*f[0])/det}};
+    };
+
+    std::vector<std::pair<ode_scheme, value>> expected = {
+        {ode_scheme::pade_11,        implicit(dt/2)},
+        {ode_scheme::backward_euler, implicit(dt)},
+        {ode_scheme::euler,          {{"c", c + dt*f[0]}, {"o", o + dt*f[1]}}},
+    };
+    for (const auto& [scheme, x]: expected) {
+        SCOPED_TRACE(to_string(scheme));
+        solver_options opt;
+        opt.scheme = scheme;
+
+        evaluator eval;
+        eval.args = {{"dt", dt}, {"s.c", c}, {"s.o", o}};
+        auto s = eval(solved_update(mech, "s", opt));
+        EXPECT_NEAR(x.at("c"), s.at("c"), 1e-14);
+        EXPECT_NEAR(x.at("o"), s.at("o"), 1e-14);
+    }
+
+    // The coupled system has no closed form.
+    solver_options opt;
+    opt.scheme = ode_scheme::cnexp;
+    EXPECT_THROW(solve_mechanism(mech, opt), std::runtime_error);
+}
+
+TEST(solver, newton) {
+    // x' = f(x) = -x*x/1[ms], with f'(x) = -2*x/1[ms]
+    std::string mech =
+        "mechanism density \"newton\" {\n"
+        "    state x: real;\n"
+        "    initial x = 1;\n"
+        "    evolve x' = -x*x/1[ms];\n"
+        "}";
+
+    const double dt = 1e-4, x = 0.5;
+    auto f  = [](double y) {return -1e3*y*y;};
+    auto df = [](double y) {return -2e3*y;};
+
+    // Newton iterations on the residual of the implicit scheme, starting from y = x:
+    //   (1 - h*f'(y))*dy = x - y + h*(f(y) + f(x))   (Crank-Nicolson, h = dt/2)
+    //   (1 - h*f'(y))*dy = x - y + h*f(y)            (backward Euler, h = dt)
+    auto newton = [&](ode_scheme scheme, unsigned iterations) {
+        bool crank_nicolson = scheme == ode_scheme::pade_11;
+        double h = crank_nicolson? dt/2: dt;
+        double y = x;
+        for (unsigned k = 0; k < iterations; ++k) {
+            double f_sum = crank_nicolson? f(y) + f(x): f(y);
+            y += (x - y + h*f_sum)/(1 - h*df(y));
+        }
+        return y;
+    };
+
+    for (auto scheme: {ode_scheme::pade_11, ode_scheme::backward_euler}) {
+        for (unsigned iterations: {1u, 2u}) {
+            SCOPED_TRACE(to_string(scheme) + ", " + std::to_string(iterations) + " iterations");
+            solver_options opt;
+            opt.scheme = scheme;
+            opt.newton_iterations = iterations;
+
+            evaluator eval;
+            eval.args = {{"dt", dt}, {"x", x}};
+            EXPECT_NEAR(newton(scheme, iterations), eval.scalar(solved_update(mech, "x", opt)), 1e-14);
+        }
+    }
+
+    solver_options opt;
+    opt.newton_iterations = 0;
+    EXPECT_THROW(solve_mechanism(mech, opt), std::runtime_error);
+}
@@ -0,0 +1,71 @@
+#include <vector>
+
+#include <arblang/resolver/resolved_expressions.hpp>
+#include <arblang/resolver/resolved_types.hpp>
+#include <arblang/util/arena.hpp>
+#include <arblang/util/hash_cons.hpp>
+#include <arblang/util/pretty_printer.hpp>
+
+#include "../gtest.h"
+
+using namespace al;
+using namespace resolved_ir;
+using namespace resolved_type_ir;
+
+TEST(arena, allocation_counter) {
+    auto loc = src_location{};
+    allocation_counter counter;
+    auto real_type = make_rtype<resolved_quantity>(normalized_type(quantity::real), loc);
+    auto a = make_rexpr<resolved_argument>("a", real_type, loc);
+    auto b = make_rexpr<resolved_binary>(binary_op::add, a, make_rexpr<resolved_float>(1, real_type, loc), real_type, loc);
+
+    auto count = counter.count();
+    EXPECT_EQ(4u, count.nodes);
+    EXPECT_LE(3*sizeof(resolved_expr) + sizeof(resolved_type), count.bytes);
+
+    // Nodes outlive the counter and the chunk of their pass.
+    counter.reset();
+    EXPECT_EQ(0u, counter.count().nodes);
+    std::vector<r_expr> nodes;
+    for (unsigned i = 0; i < 2000; ++i) {
+        nodes.push_back(make_rexpr<resolved_float>(i, real_type, loc));
+    }
+    EXPECT_EQ(2000u, counter.count().nodes);
+    EXPECT_EQ(1999., is_resolved_float(nodes.back())->value);
+    EXPECT_EQ("(argument a)", expand(is_resolved_binary(b)->lhs));
+}
+
+TEST(hash_cons, intern) {
+    auto loc = src_location{};
+    auto real_type = make_rtype<resolved_quantity>(normalized_type(quantity::real), loc);
+
+    auto a = make_rexpr<resolved_argument>("a", real_type, loc);
+    auto b = make_rexpr<resolved_argument>("b", real_type, loc);
+    auto one = make_rexpr<resolved_float>(1, real_type, loc);
+    auto t0 = make_rexpr<resolved_binary>(binary_op::add, a, one, loc);
+    auto t1 = make_rexpr<resolved_binary>(binary_op::add, make_rexpr<resolved_argument>("a", real_type, loc),
+                                          make_rexpr<resolved_float>(1, real_type, loc), loc);
+    auto t2 = make_rexpr<resolved_binary>(binary_op::add, b, one, loc);
+    auto t3 = make_rexpr<resolved_binary>(binary_op::mul, a, one, loc);
+
+    hash_cons table;
+    auto i0 = table.intern(t0);
+    auto i1 = table.intern(t1);
+    auto i2 = table.intern(t2);
+    auto i3 = table.intern(t3);
+    EXPECT_TRUE(i0 && i1 && i2 && i3);
+    EXPECT_EQ(i0, i1);
+    EXPECT_NE(i0, i2);
+    EXPECT_NE(i0, i3);
+
+    // Bound variables are interned as their values.
+    table.bind("x", i0.value());
+    table.bind("y", i1.value());
+    auto x = make_rexpr<resolved_variable>("x", t0, real_type, loc);
+    auto y = make_rexpr<resolved_variable>("y", t1, real_type, loc);
+    EXPECT_EQ(table.intern(make_rexpr<resolved_unary>(unary_op::exp, x, loc)),
+              table.intern(make_rexpr<resolved_unary>(unary_op::exp, y, loc)));
+
+    // Let-expressions aren't interned.
+    EXPECT_FALSE(table.intern(make_rexpr<resolved_let>("z", t0, x, real_type, loc)));
+}